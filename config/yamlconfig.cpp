@@ -56,12 +56,15 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
     __attribute__((unused)) std::string strTemp1, strTemp2, strTemp3, strTemp4;
     __attribute__((unused)) bool        boolTemp1, boolTemp2, boolTemp3, boolTemp4, boolTemp5, boolTemp6, boolTemp7;
     __attribute__((unused)) int         intTemp1, intTemp2, intTemp3, intTemp4, intTemp5, intTemp6;
-    __attribute__((unused)) double      doubleTemp1, doubleTemp2, doubleTemp3, doubleTemp4, doubleTemp5, doubleTemp6;
+    __attribute__((unused)) double      doubleTemp1, doubleTemp2, doubleTemp3, doubleTemp4, doubleTemp5, doubleTemp6,
+        doubleTemp7, doubleTemp8;
     __attribute__((unused)) std::vector<double> doubleVecTemp1;
+    __attribute__((unused)) std::vector<int>    intVecTemp1;
 
     // load work mode
     try {
-        strTemp1 = yamlConfigNode_["System"]["workMode"].as<std::string>();
+        strTemp1  = yamlConfigNode_["System"]["workMode"].as<std::string>();
+        boolTemp1 = yamlConfigNode_["System"]["enableBenchmark"].as<bool>();
     } catch (YAML::Exception &e) {
         std::cerr << termColor("red")
                   << "Failed to read work mode. Please check the path and format of the configuration file!"
@@ -70,7 +73,8 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
         return false;
     }
 
-    systemInfo.workMode = str2WorkMode(strTemp1);
+    systemInfo.workMode    = str2WorkMode(strTemp1);
+    systemInfo.isBenchmark = boolTemp1;
 
     // load file info
     try {
@@ -82,6 +86,7 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
         boolTemp5 = yamlConfigNode_["File"]["enableTOFResultSave"].as<bool>();
         boolTemp6 = yamlConfigNode_["File"]["enableBeamPatternResultSave"].as<bool>();
         boolTemp7 = yamlConfigNode_["File"]["enableSideAmpSpecResultSave"].as<bool>();
+        intTemp1  = yamlConfigNode_["File"]["diagnosticDecimation"].as<int>();
         // save to systemInfo
         systemInfo.savedFileInfo.isSaveGeneratedSignal = boolTemp1;
         systemInfo.savedFileInfo.isSaveAnalogInput     = boolTemp2;
@@ -90,6 +95,12 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
         systemInfo.savedFileInfo.isSaveTOFRes          = boolTemp5;
         systemInfo.savedFileInfo.isSaveBeamPattern     = boolTemp6;
         systemInfo.savedFileInfo.isSaveSideAmpSpec     = boolTemp7;
+        systemInfo.savedFileInfo.diagnosticDecimation  = intTemp1;
+        if (intTemp1 < 1) {
+            std::cerr << termColor("red") << "The diagnostic decimation must be >= 1" << termColor("nocolor")
+                      << std::endl;
+            return false;
+        }
 
     } catch (YAML::Exception &e) {
         std::cerr << termColor("red") << "Failed to read file enable parameter. Please check the file enable parameter"
@@ -153,6 +164,13 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
         systemInfo.signalInfo.partialSignalNum = (intTemp1 + 1) / 6;
         doubleTemp1                            = yamlConfigNode_["Signal"]["sampleRate"].as<double>();
         systemInfo.signalInfo.sampleRate       = doubleTemp1;
+        doubleTemp7 = yamlConfigNode_["Signal"]["taperRatio"].as<double>();
+        if (doubleTemp7 < 0 || doubleTemp7 > 1) {
+            std::cerr << termColor("red") << "The taperRatio should be between 0 and 1. Please check the signal info"
+                      << termColor("nocolor") << std::endl;
+            return false;
+        }
+        systemInfo.signalInfo.taperRatio = doubleTemp7;
         for (int i = 0; i < systemInfo.signalInfo.partialSignalNum; i++) {
             // load yaml
             strTemp1    = yamlConfigNode_["Signal"]["signalInfo"][i * 6].as<std::string>();
@@ -164,7 +182,7 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
             // save to systemInfo
             systemInfo.signalInfo.signalPartial.push_back(createPartialSignal(str2SignalType(strTemp1), doubleTemp1,
                                                                               doubleTemp2, doubleTemp3, doubleTemp4,
-                                                                              doubleTemp5, doubleTemp6));
+                                                                              doubleTemp5, doubleTemp6, doubleTemp7));
         }
 
     } catch (YAML::Exception &e) {
@@ -176,10 +194,20 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
 
     // load dataio info
     try {
-        strTemp1                                 = yamlConfigNode_["DataIO"]["outputSerialName"].as<std::string>();
-        strTemp2                                 = yamlConfigNode_["DataIO"]["outputSerialBaudrate"].as<std::string>();
+        strTemp1  = yamlConfigNode_["DataIO"]["outputSerialName"].as<std::string>();
+        strTemp2  = yamlConfigNode_["DataIO"]["outputSerialBaudrate"].as<std::string>();
+        intTemp1  = yamlConfigNode_["DataIO"]["outputQueueDepth"].as<int>();
+        intTemp2  = yamlConfigNode_["DataIO"]["outputWriteTimeout"].as<int>();
+        // save to systemInfo
         systemInfo.dataIOInfo.outputPortName     = strTemp1;
         systemInfo.dataIOInfo.outputPortBaudrate = strTemp2;
+        systemInfo.dataIOInfo.outputQueueDepth   = intTemp1;
+        systemInfo.dataIOInfo.outputWriteTimeout = intTemp2;
+        if (intTemp1 < 1 || intTemp2 < 1) {
+            std::cerr << termColor("red") << "The output queue depth and write timeout must be >= 1"
+                      << termColor("nocolor") << std::endl;
+            return false;
+        }
     } catch (YAML::Exception &e) {
         std::cerr << termColor("red") << "Failed to read dataio info. Please check the dataio info"
                   << termColor("nocolor") << std::endl;
@@ -190,12 +218,50 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
     // load tcp info
     try {
         // strTemp1 = yamlConfigNode_["TCP"]["serverIP"].as<std::string>();
-        intTemp1                          = yamlConfigNode_["TCP"]["serverPort"].as<int>();
-        intTemp2                          = yamlConfigNode_["TCP"]["connectTimeout"].as<int>();
-        intTemp3                          = yamlConfigNode_["TCP"]["sendTimeout"].as<int>();
-        systemInfo.tcpInfo.serverPort     = intTemp1;
-        systemInfo.tcpInfo.connectTimeout = intTemp2;
-        systemInfo.tcpInfo.sendTimeout    = intTemp3;
+        intTemp1                       = yamlConfigNode_["TCP"]["serverPort"].as<int>();
+        intTemp3                       = yamlConfigNode_["TCP"]["sendTimeout"].as<int>();
+        systemInfo.tcpInfo.serverPort  = intTemp1;
+        systemInfo.tcpInfo.sendTimeout = intTemp3;
+        // heartbeat
+        intTemp1 = yamlConfigNode_["TCP"]["heartbeatInterval"].as<int>();
+        intTemp2 = yamlConfigNode_["TCP"]["maxMissedHeartbeats"].as<int>();
+        // save to systemInfo
+        systemInfo.tcpInfo.heartbeatInterval   = intTemp1;
+        systemInfo.tcpInfo.maxMissedHeartbeats = intTemp2;
+        if (intTemp1 < 0 || intTemp2 < 1) {
+            std::cerr << termColor("red") << "The heartbeat interval must be >= 0 and the max missed heartbeats >= 1"
+                      << termColor("nocolor") << std::endl;
+            return false;
+        }
+        // multi-client streaming
+        intTemp1 = yamlConfigNode_["TCP"]["maxClients"].as<int>();
+        intTemp2 = yamlConfigNode_["TCP"]["clientQueueDepth"].as<int>();
+        strTemp1 = yamlConfigNode_["TCP"]["slowClientPolicy"].as<std::string>();
+        intTemp3 = yamlConfigNode_["TCP"]["sendBufferSize"].as<int>();
+        // save to systemInfo
+        systemInfo.tcpInfo.maxClients       = intTemp1;
+        systemInfo.tcpInfo.clientQueueDepth = intTemp2;
+        systemInfo.tcpInfo.slowClientPolicy = str2SlowClientPolicy(strTemp1);
+        systemInfo.tcpInfo.sendBufferSize   = intTemp3;
+        if (intTemp1 < 1 || intTemp2 < 1 || intTemp3 < 0 ||
+            systemInfo.tcpInfo.slowClientPolicy == SLOW_CLIENT_UNKNOWN) {
+            std::cerr << termColor("red")
+                      << "The max clients and client queue depth must be >= 1, the send buffer size >= 0 and the slow "
+                         "client policy SLOW_CLIENT_DROP or SLOW_CLIENT_DISCONNECT"
+                      << termColor("nocolor") << std::endl;
+            return false;
+        }
+        // product packet encoding
+        intTemp1 = yamlConfigNode_["TCP"]["encodeWorkers"].as<int>();
+        intTemp2 = yamlConfigNode_["TCP"]["compressionLevel"].as<int>();
+        // save to systemInfo
+        systemInfo.tcpInfo.encodeWorkerNum  = intTemp1;
+        systemInfo.tcpInfo.compressionLevel = intTemp2;
+        if (intTemp1 < 0 || intTemp2 < 1 || intTemp2 > 9) {
+            std::cerr << termColor("red") << "The encode workers must be >= 0 and the compression level 1~9"
+                      << termColor("nocolor") << std::endl;
+            return false;
+        }
     } catch (YAML::Exception &e) {
         std::cerr << termColor("red") << "Failed to read tcp info. Please check the tcp info" << termColor("nocolor")
                   << std::endl;
@@ -203,6 +269,83 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
         return false;
     }
 
+    // load udp info
+    try {
+        boolTemp1 = yamlConfigNode_["UDP"]["enableUDP"].as<bool>();
+        strTemp1  = yamlConfigNode_["UDP"]["multicastGroup"].as<std::string>();
+        intTemp1  = yamlConfigNode_["UDP"]["port"].as<int>();
+        intTemp2  = yamlConfigNode_["UDP"]["textPort"].as<int>();
+        strTemp2  = yamlConfigNode_["UDP"]["interfaceAddress"].as<std::string>();
+        intTemp3  = yamlConfigNode_["UDP"]["ttl"].as<int>();
+        boolTemp2 = yamlConfigNode_["UDP"]["enableLoopback"].as<bool>();
+        intTemp4  = yamlConfigNode_["UDP"]["telemetryInterval"].as<int>();
+        // save to systemInfo
+        systemInfo.udpInfo.isEnable          = boolTemp1;
+        systemInfo.udpInfo.group             = strTemp1;
+        systemInfo.udpInfo.port              = intTemp1;
+        systemInfo.udpInfo.textPort          = intTemp2;
+        systemInfo.udpInfo.interfaceAddress  = strTemp2;
+        systemInfo.udpInfo.ttl               = intTemp3;
+        systemInfo.udpInfo.isLoopback        = boolTemp2;
+        systemInfo.udpInfo.telemetryInterval = intTemp4;
+        if (intTemp1 < 1 || intTemp1 > 65535 || intTemp2 < 0 || intTemp2 > 65535 || intTemp3 < 0 || intTemp3 > 255 ||
+            intTemp4 < 1) {
+            std::cerr << termColor("red")
+                      << "The UDP ports must be 1~65535 (text port 0: off), the TTL 0~255 and the telemetry interval "
+                         ">= 1 ms"
+                      << termColor("nocolor") << std::endl;
+            return false;
+        }
+    } catch (YAML::Exception &e) {
+        std::cerr << termColor("red") << "Failed to read udp info. Please check the udp info" << termColor("nocolor")
+                  << std::endl;
+        std::cerr << "YamlConfig::UDP: " << e.what() << std::endl;
+        return false;
+    }
+
+    // load thread policy info
+    try {
+        // load yaml
+        boolTemp1 = yamlConfigNode_["ThreadPolicy"]["enableMemoryLock"].as<bool>();
+        intTemp1  = yamlConfigNode_["ThreadPolicy"]["prefaultHeapSize"].as<int>();
+        intTemp2  = yamlConfigNode_["ThreadPolicy"]["prefaultStackSize"].as<int>();
+        // save to systemInfo
+        systemInfo.threadPolicyInfo.isLockMemory      = boolTemp1;
+        systemInfo.threadPolicyInfo.prefaultHeapSize  = intTemp1;
+        systemInfo.threadPolicyInfo.prefaultStackSize = intTemp2;
+        if (intTemp1 < 0 || intTemp2 < 0) {
+            std::cerr << termColor("red") << "The pre-fault heap and stack size must be >= 0" << termColor("nocolor")
+                      << std::endl;
+            return false;
+        }
+
+        // each thread is configured as [CPU core, SCHED_FIFO priority]
+        const std::vector<std::pair<std::string, ThreadSchedInfo *>> threadSched = {
+            {"acquisition", &systemInfo.threadPolicyInfo.acquisition},
+            {"dspTOF", &systemInfo.threadPolicyInfo.dspTOF},
+            {"dspDOA", &systemInfo.threadPolicyInfo.dspDOA},
+            {"dspOutput", &systemInfo.threadPolicyInfo.dspOutput},
+            {"dspWorker", &systemInfo.threadPolicyInfo.dspWorker},
+            {"agc", &systemInfo.threadPolicyInfo.agc},
+            {"saveFile", &systemInfo.threadPolicyInfo.saveFile},
+            {"tcp", &systemInfo.threadPolicyInfo.tcp}};
+        for (const auto &sched : threadSched) {
+            intVecTemp1 = yamlConfigNode_["ThreadPolicy"][sched.first].as<std::vector<int>>();
+            if (intVecTemp1.size() != 2 || intVecTemp1[0] < -1 || intVecTemp1[1] < 0 || intVecTemp1[1] > 99) {
+                std::cerr << termColor("red") << "ThreadPolicy::" << sched.first
+                          << " must be [core (-1: not pinned), priority (0~99)]" << termColor("nocolor") << std::endl;
+                return false;
+            }
+            sched.second->core     = intVecTemp1[0];
+            sched.second->priority = intVecTemp1[1];
+        }
+    } catch (YAML::Exception &e) {
+        std::cerr << termColor("red") << "Failed to read thread policy info. Please check the thread policy info"
+                  << termColor("nocolor") << std::endl;
+        std::cerr << "YamlConfig::ThreadPolicy: " << e.what() << std::endl;
+        return false;
+    }
+
     // load transmit / receive info
     switch (systemInfo.workMode) {
         case WorkMode::MODE_TRANSMIT: {
@@ -287,6 +430,51 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
                 systemInfo.signalProcessInfo.endFrequency             = doubleTemp4;
                 systemInfo.signalProcessInfo.doaStep                  = doubleTemp5;
                 systemInfo.signalProcessInfo.referenceSignalFrequency = doubleTemp6;
+                // TOF method
+                strTemp1  = yamlConfigNode_["SignalProcess"]["tofMethod"].as<std::string>();
+                boolTemp1 = yamlConfigNode_["SignalProcess"]["enableEnvelopeTOF"].as<bool>();
+                // save to systemInfo
+                systemInfo.signalProcessInfo.tofMethod        = str2TOFMethod(strTemp1);
+                systemInfo.signalProcessInfo.isEnvelopeEnable = boolTemp1;
+                if (systemInfo.signalProcessInfo.tofMethod == TOF_UNKNOWN) {
+                    std::cerr << termColor("red") << "The TOF method must be TOF_PER_CHANNEL or TOF_COMBINED"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+                // DOA method
+                strTemp1    = yamlConfigNode_["SignalProcess"]["doaMethod"].as<std::string>();
+                doubleTemp1 = yamlConfigNode_["SignalProcess"]["diagonalLoading"].as<double>();
+                intTemp1    = yamlConfigNode_["SignalProcess"]["covarianceBinNumber"].as<int>();
+                intTemp2    = yamlConfigNode_["SignalProcess"]["sourceNumber"].as<int>();
+                systemInfo.signalProcessInfo.doaMethod           = str2DOAMethod(strTemp1);
+                systemInfo.signalProcessInfo.diagonalLoading     = doubleTemp1;
+                systemInfo.signalProcessInfo.covarianceBinNumber = intTemp1;
+                systemInfo.signalProcessInfo.sourceNumber        = intTemp2;
+                if (systemInfo.signalProcessInfo.doaMethod == DOA_UNKNOWN || doubleTemp1 < 0 || intTemp1 < 1 ||
+                    intTemp1 % 2 == 0 || intTemp2 < 1) {
+                    std::cerr << termColor("red")
+                              << "The DOA method must be DOA_CBF, DOA_MVDR or DOA_MUSIC, diagonal loading >= 0, "
+                                 "covariance bin number odd and source number >= 1"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+                // decimating front-end
+                boolTemp1 = yamlConfigNode_["SignalProcess"]["enableDecimation"].as<bool>();
+                intTemp1  = yamlConfigNode_["SignalProcess"]["decimationFactor"].as<int>();
+                intTemp2  = yamlConfigNode_["SignalProcess"]["decimationTaps"].as<int>();
+                systemInfo.signalProcessInfo.isDecimationEnable = boolTemp1;
+                systemInfo.signalProcessInfo.decimationFactor   = intTemp1;
+                systemInfo.signalProcessInfo.decimationTaps     = intTemp2;
+                if (boolTemp1 && (intTemp1 < 1 || intTemp2 < 1 ||
+                                  systemInfo.signalInfo.sampleRate / intTemp1 <=
+                                      systemInfo.signalProcessInfo.endFrequency -
+                                          systemInfo.signalProcessInfo.startFrequency)) {
+                    std::cerr << termColor("red")
+                              << "The decimation factor and taps must be >= 1, and the baseband rate (sample rate / "
+                                 "decimation factor) must exceed the process band width"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
             } catch (YAML::Exception &e) {
                 std::cerr << termColor("red")
                           << "Failed to read signal process info. Please check the signal process info"
@@ -294,6 +482,83 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
                 std::cerr << "YamlConfig::SignalProcess: " << e.what() << std::endl;
                 return false;
             }
+            // load DSP Pipeline Info
+            try {
+                // load yaml
+                intTemp1    = yamlConfigNode_["DSPPipeline"]["stageNumber"].as<int>();
+                intTemp2    = yamlConfigNode_["DSPPipeline"]["queueDepth"].as<int>();
+                intTemp3    = yamlConfigNode_["DSPPipeline"]["workerNumber"].as<int>();
+                // save to systemInfo
+                systemInfo.dspPipelineInfo.stageNum   = intTemp1;
+                systemInfo.dspPipelineInfo.queueDepth = intTemp2;
+                systemInfo.dspPipelineInfo.workerNum  = intTemp3;
+                if (intTemp1 < 1 || intTemp1 > 3 || intTemp2 < 1 || intTemp3 < 0) {
+                    std::cerr << termColor("red")
+                              << "The DSP pipeline stage number must be 1~3, queue depth >= 1 and worker number >= 0"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+            } catch (YAML::Exception &e) {
+                std::cerr << termColor("red") << "Failed to read DSP pipeline info. Please check the DSP pipeline info"
+                          << termColor("nocolor") << std::endl;
+                std::cerr << "YamlConfig::DSPPipeline: " << e.what() << std::endl;
+                return false;
+            }
+            // load Stream Info
+            try {
+                // load yaml
+                boolTemp1   = yamlConfigNode_["Stream"]["enableStream"].as<bool>();
+                intTemp1    = yamlConfigNode_["Stream"]["hopSamples"].as<int>();
+                doubleTemp1 = yamlConfigNode_["Stream"]["detectThreshold"].as<double>();
+                doubleTemp2 = yamlConfigNode_["Stream"]["pingPeriod"].as<double>();
+                // save to systemInfo
+                systemInfo.streamInfo.isEnable        = boolTemp1;
+                systemInfo.streamInfo.hopSamples      = intTemp1;
+                systemInfo.streamInfo.detectThreshold = doubleTemp1;
+                systemInfo.streamInfo.pingPeriod      = doubleTemp2;
+                if (intTemp1 < 1 || doubleTemp1 <= 0 || doubleTemp2 < 0) {
+                    std::cerr << termColor("red")
+                              << "The stream hop samples must be >= 1, detect threshold > 0 and ping period >= 0"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+            } catch (YAML::Exception &e) {
+                std::cerr << termColor("red") << "Failed to read stream info. Please check the stream info"
+                          << termColor("nocolor") << std::endl;
+                std::cerr << "YamlConfig::Stream: " << e.what() << std::endl;
+                return false;
+            }
+            // load Pre-filter Info
+            try {
+                // load yaml
+                boolTemp1   = yamlConfigNode_["PreFilter"]["enablePreFilter"].as<bool>();
+                strTemp1    = yamlConfigNode_["PreFilter"]["filterType"].as<std::string>();
+                doubleTemp1 = yamlConfigNode_["PreFilter"]["passStartFrequency"].as<double>();
+                doubleTemp2 = yamlConfigNode_["PreFilter"]["passEndFrequency"].as<double>();
+                intTemp1    = yamlConfigNode_["PreFilter"]["firTaps"].as<int>();
+                intTemp2    = yamlConfigNode_["PreFilter"]["iirOrder"].as<int>();
+                // save to systemInfo
+                systemInfo.preFilterInfo.isEnable           = boolTemp1;
+                systemInfo.preFilterInfo.filterType         = str2FilterType(strTemp1);
+                systemInfo.preFilterInfo.passStartFrequency = doubleTemp1;
+                systemInfo.preFilterInfo.passEndFrequency   = doubleTemp2;
+                systemInfo.preFilterInfo.firTaps            = intTemp1;
+                systemInfo.preFilterInfo.iirOrder           = intTemp2;
+                if (systemInfo.preFilterInfo.filterType == FILTER_UNKNOWN || intTemp1 < 1 || intTemp2 < 1 ||
+                    doubleTemp1 <= 0 || doubleTemp2 <= doubleTemp1 ||
+                    doubleTemp2 >= 0.5 * systemInfo.signalInfo.sampleRate) {
+                    std::cerr << termColor("red")
+                              << "The pre-filter type must be FILTER_FIR or FILTER_IIR, FIR taps and IIR order >= 1, "
+                                 "and the pass band must lie in (0, sample rate / 2)"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+            } catch (YAML::Exception &e) {
+                std::cerr << termColor("red") << "Failed to read pre-filter info. Please check the pre-filter info"
+                          << termColor("nocolor") << std::endl;
+                std::cerr << "YamlConfig::PreFilter: " << e.what() << std::endl;
+                return false;
+            }
             // load AGC Info
             try {
                 // load yaml
@@ -307,6 +572,10 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
                 doubleTemp5 = yamlConfigNode_["AGC"]["maxGain"].as<double>();
 
                 doubleTemp6 = yamlConfigNode_["AGC"]["agcStep"].as<double>();
+                intTemp1    = yamlConfigNode_["AGC"]["echoTimeout"].as<int>();
+                intTemp2    = yamlConfigNode_["AGC"]["maxRetries"].as<int>();
+                doubleTemp7 = yamlConfigNode_["AGC"]["gainSlope"].as<double>();
+                doubleTemp8 = yamlConfigNode_["AGC"]["gainOffset"].as<double>();
                 // save to systemInfo
                 systemInfo.agcInfo.isEnableAGC        = boolTemp1;
                 systemInfo.agcInfo.serialPortName     = strTemp1;
@@ -317,6 +586,48 @@ bool YamlConfig::loadConfig(SystemInfo &systemInfo) {
                 systemInfo.agcInfo.minGainValue       = doubleTemp4;
                 systemInfo.agcInfo.maxGainValue       = doubleTemp5;
                 systemInfo.agcInfo.gainStep           = doubleTemp6;
+                systemInfo.agcInfo.echoTimeout        = intTemp1;
+                systemInfo.agcInfo.maxRetries         = intTemp2;
+                systemInfo.agcInfo.gainSlope          = doubleTemp7;
+                systemInfo.agcInfo.gainOffset         = doubleTemp8;
+                if (intTemp1 < 1 || intTemp2 < 0) {
+                    std::cerr << termColor("red") << "The AGC echo timeout must be >= 1 and the retries >= 0"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+                // gain controller
+                strTemp1    = yamlConfigNode_["AGC"]["controller"].as<std::string>();
+                doubleTemp1 = yamlConfigNode_["AGC"]["piKp"].as<double>();
+                doubleTemp2 = yamlConfigNode_["AGC"]["piKi"].as<double>();
+                doubleTemp3 = yamlConfigNode_["AGC"]["saturationLevel"].as<double>();
+                doubleTemp4 = yamlConfigNode_["AGC"]["saturationBackoff"].as<double>();
+                doubleTemp5 = yamlConfigNode_["AGC"]["absorption"].as<double>();
+                // save to systemInfo
+                systemInfo.agcInfo.controller        = str2AgcController(strTemp1);
+                systemInfo.agcInfo.piKp              = doubleTemp1;
+                systemInfo.agcInfo.piKi              = doubleTemp2;
+                systemInfo.agcInfo.saturationLevel   = doubleTemp3;
+                systemInfo.agcInfo.saturationBackoff = doubleTemp4;
+                systemInfo.agcInfo.absorption        = doubleTemp5;
+                if (systemInfo.agcInfo.controller == AGC_UNKNOWN) {
+                    std::cerr << termColor("red")
+                              << "The AGC controller must be AGC_BANG_BANG, AGC_PI or AGC_FEED_FORWARD"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+                if (systemInfo.agcInfo.controller != AGC_BANG_BANG && systemInfo.agcInfo.gainSlope <= 0) {
+                    std::cerr << termColor("red") << "The AGC_PI and AGC_FEED_FORWARD controllers need a gainSlope > 0"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
+                if (doubleTemp1 < 0 || doubleTemp2 <= 0 || doubleTemp2 > 1 || doubleTemp3 <= 0 || doubleTemp4 <= 0 ||
+                    doubleTemp5 < 0) {
+                    std::cerr << termColor("red")
+                              << "The AGC piKp must be >= 0, piKi in (0, 1], the saturation level and backoff > 0 and "
+                                 "the absorption >= 0"
+                              << termColor("nocolor") << std::endl;
+                    return false;
+                }
             } catch (YAML::Exception &e) {
                 std::cerr << termColor("red") << "Failed to read AGC info. Please check the AGC info"
                           << termColor("nocolor") << std::endl;
@@ -0,0 +1,31 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 21:14:08
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 21:14:08
+ * @FilePath: /Raspi2USBL/core/benchmark.cpp
+ * @Description: See benchmark.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "benchmark.h"
+#include "../dataio/serialBenchmark.h"
+#include "../dsp/agcBenchmark.h"
+#include "../dsp/dspCheck.h"
+#include "../dsp/filter/filterBenchmark.h"
+
+bool runBenchmarks(SystemInfo &systemInfo, const ChannelSignalVector &refSignal) {
+    std::cout << termColor("reversegreen") << "Work Mode: Benchmark (" << workMode2Str(systemInfo.workMode) << ")"
+              << termColor("nocolor") << std::endl;
+
+    // the receive sections of the config are only loaded in receive mode
+    bool isPassed = true;
+    if (systemInfo.workMode == WorkMode::MODE_RECEIVE) {
+        isPassed = checkDSPKernels(systemInfo, refSignal);
+        benchmarkFilterKernels(systemInfo);
+        benchmarkAgcControllers(systemInfo);
+    }
+    benchmarkSerialWriter(systemInfo);
+    return isPassed;
+}
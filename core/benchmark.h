@@ -0,0 +1,29 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 21:14:08
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 21:14:08
+ * @FilePath: /Raspi2USBL/core/benchmark.h
+ * @Description: Benchmark mode ([System] enableBenchmark): the benchmarks of the modules, run on the config
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include "../general/typedef.h"
+#include "systeminfo.h"
+
+/***
+ * @description: Run the self-checks and benchmarks that apply to the work mode, one after the other: in receive mode
+ * the TOF and DOA self-check on a synthetic ping (see checkDSPKernels()), the filter kernels ([PreFilter]) and the
+ * AGC controllers ([AGC]), in both modes the serial writer ([DataIO]). No DAQ device is opened and none of the
+ * threads of the system is started.
+ * @param {SystemInfo} &systemInfo
+ * @param {ChannelSignalVector} &refSignal  The generated reference signal
+ * @return {bool}                           whether the self-checks passed
+ */
+bool runBenchmarks(SystemInfo &systemInfo, const ChannelSignalVector &refSignal);
+
+#endif // _BENCHMARK_H_
@@ -15,19 +15,36 @@
 #include "../config/defineconfig.h"
 #include "../daq/daqTypeDefine.h"
 #include "../tool/ColorParse.h"
+#include "../tool/ThreadPolicy.h"
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <vector>
 
 enum WorkMode { MODE_TRANSMIT, MODE_RECEIVE, MODE_ERROR };
+enum DOA_METHOD { DOA_CBF, DOA_MVDR, DOA_MUSIC, DOA_UNKNOWN };
+enum TOF_METHOD { TOF_PER_CHANNEL, TOF_COMBINED, TOF_UNKNOWN };
+enum FILTER_TYPE { FILTER_FIR, FILTER_IIR, FILTER_UNKNOWN };
+enum SLOW_CLIENT_POLICY { SLOW_CLIENT_DROP, SLOW_CLIENT_DISCONNECT, SLOW_CLIENT_UNKNOWN };
+enum AGC_CONTROLLER { AGC_BANG_BANG, AGC_PI, AGC_FEED_FORWARD, AGC_UNKNOWN };
 struct SystemInfo;
 
 // function declaration
-WorkMode    str2WorkMode(std::string str);
-std::string workMode2Str(WorkMode workMode);
-SIGNAL_TYPE str2SignalType(std::string str);
-std::string signalType2Str(SIGNAL_TYPE signalType);
-void        setDefualtDAQConfig(SystemInfo &systemInfo);
+WorkMode           str2WorkMode(std::string str);
+std::string        workMode2Str(WorkMode workMode);
+SIGNAL_TYPE        str2SignalType(std::string str);
+std::string        signalType2Str(SIGNAL_TYPE signalType);
+DOA_METHOD         str2DOAMethod(std::string str);
+std::string        doaMethod2Str(DOA_METHOD doaMethod);
+TOF_METHOD         str2TOFMethod(std::string str);
+std::string        tofMethod2Str(TOF_METHOD tofMethod);
+FILTER_TYPE        str2FilterType(std::string str);
+std::string        filterType2Str(FILTER_TYPE filterType);
+SLOW_CLIENT_POLICY str2SlowClientPolicy(std::string str);
+std::string        slowClientPolicy2Str(SLOW_CLIENT_POLICY slowClientPolicy);
+AGC_CONTROLLER     str2AgcController(std::string str);
+std::string        agcController2Str(AGC_CONTROLLER agcController);
+void               setDefualtDAQConfig(SystemInfo &systemInfo);
 typedef struct ArrayInfo {
     int    arrayNum;
     double arrayDiameter;
@@ -35,14 +52,45 @@ typedef struct ArrayInfo {
 } ArrayInfo;
 
 typedef struct SignalProcessInfo {
-    double referenceSignalFrequency;
-    double processDuration;
-    double startFrequency;
-    double endFrequency;
-    double doaStep;
-    double soundSpeed;
+    double     referenceSignalFrequency;
+    double     processDuration;
+    double     startFrequency;
+    double     endFrequency;
+    double     doaStep;
+    double     soundSpeed;
+    TOF_METHOD tofMethod;           // peak of each channel, or of the summed channels refined per channel
+    bool       isEnvelopeEnable;    // TOF on the correlation envelope (analytic signal) instead of the real correlation
+    DOA_METHOD doaMethod;           // conventional beamforming, MVDR (Capon) or MUSIC
+    double     diagonalLoading;     // MVDR / MUSIC, times the mean element power added to the covariance diagonal
+    int        covarianceBinNumber; // MVDR / MUSIC, neighbouring bins averaged into one covariance (odd)
+    int        sourceNumber;        // MUSIC, signal subspace dimension
+    bool       isDecimationEnable;  // mix down to complex baseband at the band center before TOF and DOA
+    int        decimationFactor;    // baseband rate = sample rate / decimationFactor
+    int        decimationTaps;      // low-pass FIR taps per polyphase branch
 } SignalProcessInfo;
 
+typedef struct PreFilterInfo {
+    bool        isEnable;           // band-pass the channels before TOF
+    FILTER_TYPE filterType;         // linear phase FIR or Butterworth biquad cascade
+    double      passStartFrequency; // Hz
+    double      passEndFrequency;   // Hz
+    int         firTaps;            // FIR length
+    int         iirOrder;           // IIR order, one biquad each
+} PreFilterInfo;
+
+typedef struct DSPPipelineInfo {
+    int stageNum;   // 1: serial, 2: TOF | DOA + output, 3: TOF | DOA | output
+    int queueDepth; // max pings buffered between two stages
+    int workerNum;  // worker threads shared by the TOF and DOA kernels, 0 means serial
+} DSPPipelineInfo;
+
+typedef struct StreamInfo {
+    bool   isEnable;        // continuous acquisition in hops and overlap-save matched filter
+    int    hopSamples;      // samples per channel of each hop
+    double detectThreshold; // detection threshold, times the correlation noise floor
+    double pingPeriod;      // s, TOF is the detection time modulo this period, 0 means time since the stream start
+} StreamInfo;
+
 typedef struct AgcInfo {
     bool        isEnableAGC;
     std::string serialPortName;
@@ -53,6 +101,17 @@ typedef struct AgcInfo {
     double      minGainValue;
     double      maxGainValue;
     double      gainStep;
+    int         echoTimeout; // ms the DAC gets to echo a command
+    int         maxRetries;  // resends of a command that is not echoed, then it is given up
+    double      gainSlope;   // amplifier gain per gain voltage (dB/V), normalizes the amplitudes of the pings
+    double      gainOffset;  // amplifier gain at 0 V (dB)
+
+    AGC_CONTROLLER controller;        // how the gain of the next ping is derived, see AgcController
+    double         piKp;              // PI controller: gain on the change of the level error
+    double         piKi;              // PI controller: gain on the level error (1: the whole error in one ping)
+    double         saturationLevel;   // raw sample magnitude taken as clipped (V)
+    double         saturationBackoff; // gain cut (dB) after a clipped ping, the peak says nothing then
+    double         absorption;        // feed-forward: absorption of the water (dB/km)
 } AgcInfo;
 
 typedef struct SavedFileInfo {
@@ -63,6 +122,7 @@ typedef struct SavedFileInfo {
     bool isSaveTOFRes;
     bool isSaveBeamPattern;
     bool isSaveSideAmpSpec;
+    int  diagnosticDecimation; // correlation, TOF, beam pattern and spectrum of every Nth ping only
 
     std::string AnalogInputFilePath;
     std::string GeneratedSignalFilePath;
@@ -78,22 +138,62 @@ typedef struct DataIOInfo {
     std::string outputPortBaudrate;
     std::string controlPortName;
     std::string controlPortBaudrate;
+    int         outputQueueDepth;   // sentences waiting for the output port, the oldest is dropped beyond
+    int         outputWriteTimeout; // ms the port gets for one batch of sentences
 } DataIOInfo;
 
 typedef struct TcpInfo {
     // std::string serverIP;
-    int serverPort;
-    int connectTimeout;
-    int sendTimeout;
+    int                serverPort;
+    int                sendTimeout;         // ms, a frame stuck longer at the head of a client queue: slow client
+    int                heartbeatInterval;   // ms, 0: no heartbeat
+    int                maxMissedHeartbeats; // a client that answers none of them is closed
+    int                maxClients;          // clients connected at the same time
+    int                clientQueueDepth;    // frames buffered per client
+    SLOW_CLIENT_POLICY slowClientPolicy;    // drop the oldest frames of a slow client or disconnect it
+    int                sendBufferSize;      // SO_SNDBUF of each client socket (bytes), 0 keeps the system default
+    int                encodeWorkerNum;     // threads encoding the product packets, 0: on the TCP send thread
+    int                compressionLevel;    // zlib level of the delta + zlib encoding (1~9)
 } TcpInfo;
 
+typedef struct UdpInfo {
+    bool        isEnable;          // publish the position fixes and the telemetry (receive mode)
+    std::string group;             // multicast group address
+    int         port;              // binary fixes and telemetry
+    int         textPort;          // $USBL text mirror of the fixes, 0: off
+    std::string interfaceAddress;  // local address of the LAN interface, empty: the default route
+    int         ttl;               // 1 stays on the local network
+    bool        isLoopback;        // listeners on this host get the datagrams too
+    int         telemetryInterval; // ms
+} UdpInfo;
+
+typedef struct ThreadPolicyInfo {
+    bool            isLockMemory;      // mlockall the whole process
+    int             prefaultHeapSize;  // heap bytes pre-faulted at startup
+    int             prefaultStackSize; // stack bytes pre-faulted in each policy thread
+    ThreadSchedInfo acquisition;       // uldaq data callback
+    ThreadSchedInfo dspTOF;            // DSP stage 1 (TOF + AGC update)
+    ThreadSchedInfo dspDOA;            // DSP stage 2 (DOA)
+    ThreadSchedInfo dspOutput;         // DSP stage 3 (result fan-out)
+    ThreadSchedInfo dspWorker;         // DSP thread pool workers
+    ThreadSchedInfo agc;               // AGC serial writer
+    ThreadSchedInfo saveFile;          // file saver threads
+    ThreadSchedInfo tcp;               // TCP sender
+} ThreadPolicyInfo;
+
 typedef struct SystemInfo {
     WorkMode          workMode;
+    bool              isBenchmark; // run the self-checks and benchmarks on the config, then exit
     SignalProcessInfo signalProcessInfo;
+    PreFilterInfo     preFilterInfo;
+    DSPPipelineInfo   dspPipelineInfo;
+    ThreadPolicyInfo  threadPolicyInfo;
+    StreamInfo        streamInfo;
     AgcInfo           agcInfo;
     ArrayInfo         arrayInfo;
     DataIOInfo        dataIOInfo;
     TcpInfo           tcpInfo;
+    UdpInfo           udpInfo;
     SavedFileInfo     savedFileInfo;
     AIScanInfo        aiScanInfo;
     AOScanInfo        aoScanInfo;
@@ -110,6 +210,11 @@ inline void setDefualtDAQConfig(SystemInfo &systemInfo) {
     systemInfo.aiScanInfo.scanOption = (ScanOption) (SO_DEFAULTIO | SO_EXTTRIGGER);
 #endif // _DAQAI_MCC1608FSPLUS_
 
+    // streaming: one continuous scan started by the first sync pulse, read hop by hop
+    if (systemInfo.streamInfo.isEnable) {
+        systemInfo.aiScanInfo.scanOption = (ScanOption) (SO_DEFAULTIO | SO_EXTTRIGGER | SO_CONTINUOUS);
+    }
+
     systemInfo.aiScanInfo.eventTypes =
         (DaqEventType) (DE_ON_DATA_AVAILABLE | DE_ON_INPUT_SCAN_ERROR | DE_ON_END_OF_INPUT_SCAN);
 
@@ -128,6 +233,8 @@ inline void pinrtSystemConfig(SystemInfo &systemInfo) {
         std::string workModeStr = workMode2Str(systemInfo.workMode);
         std::cout << termColor("blue") << "WorkMode: " << termColor("yellow") << workModeStr << termColor("nocolor")
                   << std::endl;
+        std::cout << termColor("blue") << "Benchmark Mode: " << termColor("yellow")
+                  << (systemInfo.isBenchmark ? "true" : "false") << termColor("nocolor") << std::endl;
 
         // print whether to save files
         std::cout << termColor("blue") << "Enable Transmit Signal Save: " << termColor("yellow")
@@ -136,6 +243,8 @@ inline void pinrtSystemConfig(SystemInfo &systemInfo) {
         std::cout << termColor("blue") << "Enable Receive Signal Save: " << termColor("yellow")
                   << (systemInfo.savedFileInfo.isSaveAnalogInput ? "true" : "false") << termColor("nocolor")
                   << std::endl;
+        std::cout << termColor("blue") << "Diagnostic Decimation: " << termColor("yellow")
+                  << systemInfo.savedFileInfo.diagnosticDecimation << termColor("nocolor") << std::endl;
 
         // print file path
         if (systemInfo.savedFileInfo.isSaveGeneratedSignal) {
@@ -147,9 +256,16 @@ inline void pinrtSystemConfig(SystemInfo &systemInfo) {
                       << systemInfo.savedFileInfo.AnalogInputFilePath << termColor("nocolor") << std::endl;
         }
 
+        // print thread policy
+        std::cout << termColor("blue") << "Enable Memory Lock: " << termColor("yellow")
+                  << (systemInfo.threadPolicyInfo.isLockMemory ? "true" : "false") << termColor("nocolor")
+                  << std::endl;
+
         // print signal info
         std::cout << termColor("blue") << "Signal Sample Rate: " << termColor("yellow")
                   << systemInfo.signalInfo.sampleRate << termColor("nocolor") << std::endl;
+        std::cout << termColor("blue") << "Signal Taper Ratio: " << termColor("yellow")
+                  << systemInfo.signalInfo.taperRatio << termColor("nocolor") << std::endl;
 
         // print cuttent line
         std::cout << std::string(95, '-') << std::endl;
@@ -194,6 +310,75 @@ inline void pinrtSystemConfig(SystemInfo &systemInfo) {
                           << systemInfo.aiScanInfo.rate << termColor("nocolor") << std::endl;
                 std::cout << termColor("blue") << "Receive Duration: " << termColor("yellow")
                           << systemInfo.aiScanInfo.duration << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "TOF Method: " << termColor("yellow")
+                          << tofMethod2Str(systemInfo.signalProcessInfo.tofMethod)
+                          << (systemInfo.signalProcessInfo.isEnvelopeEnable ? ", envelope" : "") << termColor("nocolor")
+                          << std::endl;
+                std::cout << termColor("blue") << "DOA Method: " << termColor("yellow")
+                          << doaMethod2Str(systemInfo.signalProcessInfo.doaMethod) << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "Decimation Factor: " << termColor("yellow")
+                          << (systemInfo.signalProcessInfo.isDecimationEnable
+                                  ? std::to_string(systemInfo.signalProcessInfo.decimationFactor)
+                                  : std::string("off"))
+                          << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "Pre-filter: " << termColor("yellow");
+                if (systemInfo.preFilterInfo.isEnable) {
+                    std::cout << filterType2Str(systemInfo.preFilterInfo.filterType) << " "
+                              << systemInfo.preFilterInfo.passStartFrequency << " ~ "
+                              << systemInfo.preFilterInfo.passEndFrequency << " Hz, "
+                              << (systemInfo.preFilterInfo.filterType == FILTER_FIR
+                                      ? std::to_string(systemInfo.preFilterInfo.firTaps) + " taps"
+                                      : "order " + std::to_string(systemInfo.preFilterInfo.iirOrder));
+                } else {
+                    std::cout << "off";
+                }
+                std::cout << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "DSP Pipeline Stages: " << termColor("yellow")
+                          << systemInfo.dspPipelineInfo.stageNum << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "DSP Worker Number: " << termColor("yellow")
+                          << systemInfo.dspPipelineInfo.workerNum << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "TCP Clients: " << termColor("yellow") << "port "
+                          << systemInfo.tcpInfo.serverPort << ", max " << systemInfo.tcpInfo.maxClients << ", "
+                          << systemInfo.tcpInfo.clientQueueDepth << " frames queued, "
+                          << slowClientPolicy2Str(systemInfo.tcpInfo.slowClientPolicy) << termColor("nocolor")
+                          << std::endl;
+                std::cout << termColor("blue") << "TCP Heartbeat: " << termColor("yellow")
+                          << systemInfo.tcpInfo.heartbeatInterval << " ms, closed after "
+                          << systemInfo.tcpInfo.maxMissedHeartbeats << " missed" << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "TCP Encoder: " << termColor("yellow")
+                          << systemInfo.tcpInfo.encodeWorkerNum << " workers, zlib level "
+                          << systemInfo.tcpInfo.compressionLevel << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "UDP Multicast: " << termColor("yellow");
+                if (systemInfo.udpInfo.isEnable) {
+                    std::cout << systemInfo.udpInfo.group << ":" << systemInfo.udpInfo.port << ", text "
+                              << (systemInfo.udpInfo.textPort > 0 ? std::to_string(systemInfo.udpInfo.textPort)
+                                                                  : std::string("off"))
+                              << ", telemetry every " << systemInfo.udpInfo.telemetryInterval << " ms";
+                } else {
+                    std::cout << "off";
+                }
+                std::cout << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "AGC: " << termColor("yellow");
+                if (systemInfo.agcInfo.isEnableAGC) {
+                    std::cout << systemInfo.agcInfo.serialPortName << ", echo timeout "
+                              << systemInfo.agcInfo.echoTimeout << " ms, " << systemInfo.agcInfo.maxRetries
+                              << " retries, ";
+                } else {
+                    std::cout << "off, ";
+                }
+                std::cout << "gain " << systemInfo.agcInfo.gainSlope << " dB/V + " << systemInfo.agcInfo.gainOffset
+                          << " dB, " << agcController2Str(systemInfo.agcInfo.controller);
+                std::cout << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "Output Serial: " << termColor("yellow")
+                          << systemInfo.dataIOInfo.outputPortName << " " << systemInfo.dataIOInfo.outputPortBaudrate
+                          << ", " << systemInfo.dataIOInfo.outputQueueDepth << " sentences queued, timeout "
+                          << systemInfo.dataIOInfo.outputWriteTimeout << " ms" << termColor("nocolor") << std::endl;
+                std::cout << termColor("blue") << "Streaming Acquisition: " << termColor("yellow")
+                          << (systemInfo.streamInfo.isEnable ? "true" : "false") << termColor("nocolor") << std::endl;
+                if (systemInfo.streamInfo.isEnable) {
+                    std::cout << termColor("blue") << "Stream Hop Samples: " << termColor("yellow")
+                              << systemInfo.streamInfo.hopSamples << termColor("nocolor") << std::endl;
+                }
                 break;
             }
             default:
@@ -248,6 +433,10 @@ inline SIGNAL_TYPE str2SignalType(std::string str) {
         return SIG_CHRIP;
     } else if (str == "SIG_ZERO") {
         return SIG_ZERO;
+    } else if (str == "SIG_CHRIP_HANN") {
+        return SIG_CHRIP_HANN;
+    } else if (str == "SIG_CHRIP_TUKEY") {
+        return SIG_CHRIP_TUKEY;
     } else {
         std::cerr << termColor("red") << "Error: Unknown signal type: " << str << termColor("nocolor") << std::endl;
         return SIG_UNKNOWN;
@@ -268,9 +457,145 @@ inline std::string signalType2Str(SIGNAL_TYPE signalType) {
             return "SIG_CHRIP";
         case SIG_ZERO:
             return "SIG_ZERO";
+        case SIG_CHRIP_HANN:
+            return "SIG_CHRIP_HANN";
+        case SIG_CHRIP_TUKEY:
+            return "SIG_CHRIP_TUKEY";
         default:
             return "SIG_UNKNOWN";
     }
 }
 
+inline DOA_METHOD str2DOAMethod(std::string str) {
+    if (str == "DOA_CBF") {
+        return DOA_CBF;
+    } else if (str == "DOA_MVDR") {
+        return DOA_MVDR;
+    } else if (str == "DOA_MUSIC") {
+        return DOA_MUSIC;
+    } else {
+        std::cerr << termColor("red") << "Error: Unknown DOA method: " << str << termColor("nocolor") << std::endl;
+        std::cout << "The standard DOA method is " << termColor("yellow") << "DOA_CBF" << termColor("nocolor")
+                  << ", " << termColor("yellow") << "DOA_MVDR" << termColor("nocolor") << " or "
+                  << termColor("yellow") << "DOA_MUSIC" << termColor("nocolor") << std::endl;
+        return DOA_UNKNOWN;
+    }
+}
+
+inline std::string doaMethod2Str(DOA_METHOD doaMethod) {
+    switch (doaMethod) {
+        case DOA_CBF:
+            return "DOA_CBF";
+        case DOA_MVDR:
+            return "DOA_MVDR";
+        case DOA_MUSIC:
+            return "DOA_MUSIC";
+        default:
+            return "DOA_UNKNOWN";
+    }
+}
+
+inline TOF_METHOD str2TOFMethod(std::string str) {
+    if (str == "TOF_PER_CHANNEL") {
+        return TOF_PER_CHANNEL;
+    } else if (str == "TOF_COMBINED") {
+        return TOF_COMBINED;
+    } else {
+        std::cerr << termColor("red") << "Error: Unknown TOF method: " << str << termColor("nocolor") << std::endl;
+        std::cout << "The standard TOF method is " << termColor("yellow") << "TOF_PER_CHANNEL" << termColor("nocolor")
+                  << " or " << termColor("yellow") << "TOF_COMBINED" << termColor("nocolor") << std::endl;
+        return TOF_UNKNOWN;
+    }
+}
+
+inline std::string tofMethod2Str(TOF_METHOD tofMethod) {
+    switch (tofMethod) {
+        case TOF_PER_CHANNEL:
+            return "TOF_PER_CHANNEL";
+        case TOF_COMBINED:
+            return "TOF_COMBINED";
+        default:
+            return "TOF_UNKNOWN";
+    }
+}
+
+inline SLOW_CLIENT_POLICY str2SlowClientPolicy(std::string str) {
+    if (str == "SLOW_CLIENT_DROP") {
+        return SLOW_CLIENT_DROP;
+    } else if (str == "SLOW_CLIENT_DISCONNECT") {
+        return SLOW_CLIENT_DISCONNECT;
+    } else {
+        std::cerr << termColor("red") << "Error: Unknown slow client policy: " << str << termColor("nocolor")
+                  << std::endl;
+        std::cout << "The standard slow client policy is " << termColor("yellow") << "SLOW_CLIENT_DROP"
+                  << termColor("nocolor") << " or " << termColor("yellow") << "SLOW_CLIENT_DISCONNECT"
+                  << termColor("nocolor") << std::endl;
+        return SLOW_CLIENT_UNKNOWN;
+    }
+}
+
+inline std::string slowClientPolicy2Str(SLOW_CLIENT_POLICY slowClientPolicy) {
+    switch (slowClientPolicy) {
+        case SLOW_CLIENT_DROP:
+            return "SLOW_CLIENT_DROP";
+        case SLOW_CLIENT_DISCONNECT:
+            return "SLOW_CLIENT_DISCONNECT";
+        default:
+            return "SLOW_CLIENT_UNKNOWN";
+    }
+}
+
+inline AGC_CONTROLLER str2AgcController(std::string str) {
+    if (str == "AGC_BANG_BANG") {
+        return AGC_BANG_BANG;
+    } else if (str == "AGC_PI") {
+        return AGC_PI;
+    } else if (str == "AGC_FEED_FORWARD") {
+        return AGC_FEED_FORWARD;
+    } else {
+        std::cerr << termColor("red") << "Error: Unknown AGC controller: " << str << termColor("nocolor") << std::endl;
+        std::cout << "The standard AGC controller is " << termColor("yellow") << "AGC_BANG_BANG"
+                  << termColor("nocolor") << ", " << termColor("yellow") << "AGC_PI" << termColor("nocolor") << " or "
+                  << termColor("yellow") << "AGC_FEED_FORWARD" << termColor("nocolor") << std::endl;
+        return AGC_UNKNOWN;
+    }
+}
+
+inline std::string agcController2Str(AGC_CONTROLLER agcController) {
+    switch (agcController) {
+        case AGC_BANG_BANG:
+            return "AGC_BANG_BANG";
+        case AGC_PI:
+            return "AGC_PI";
+        case AGC_FEED_FORWARD:
+            return "AGC_FEED_FORWARD";
+        default:
+            return "AGC_UNKNOWN";
+    }
+}
+
+inline FILTER_TYPE str2FilterType(std::string str) {
+    if (str == "FILTER_FIR") {
+        return FILTER_FIR;
+    } else if (str == "FILTER_IIR") {
+        return FILTER_IIR;
+    } else {
+        std::cerr << termColor("red") << "Error: Unknown filter type: " << str << termColor("nocolor") << std::endl;
+        std::cout << "The standard filter type is " << termColor("yellow") << "FILTER_FIR" << termColor("nocolor")
+                  << " or " << termColor("yellow") << "FILTER_IIR" << termColor("nocolor") << std::endl;
+        return FILTER_UNKNOWN;
+    }
+}
+
+inline std::string filterType2Str(FILTER_TYPE filterType) {
+    switch (filterType) {
+        case FILTER_FIR:
+            return "FILTER_FIR";
+        case FILTER_IIR:
+            return "FILTER_IIR";
+        default:
+            return "FILTER_UNKNOWN";
+    }
+}
+
 #endif // _SYSTEMINFO_H_
\ No newline at end of file
@@ -80,6 +80,14 @@ void AIScanWithTrigger::init() {
     // using event sample count to save data
     availableSampleCount_ = samplesPerChannel_;
 
+    // streaming: the scan buffer is a ring of whole hops (at least 4), one data event per hop
+    if (scanInfo_->isStream) {
+        int hopSamples        = scanInfo_->hopSamples;
+        int hopNum            = std::max(4, (samplesPerChannel_ + hopSamples - 1) / hopSamples);
+        samplesPerChannel_    = hopNum * hopSamples;
+        availableSampleCount_ = hopSamples;
+    }
+
     duration_             = scanInfo_->duration;
     interval_             = scanInfo_->interval;
 }
@@ -245,6 +253,14 @@ void AIScanWithTrigger::saveToScanEventParameters(AIScanEventParameters &scanEve
         // scanEventParams.samplesPerChan = samplesPerChannel_;
         scanEventParams.rate     = rate_;
         scanEventParams.interval = interval_;
+        // thread policy
+        scanEventParams.threadSched           = scanInfo_->threadSched;
+        scanEventParams.prefaultStackSize     = scanInfo_->prefaultStackSize;
+        scanEventParams.isThreadPolicyApplied = false;
+        // streaming mode
+        scanEventParams.isStream   = scanInfo_->isStream;
+        scanEventParams.hopSamples = scanInfo_->hopSamples;
+        scanEventParams.nextScan   = 0;
         // scanEventParams.options = scanOptions_;
         // scanEventParams.flags = flags_;
 #ifdef _DAQAI_MCC1608FSPLUS_
@@ -269,6 +285,8 @@ void AIScanWithTrigger::saveDataToQueue(double *buffer, int channelCount, int bu
     if (checkBufferFull(buffer, bufferSize)) {
         // init the ChannelSignalVector
         ChannelSignalVector csvTemp(channelCount, bufferSize / channelCount);
+        // the buffer is full now, the gain of the ping is looked up by this time
+        csvTemp.time = std::chrono::steady_clock::now();
         // copy the data to the data buffer vector
         dataBufferVec.assign(buffer, buffer + bufferSize);
         // std::cout << "dataBufferVec: " << dataBufferVec[1] << std::endl;
@@ -302,6 +320,8 @@ void AIScanWithTrigger::saveDataToQueue(double *buffer, int channelCount, int bu
     if (checkBufferFull(buffer, bufferSize)) {
         // init the ChannelSignalVector
         ChannelSignalVector csvTemp(channelCount, bufferSize / channelCount);
+        // the buffer is full now, the gain of the ping is looked up by this time
+        csvTemp.time = std::chrono::steady_clock::now();
         // copy the data to the data buffer vector
         dataBufferVec.assign(buffer, buffer + bufferSize);
         // std::cout << "dataBufferVec: " << dataBufferVec[1] << std::endl;
@@ -326,6 +346,40 @@ void AIScanWithTrigger::saveDataToQueue(double *buffer, int channelCount, int bu
     }
 }
 
+void AIScanWithTrigger::saveHopsToQueue(AIScanEventParameters *scanEventParameters, unsigned long long scanCount) {
+    int                channelCount = scanEventParameters->highChan - scanEventParameters->lowChan + 1;
+    int                hopSamples   = scanEventParameters->hopSamples;
+    unsigned long long ringScans    = scanEventParameters->bufferSize / channelCount;
+
+    // samples older than the ring are overwritten, the absolute sample index of later hops would be wrong
+    if (scanCount - scanEventParameters->nextScan > ringScans) {
+        throw std::runtime_error("\nStream buffer overrun, hops are lost\n");
+    }
+
+    // scanCount samples are acquired now, the hops are stamped back from here at the sample rate
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    while (scanEventParameters->nextScan + hopSamples <= scanCount) {
+        ChannelSignalVector csvTemp(channelCount, hopSamples);
+        double              age = (scanCount - scanEventParameters->nextScan - hopSamples) / scanEventParameters->rate;
+        csvTemp.time = now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double>(age));
+        for (int j = 0; j < hopSamples; ++j) {
+            unsigned long long ringIndex = (scanEventParameters->nextScan + j) % ringScans;
+            double            *scan      = scanEventParameters->buffer + ringIndex * channelCount;
+            for (int i = 0; i < channelCount; ++i) {
+                csvTemp.channels[i][j] = scan[i];
+            }
+        }
+        scanEventParameters->nextScan += hopSamples;
+
+        scanEventParameters->dataSaveQueue->push(csvTemp);
+        if (scanEventParameters->dataSendQueue != nullptr) {
+            scanEventParameters->dataSendQueue->push(csvTemp);
+        }
+        scanEventParameters->dataQueue->push(csvTemp);
+    }
+}
+
 bool AIScanWithTrigger::checkBufferFull(double *buffer, int bufferSize) {
     for (int i = 0; i < bufferSize; ++i) {
         if (std::isnan(buffer[i])) {
@@ -361,6 +415,12 @@ void AIScanWithTrigger::eventRecoverySampling(DaqDeviceHandle daqDeviceHandle, D
     // process event
     switch (eventType) {
         case DE_ON_DATA_AVAILABLE: { // data available, print data
+            // the callback runs on a uldaq internal thread, apply the thread policy once it is known
+            if (!scanEventParameters->isThreadPolicyApplied) {
+                applyThreadPolicy("DAQ Acquisition", scanEventParameters->threadSched,
+                                  scanEventParameters->prefaultStackSize);
+                scanEventParameters->isThreadPolicyApplied = true;
+            }
 
 #ifdef _DAQAI_DEBUG_
             std::cout << "Queue Size" << scanEventParameters->dataQueue->size() << std::endl;
@@ -387,7 +447,10 @@ void AIScanWithTrigger::eventRecoverySampling(DaqDeviceHandle daqDeviceHandle, D
             // using event sample count to save data and clear the buffer with NAN
             // We should define the availableSampleCount equal to the samplesPerChannel, to save the data
             int channelCount = scanEventParameters->highChan - scanEventParameters->lowChan + 1;
-            if (scanEventParameters->dataSendQueue == nullptr) {
+            if (scanEventParameters->isStream) {
+                // eventData is the number of samples per channel acquired since the scan start
+                saveHopsToQueue(scanEventParameters, eventData);
+            } else if (scanEventParameters->dataSendQueue == nullptr) {
                 saveDataToQueue(scanEventParameters->buffer, channelCount, scanEventParameters->bufferSize,
                                 scanEventParameters->dataQueue, scanEventParameters->dataSaveQueue);
             } else {
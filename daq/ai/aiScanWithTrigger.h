@@ -129,6 +129,15 @@ public:
                                 sfq::Safe_Queue<ChannelSignalVector> *dataSaveQueue,
                                 sfq::Safe_Queue<ChannelSignalVector> *dataSendQueue);
 
+    /***
+     * @description: streaming mode, push every complete hop between the last pushed scan and scanCount
+     * from the ring buffer to the queues
+     * @param {AIScanEventParameters} *scanEventParameters     event parameters (buffer, queues, stream position)
+     * @param {unsigned long long} scanCount                    samples per channel acquired since the scan start
+     * @return {*}
+     */
+    static void saveHopsToQueue(AIScanEventParameters *scanEventParameters, unsigned long long scanCount);
+
     /***
      * @description: check buffer is full or not
      * @param {double*} buffer          data buffer
@@ -16,6 +16,7 @@
 #include "../config/defineconfig.h"
 #include "../general/typedef.h"
 #include "../tool/SafeQueue.hpp"
+#include "../tool/ThreadPolicy.h"
 #include "signalGenerator.h"
 #include "uldaq.h"
 #include "utility.h"
@@ -41,6 +42,16 @@ typedef struct AIScanEventParameters {
     double rate;     // Channel Sample num per second
     double interval; // scan interval
 
+    // Streaming Mode
+    bool               isStream;   // the buffer is a ring read hop by hop
+    int                hopSamples; // samples per channel of each hop
+    unsigned long long nextScan;   // first scan not pushed yet (absolute sample index of the next hop)
+
+    // Thread Policy of the uldaq callback thread, applied on the first data event
+    ThreadSchedInfo threadSched;
+    int             prefaultStackSize;
+    bool            isThreadPolicyApplied;
+
 #ifdef _DAQAI_MCC1608FSPLUS_
     DaqDeviceHandle daqDeviceHandle;
     AiInputMode     aiInputMode;
@@ -66,6 +77,14 @@ typedef struct AIScanInfo {
     // process parameter
     int    duration; // * [S] scan duration
     double interval; // * [S] scan interval
+
+    // streaming mode
+    bool isStream   = false; // * [S] one continuous scan read hop by hop
+    int  hopSamples = 0;     // * [S] samples per channel of each hop
+
+    // thread policy
+    ThreadSchedInfo threadSched;           // * [S] core and priority of the data callback thread
+    int             prefaultStackSize = 0; // * [S] stack bytes pre-faulted in the data callback thread
 } AIScanInfo;
 
 typedef struct AOScanInfo {
@@ -86,6 +105,7 @@ typedef struct AOScanInfo {
 typedef struct SignalInfo {
     int                         partialSignalNum;
     double                      sampleRate;
+    double                      taperRatio; // Tukey taper ratio of the SIG_CHRIP_TUKEY partial signals
     std::vector<SIGNAL_PARTIAL> signalPartial;
 } SignalInfo;
 
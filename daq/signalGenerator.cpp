@@ -11,10 +11,80 @@
 
 #include "signalGenerator.h"
 #include "../tool/ColorParse.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <math.h>
 #include <stdexcept>
 
+namespace {
+
+// sin(2 pi x) for x in cycles: reduced to a quarter period, then the odd Taylor series up to a^15 (error below 7e-12,
+// far under the 16 bit DAC step). No branches and no libm call, so the sample loops below are vectorized.
+// The rounding uses 1.5 * 2^52 (adding and subtracting it rounds to the nearest integer, valid for |x| < 2^51).
+inline double sinCycle(double x) {
+    const double roundMagic = 6755399441055744.0;
+    double       r          = x - ((x + roundMagic) - roundMagic); // [-0.5, 0.5]
+    // sin(2 pi r) = sign(r) sin(2 pi t) with t = 0.25 - ||r| - 0.25| in [0, 0.25]
+    double t  = 0.25 - std::fabs(std::fabs(r) - 0.25);
+    double a  = 2 * M_PI * t;
+    double a2 = a * a;
+    double p  = -1.0 / 1307674368000.0;
+    p         = p * a2 + 1.0 / 6227020800.0;
+    p         = p * a2 - 1.0 / 39916800.0;
+    p         = p * a2 + 1.0 / 362880.0;
+    p         = p * a2 - 1.0 / 5040.0;
+    p         = p * a2 + 1.0 / 120.0;
+    p         = p * a2 - 1.0 / 6.0;
+    p         = p * a2 + 1.0;
+    return std::copysign(a * p, r);
+}
+
+// scale * sin(2 pi (cycle0 + cycleStep * i)), the phase of every sample is computed directly
+void fillTone(double *signal, int sampleNum, double cycle0, double cycleStep, double scale) {
+    for (int i = 0; i < sampleNum; i++) {
+        signal[i] = scale * sinCycle(cycle0 + cycleStep * i);
+    }
+}
+
+// scale * sin(2 pi (cycle0 + cycleStep * (i + 1) + cycleRate * i (i - 1) / 2)): the closed form of the phase
+// recurrence phase(i + 1) = phase(i) + 2 pi (f0 + k i) dt starting at phase + 2 pi f0 dt
+void fillChirp(double *signal, int sampleNum, double cycle0, double cycleStep, double cycleRate, double scale) {
+    for (int i = 0; i < sampleNum; i++) {
+        double n  = i;
+        signal[i] = scale * sinCycle(cycle0 + cycleStep * (n + 1) + 0.5 * cycleRate * n * (n - 1));
+    }
+}
+
+// multiply by a Tukey window with the given taper ratio (1: Hann window, 0: rectangular)
+void applyTukeyWindow(double *signal, int sampleNum, double taper) {
+    if (sampleNum < 2 || taper <= 0) {
+        return;
+    }
+    taper           = std::min(taper, 1.0);
+    double edge     = 0.5 * taper * (sampleNum - 1); // samples inside each taper
+    double invEdge  = 1.0 / edge;
+    int    taperNum = std::min(static_cast<int>(edge) + 1, sampleNum);
+    // w = 0.5 (1 - cos(pi i / edge)) on the rising edge, mirrored on the falling edge (w = 1 where they meet)
+    for (int i = 0; i < taperNum; i++) {
+        double w = 0.5 - 0.5 * sinCycle(0.5 * i * invEdge + 0.25);
+        signal[i] *= w;
+        signal[sampleNum - 1 - i] *= w;
+    }
+}
+
+bool isSamePartial(const SIGNAL_PARTIAL &a, const SIGNAL_PARTIAL &b) {
+    return a.type == b.type && a.sampleRate == b.sampleRate && a.frequency0 == b.frequency0 &&
+           a.frequency1 == b.frequency1 && a.amplitude == b.amplitude && a.phase == b.phase &&
+           a.duration == b.duration && a.taper == b.taper;
+}
+
+bool isSamePartialList(const std::vector<SIGNAL_PARTIAL> &a, const std::vector<SIGNAL_PARTIAL> &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), isSamePartial);
+}
+
+} // namespace
+
 SignalGenerator::SignalGenerator(double samplerate) {
     samplerate_      = samplerate;
     maxSignalLength_ = samplerate * 1;
@@ -29,7 +99,10 @@ SignalGenerator::SignalGenerator(double samplerate, double duration) {
 }
 
 void SignalGenerator::init() {
-    signalVec_.clear();
+    signalPartials_.clear();
+    waveformCache_.clear();
+    signalVec_    = nullptr;
+    signalLength_ = 0;
 
 #ifdef _SIGNALGENERATOR_DEBUG_
     std::cout << termColor("green") << "SignalGenerator is initialized" << termColor("nocolor") << "\n";
@@ -59,105 +132,112 @@ void SignalGenerator::addSignal(std::vector<SIGNAL_PARTIAL> signalPartialInfos)
 }
 
 double *SignalGenerator::generateSignal() {
-    double *signal          = nullptr;
+    // cache hit: move the waveform to the front
+    for (auto it = waveformCache_.begin(); it != waveformCache_.end(); ++it) {
+        if (isSamePartialList(it->signalPartials, signalPartials_)) {
+            waveformCache_.splice(waveformCache_.begin(), waveformCache_, it);
+            signalVec_    = &waveformCache_.front().signal;
+            signalLength_ = signalVec_->size();
+            return signalVec_->data();
+        }
+    }
 
-    int    partialSignalNum = signalPartials_.size();
     // check data length
     double cumulativeSignalNum = 0;
-    for (int i = 0; i < partialSignalNum; i++) {
-        cumulativeSignalNum += signalPartials_[i].sampleRate * signalPartials_[i].duration;
+    int    totalLength         = 0;
+    for (const auto &signalPartial : signalPartials_) {
+        cumulativeSignalNum += signalPartial.sampleRate * signalPartial.duration;
+        totalLength += partialSignalLength(signalPartial);
     }
     if (cumulativeSignalNum > maxSignalLength_) {
         throw std::invalid_argument("SignalGenerator::generateSignal: signal length is not enough");
     }
 
-    // generate partial signal
-    signalVec_.clear();
-    std::vector<double> signalVecTemp;
-    for (int i = 0; i < partialSignalNum; i++) {
-        signalVecTemp = generatePartialSignal(signalPartials_[i]);
-        signalVec_.insert(signalVec_.end(), signalVecTemp.begin(), signalVecTemp.end());
-        signalVecTemp.clear();
+    // generate every partial signal in place
+    CachedWaveform waveform;
+    waveform.signalPartials = signalPartials_;
+    waveform.signal.resize(totalLength);
+    int offset = 0;
+    for (const auto &signalPartial : signalPartials_) {
+        generatePartialSignal(signalPartial, waveform.signal.data() + offset);
+        offset += partialSignalLength(signalPartial);
     }
 
-    signalLength_ = signalVec_.size();
-
-    // copy the signal vector to the signal array
-    signal = (double *) malloc(signalLength_ * sizeof(double));
-    std::copy(signalVec_.begin(), signalVec_.end(), signal);
-    // // add zero to the end of the signal
-    // std::fill_n(signal + signalVec_.size(), signalLength_ - signalVec_.size(), 0);
-
-    return signal;
+    waveformCache_.push_front(std::move(waveform));
+    if (waveformCache_.size() > WAVEFORM_CACHE_SIZE) {
+        waveformCache_.pop_back();
+    }
+    signalVec_    = &waveformCache_.front().signal;
+    signalLength_ = signalVec_->size();
+    return signalVec_->data();
 }
 
 void SignalGenerator::saveSignalToFile(std::string filename, int filetype) {
+    if (signalVec_ == nullptr) {
+        throw std::runtime_error("SignalGenerator::saveSignalToFile: no signal generated");
+    }
     filesaver_.open(filename, filetype);
-    filesaver_.dump(signalVec_);
+    filesaver_.dump(std::vector<double>(signalVec_->begin(), signalVec_->end()));
     filesaver_.close();
 }
 
-std::vector<double> SignalGenerator::generatePartialSignal(SIGNAL_PARTIAL signalPartialInfo) {
-    std::vector<double> signalVecTemp;
-    double              sampleNum = signalPartialInfo.sampleRate * signalPartialInfo.duration;
-    double              dt        = 1.0 / signalPartialInfo.sampleRate;
-    double              phase     = signalPartialInfo.phase;
-    double              tempdata  = 0;
+int SignalGenerator::partialSignalLength(const SIGNAL_PARTIAL &signalPartialInfo) {
+    double sampleNum = signalPartialInfo.sampleRate * signalPartialInfo.duration;
+    if (sampleNum <= 0) {
+        return 0;
+    }
+    switch (signalPartialInfo.type) {
+        case SIG_SIN:
+        case SIG_COS:
+        case SIG_CHRIP:
+        case SIG_CHRIP_HANN:
+        case SIG_CHRIP_TUKEY:
+            return static_cast<int>(std::ceil(sampleNum));
+        default:
+            return static_cast<int>(sampleNum);
+    }
+}
 
-    signalVecTemp.clear();
-    signalVecTemp.reserve(sampleNum);
+void SignalGenerator::generatePartialSignal(const SIGNAL_PARTIAL &signalPartialInfo, double *signal) {
+    double sampleNum = signalPartialInfo.sampleRate * signalPartialInfo.duration;
+    int    length    = partialSignalLength(signalPartialInfo);
+    double dt        = 1.0 / signalPartialInfo.sampleRate;
+    double cycle0    = signalPartialInfo.phase / (2 * M_PI); // phase in cycles
+    double scale     = signalPartialInfo.amplitude / 2;
 
     switch (signalPartialInfo.type) {
         case SIG_SIN: {
-            for (int i = 0; i < sampleNum; i++) {
-                tempdata = (double) (sin(phase) * signalPartialInfo.amplitude / 2);
-                signalVecTemp.push_back(tempdata);
-                phase += 2 * M_PI * signalPartialInfo.frequency0 * dt;
-                if (phase > 2 * M_PI) {
-                    phase -= 2 * M_PI;
-                }
-            }
+            fillTone(signal, length, cycle0, signalPartialInfo.frequency0 * dt, scale);
             break;
         }
 
         case SIG_COS: {
-            for (int i = 0; i < sampleNum; i++) {
-                tempdata = (double) (cos(phase) * signalPartialInfo.amplitude / 2);
-                signalVecTemp.push_back(tempdata);
-                phase += 2 * M_PI * signalPartialInfo.frequency0 * dt;
-                if (phase > 2 * M_PI) {
-                    phase -= 2 * M_PI;
-                }
-            }
+            fillTone(signal, length, cycle0 + 0.25, signalPartialInfo.frequency0 * dt, scale);
             break;
         }
 
-        case SIG_CHRIP: {
-            double k             = (signalPartialInfo.frequency1 - signalPartialInfo.frequency0) / (sampleNum - 1);
-            double initialPhase  = 2 * M_PI * signalPartialInfo.frequency0 * dt; // Calculate initial phase offset
-            phase               += initialPhase;                                 // From a non-zero phase
-
-            for (int i = 0; i < sampleNum; i++) {
-                double currentFrequency = signalPartialInfo.frequency0 + k * i;
-                tempdata                = (double) (sin(phase) * signalPartialInfo.amplitude / 2);
-                signalVecTemp.push_back(tempdata);
-                phase += 2 * M_PI * currentFrequency * dt;
-                if (phase > 2 * M_PI) {
-                    phase -= 2 * M_PI;
-                }
+        case SIG_CHRIP:
+        case SIG_CHRIP_HANN:
+        case SIG_CHRIP_TUKEY: {
+            double k = length > 1 ? (signalPartialInfo.frequency1 - signalPartialInfo.frequency0) / (sampleNum - 1) : 0;
+            fillChirp(signal, length, cycle0, signalPartialInfo.frequency0 * dt, k * dt, scale);
+            if (signalPartialInfo.type == SIG_CHRIP_HANN) {
+                applyTukeyWindow(signal, length, 1.0);
+            } else if (signalPartialInfo.type == SIG_CHRIP_TUKEY) {
+                applyTukeyWindow(signal, length, signalPartialInfo.taper);
             }
             break;
         }
         case SIG_ZERO: {
-            signalVecTemp.resize(sampleNum, 0);
+            std::fill(signal, signal + length, 0.0);
             break;
         }
         case SIG_RISING: {
-            signalVecTemp.resize(sampleNum, signalPartialInfo.amplitude / 2);
+            std::fill(signal, signal + length, signalPartialInfo.amplitude / 2);
             break;
         }
         case SIG_FALLING: {
-            signalVecTemp.resize(sampleNum, -signalPartialInfo.amplitude / 2);
+            std::fill(signal, signal + length, -signalPartialInfo.amplitude / 2);
             break;
         }
         default: {
@@ -165,5 +245,4 @@ std::vector<double> SignalGenerator::generatePartialSignal(SIGNAL_PARTIAL signal
             break;
         }
     }
-    return signalVecTemp;
-}
\ No newline at end of file
+}
@@ -12,6 +12,8 @@
 #ifndef _SIGNALGENERATOR_H_
 #define _SIGNALGENERATOR_H_
 
+#include <Eigen/Core>
+#include <list>
 #include <stdio.h>
 #include <string>
 #include <vector>
@@ -19,7 +21,17 @@
 #include "../config/defineconfig.h"
 #include "../fileio/filesaver.h"
 
-enum SIGNAL_TYPE { SIG_SIN, SIG_COS, SIG_RISING, SIG_FALLING, SIG_CHRIP, SIG_ZERO, SIG_UNKNOWN };
+enum SIGNAL_TYPE {
+    SIG_SIN,
+    SIG_COS,
+    SIG_RISING,
+    SIG_FALLING,
+    SIG_CHRIP,
+    SIG_ZERO,
+    SIG_CHRIP_HANN,  // chirp under a Hann window
+    SIG_CHRIP_TUKEY, // chirp under a Tukey window, see SIGNAL_PARTIAL::taper
+    SIG_UNKNOWN
+};
 
 std::string signalTypeToString(SIGNAL_TYPE type);
 
@@ -31,8 +43,12 @@ typedef struct SIGNAL_PARTIAL {
     double      amplitude;  // amplitude
     double      phase;      // phase
     double      duration;   // duration
+    double      taper;      // Tukey window: fraction of the duration inside the two cosine tapers (0~1)
 } SIGNAL_PARTIAL;
 
+// samples aligned for SIMD loads and stores
+typedef std::vector<double, Eigen::aligned_allocator<double>> AlignedSignal;
+
 /***
  * @description: create partial signal
  * @param {SIGNAL_TYPE} type    signal type
@@ -42,11 +58,18 @@ typedef struct SIGNAL_PARTIAL {
  * @param {double} amplitude    amplitude (e.g. +-5 volt, the amplitude is 10)
  * @param {double} phase        phase
  * @param {double} duration     signal duration (sec)
+ * @param {double} taper        Tukey taper ratio (only used by SIG_CHRIP_TUKEY)
  * @return {*}
  */
 SIGNAL_PARTIAL createPartialSignal(SIGNAL_TYPE type, double sampleRate, double frequency0, double frequency1,
-                                   double amplitude, double phase, double duration);
+                                   double amplitude, double phase, double duration, double taper = 0);
 
+/***
+ * @description: Waveform synthesis. Every partial signal is written straight into one aligned buffer, the phase of
+ * each sample is evaluated in closed form (no accumulated phase) and the sine is a branch free polynomial, so the
+ * sample loops vectorize. Generated waveforms are cached by their partial signal list, selecting a waveform that
+ * was generated before (e.g. switching between beacon codes) costs a lookup.
+ */
 class SignalGenerator {
 public: // public functions
     /***
@@ -64,8 +87,14 @@ public: // public functions
     SignalGenerator(double samplerate, double duration);
     ~SignalGenerator() = default;
 
+    // drop the partial signal list and the cached waveforms
     void init();
 
+    // drop the partial signal list, the cached waveforms are kept
+    void clearSignal() {
+        signalPartials_.clear();
+    }
+
     /***
      * @description: add a partial signal config to the signal generator
      * @param {SIGNAL_PARTIAL} signalPartialInfo    partial signal config
@@ -81,7 +110,9 @@ public: // public functions
     void addSignal(std::vector<SIGNAL_PARTIAL> signalPartialInfos);
 
     /***
-     * @description: generate analog output signal
+     * @description: generate analog output signal, or take it from the cache when the same partial signal list was
+     * generated before. The array is owned by the generator and stays valid until the generator is destroyed, init()
+     * is called or WAVEFORM_CACHE_SIZE other waveforms have been generated since it was last used.
      * @return {*}  signal array
      */
     double *generateSignal();
@@ -102,16 +133,34 @@ public: // public functions
         return signalLength_;
     }
 
+    // number of waveforms kept in the cache
+    static const int WAVEFORM_CACHE_SIZE = 8;
+
 private: // private functions
+    /***
+     * @description: number of samples of a partial signal (the oscillators run while i < sampleRate * duration,
+     * the constant segments truncate it)
+     * @param {SIGNAL_PARTIAL} &signalPartialInfo   partial signal config
+     * @return {int}    sample number
+     */
+    static int partialSignalLength(const SIGNAL_PARTIAL &signalPartialInfo);
+
     /***
      * @description: generate partial signal through the partial signal config
-     * @param {SIGNAL_PARTIAL} signalPartialInfo    partial signal config
-     * @return {*}  partial signal array
+     * @param {SIGNAL_PARTIAL} &signalPartialInfo   partial signal config
+     * @param {double} *signal                      output, partialSignalLength() samples
+     * @return {*}
      */
-    std::vector<double> generatePartialSignal(SIGNAL_PARTIAL signalPartialInfo);
+    void generatePartialSignal(const SIGNAL_PARTIAL &signalPartialInfo, double *signal);
+
+    typedef struct CachedWaveform {
+        std::vector<SIGNAL_PARTIAL> signalPartials;
+        AlignedSignal               signal;
+    } CachedWaveform;
 
 private: // private parameters
-    std::vector<double>         signalVec_;
+    std::list<CachedWaveform>   waveformCache_; // most recently used first
+    AlignedSignal              *signalVec_ = nullptr;
     std::vector<SIGNAL_PARTIAL> signalPartials_;
 
     FileSaver filesaver_;
@@ -146,6 +195,12 @@ inline std::string signalTypeToString(SIGNAL_TYPE type) {
         case SIG_FALLING:
             return "SIG_FALLING";
             break;
+        case SIG_CHRIP_HANN:
+            return "SIG_CHRIP_HANN";
+            break;
+        case SIG_CHRIP_TUKEY:
+            return "SIG_CHRIP_TUKEY";
+            break;
         default:
             return "SIG_UNKNOWN";
             break;
@@ -153,7 +208,7 @@ inline std::string signalTypeToString(SIGNAL_TYPE type) {
 }
 
 inline SIGNAL_PARTIAL createPartialSignal(SIGNAL_TYPE type, double sampleRate, double frequency0, double frequency1,
-                                          double amplitude, double phase, double duration) {
+                                          double amplitude, double phase, double duration, double taper) {
     SIGNAL_PARTIAL signalPartial;
     signalPartial.type       = type;
     signalPartial.sampleRate = sampleRate;
@@ -162,6 +217,7 @@ inline SIGNAL_PARTIAL createPartialSignal(SIGNAL_TYPE type, double sampleRate, d
     signalPartial.amplitude  = amplitude;
     signalPartial.phase      = phase;
     signalPartial.duration   = duration;
+    signalPartial.taper      = taper;
     return signalPartial;
 }
 
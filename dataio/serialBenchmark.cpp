@@ -0,0 +1,163 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 16:48:31
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 16:48:31
+ * @FilePath: /Raspi2USBL/dataio/serialBenchmark.cpp
+ * @Description: See serialBenchmark.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "serialBenchmark.h"
+#include "posResSender.h"
+#include "serialDriver.h"
+#include "serialWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+typedef std::chrono::steady_clock Clock;
+
+const int SENTENCE_NUM = 2000;
+
+// the master side of a pty pair, drained by its own thread
+class PtyReader {
+public:
+    PtyReader() {
+        fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd_ >= 0 && grantpt(fd_) == 0 && unlockpt(fd_) == 0) {
+            slaveName_ = ptsname(fd_);
+            thread_    = std::thread(&PtyReader::readLoop, this);
+        }
+    }
+    ~PtyReader() {
+        stop_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    const std::string &slaveName() const { return slaveName_; }
+
+private:
+    void readLoop() {
+        uint8_t buffer[4096];
+        while (!stop_) {
+            struct pollfd pfd = {fd_, POLLIN, 0};
+            if (::poll(&pfd, 1, 10) > 0) {
+                if (::read(fd_, buffer, sizeof(buffer)) < 0 && errno != EAGAIN && errno != EINTR) {
+                    break;
+                }
+            }
+        }
+    }
+
+    int               fd_ = -1;
+    std::string       slaveName_;
+    std::atomic<bool> stop_{false};
+    std::thread       thread_;
+};
+
+// producer time per sentence: mean and max (us)
+struct ProducerTime {
+    double sumUs = 0;
+    double maxUs = 0;
+};
+
+// burst sentences back to back, one burst per period
+void sendSentences(const std::function<void()> &send, int burst, std::chrono::milliseconds period, ProducerTime &time) {
+    Clock::time_point next = Clock::now();
+    for (int i = 0; i < SENTENCE_NUM; i++) {
+        if (i % burst == 0) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+        Clock::time_point start = Clock::now();
+        send();
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        time.sumUs += us;
+        time.maxUs = std::max(time.maxUs, us);
+    }
+}
+
+void printProducer(const std::string &name, const ProducerTime &time, uint64_t writeNum) {
+    std::cout << termColor("blue") << std::left << std::setw(30) << name << termColor("yellow") << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10) << time.sumUs / SENTENCE_NUM << " us"
+              << std::setw(10) << time.maxUs << " us max" << std::setw(10) << writeNum << " writes"
+              << termColor("nocolor") << std::endl;
+}
+
+void printWriter(const SerialWriterStats &stats) {
+    std::cout << termColor("blue") << std::left << std::setw(30) << "  written" << termColor("yellow") << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10) << stats.meanLatencyUs << " us"
+              << std::setw(10) << stats.maxLatencyUs << " us max" << std::setw(10) << stats.maxQueueDepth
+              << " queued" << std::setw(6) << stats.framesDropped << " dropped" << termColor("nocolor") << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+} // namespace
+
+void benchmarkSerialWriter(SystemInfo &systemInfo) {
+    const DataIOInfo &dataIOInfo = systemInfo.dataIOInfo;
+
+    PositionResult result = PositionResult();
+    result.tof            = 0.123456;
+    result.doa            = 123.456;
+    PosResSender sender(systemInfo);
+    std::string  sentence = sender.data2OutputString(result);
+
+    std::cout << termColor("blue") << "Serial benchmark: " << termColor("yellow") << SENTENCE_NUM << " sentences of "
+              << sentence.size() << " bytes on a pty pair" << termColor("nocolor") << std::endl;
+
+    try {
+        for (bool isBurst : {false, true}) {
+            // a fix per ms, or 8 sentences every 10 ms
+            int                       burst  = isBurst ? std::min(8, dataIOInfo.outputQueueDepth) : 1;
+            std::chrono::milliseconds period = std::chrono::milliseconds(isBurst ? 10 : 1);
+            std::string               mode   = isBurst ? " (burst)" : " (paced)";
+
+            // byte by byte, one write() per character on the blocking port
+            {
+                PtyReader    reader;
+                SerialDriver serial;
+                serial.open(reader.slaveName(), dataIOInfo.outputPortBaudrate);
+                ProducerTime time;
+                sendSentences(
+                    [&] {
+                        for (char ch : sentence) {
+                            serial.writeByte(static_cast<uint8_t>(ch));
+                        }
+                    },
+                    burst, period, time);
+                printProducer("writeByte" + mode, time, static_cast<uint64_t>(SENTENCE_NUM) * sentence.size());
+                serial.close();
+            }
+
+            // serial writer, one frame per sentence
+            {
+                PtyReader    reader;
+                SerialDriver serial;
+                serial.open(reader.slaveName(), dataIOInfo.outputPortBaudrate);
+                SerialWriter writer(serial, dataIOInfo.outputQueueDepth, dataIOInfo.outputWriteTimeout);
+                writer.start("Serial Benchmark", systemInfo.threadPolicyInfo.dspOutput,
+                             systemInfo.threadPolicyInfo.prefaultStackSize);
+                ProducerTime time;
+                sendSentences([&] { writer.write(sentence); }, burst, period, time);
+                writer.stop();
+                SerialWriterStats stats = writer.getStats();
+                printProducer("SerialWriter" + mode, time, stats.batchNum);
+                printWriter(stats);
+                serial.close();
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << termColor("red") << "Serial benchmark: " << e.what() << termColor("nocolor") << std::endl;
+    }
+}
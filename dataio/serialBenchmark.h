@@ -0,0 +1,29 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 16:48:31
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 16:48:31
+ * @FilePath: /Raspi2USBL/dataio/serialBenchmark.h
+ * @Description: Benchmark of the serial output paths on a pty pair, run in benchmark mode
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _SERIALBENCHMARK_H_
+#define _SERIALBENCHMARK_H_
+
+#include "../core/systeminfo.h"
+
+/***
+ * @description: Send $USBL sentences through a pty pair standing in for the output port (benchmark mode, see
+ * runBenchmarks(); a reader thread drains the master side) and print, for the byte-by-byte path
+ * (SerialDriver::writeByte() per character) and the SerialWriter: the producer time per sentence (mean / max), the
+ * write calls, and for the writer the latency until a sentence is written (mean / max), the largest queue depth and
+ * the dropped sentences.
+ * Sentences are sent once per ms (paced) and 8 back to back every 10 ms (burst).
+ * @param {SystemInfo} &systemInfo
+ * @return {*}
+ */
+void benchmarkSerialWriter(SystemInfo &systemInfo);
+
+#endif // _SERIALBENCHMARK_H_
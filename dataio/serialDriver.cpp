@@ -157,6 +157,9 @@ bool SerialDriver::readHexByte(std::string &hexString) {
 
 int SerialDriver::readBytes(uint8_t *buffer, const unsigned int packetsize) {
     int bytes_read = ::read(file_handle_, buffer, packetsize);
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0; // nothing received yet (non-blocking)
+    }
     if (bytes_read < 0) {
         throw std::runtime_error{"ReadPacket error: " + std::string{strerror(errno)}};
     }
@@ -180,6 +183,15 @@ int SerialDriver::readHexBytes(std::string &hexString, const unsigned int packet
     return bytes_read; // return the number of bytes read
 }
 
+bool SerialDriver::waitForInput(int timeoutMs) {
+    struct pollfd pfd = {file_handle_, POLLIN, 0};
+    int           ret = ::poll(&pfd, 1, timeoutMs);
+    if (ret < 0 && errno != EINTR) {
+        throw std::runtime_error{"WaitForInput error: " + std::string{strerror(errno)}};
+    }
+    return ret > 0;
+}
+
 std::string SerialDriver::readString() {
     std::string data;
     char        buffer[256];
@@ -204,28 +216,46 @@ std::string SerialDriver::readString() {
     return data;
 }
 
-bool SerialDriver::writeByte(uint8_t byte) {
-    const int maxRetries = 5;
-    int       retries    = 0;
-    while (retries < maxRetries) {
-        int bytes_written = ::write(file_handle_, &byte, 1);
-        if (bytes_written < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-                // These errors might be temporary, so retry
-                std::cerr << "WriteByte error: " << strerror(errno) << ". Retrying... (" << retries + 1 << "/"
-                          << maxRetries << ")" << std::endl;
-                retries++;
-                std::this_thread::sleep_for(std::chrono::seconds(1)); // Wait before retrying
-            } else {
-                // Other errors are likely permanent, so throw an exception
-                throw std::runtime_error{"WriteByte error: " + std::string{strerror(errno)}};
-            }
-        } else {
-            return bytes_written == 1; // Write successful
+bool SerialDriver::setNonBlocking(bool isNonBlocking) {
+    int flags = fcntl(file_handle_, F_GETFL);
+    if (flags < 0) {
+        return false;
+    }
+    flags = isNonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(file_handle_, F_SETFL, flags) == 0;
+}
+
+size_t SerialDriver::writeBytes(const uint8_t *buffer, size_t length, int timeoutMs) {
+    auto   deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    size_t written  = 0;
+    while (written < length) {
+        ssize_t bytes_written = ::write(file_handle_, buffer + written, length - written);
+        if (bytes_written > 0) {
+            written += bytes_written;
+            continue;
+        }
+        if (bytes_written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw std::runtime_error{"WriteBytes error: " + std::string{strerror(errno)}};
+        }
+        // the output buffer of the driver is full, wait until it drains a little
+        auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            break;
+        }
+        struct pollfd pfd = {file_handle_, POLLOUT, 0};
+        if (::poll(&pfd, 1, static_cast<int>(remaining)) < 0 && errno != EINTR) {
+            throw std::runtime_error{"WriteBytes error: " + std::string{strerror(errno)}};
         }
     }
-    // If we exhaust retries, throw an error
-    throw std::runtime_error{"WriteByte error: Resource temporarily unavailable after multiple retries"};
+    return written;
+}
+
+bool SerialDriver::writeByte(uint8_t byte) {
+    return writeBytes(&byte, 1) == 1;
 }
 
 bool SerialDriver::writeHexString(const std::string &hex_string) {
@@ -235,19 +265,24 @@ bool SerialDriver::writeHexString(const std::string &hex_string) {
         return false;
     }
 
-    // Iterate over the HEX string, converting each two characters to one byte
-    for (size_t i = 0; i < hex_string.length(); i += 2) {
-        std::string byte_string = hex_string.substr(i, 2); // Get two characters
-
-        // Convert the two-character hexadecimal string to a byte
-        uint8_t byte = static_cast<uint8_t>(std::stoi(byte_string, nullptr, 16));
-
-        // Call the existing writeByte function to send the byte
-        if (!writeByte(byte)) {
-            return false;
+    // Convert every two characters to one byte, then send the whole command with one write
+    auto hexValue = [](char ch) {
+        if (ch >= '0' && ch <= '9') {
+            return ch - '0';
+        }
+        if (ch >= 'a' && ch <= 'f') {
+            return ch - 'a' + 10;
+        }
+        if (ch >= 'A' && ch <= 'F') {
+            return ch - 'A' + 10;
         }
+        throw std::invalid_argument("Invalid HEX character: " + std::string(1, ch));
+    };
+    std::vector<uint8_t> bytes(hex_string.length() / 2);
+    for (size_t i = 0; i < bytes.size(); i++) {
+        bytes[i] = static_cast<uint8_t>(hexValue(hex_string[2 * i]) << 4 | hexValue(hex_string[2 * i + 1]));
     }
-    return true;
+    return writeBytes(bytes.data(), bytes.size()) == bytes.size();
 }
 
 bool SerialDriver::flush() {
@@ -16,10 +16,12 @@
 #include <fcntl.h>
 #include <iomanip>
 #include <iostream>
+#include <poll.h>
 #include <string.h>
 #include <termio.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "../config/defineconfig.h"
 class SerialDriver {
@@ -34,21 +36,36 @@ public:
 
     void        open(const std::string &serial_port_name, const std::string &baudrate);
     bool        isOpen() const;
+    // writes return EAGAIN instead of blocking when the output buffer of the driver is full, reads return 0 bytes
+    bool        setNonBlocking(bool isNonBlocking);
     // read
     bool        readByte(uint8_t &byte);
     bool        readHexByte(std::string &hexString);
     int         readBytes(uint8_t *buffer, const unsigned int packetsize);
     int         readHexBytes(std::string &hexString, const unsigned int packetsize);
+    // wait until bytes can be read, at most timeoutMs; false on timeout
+    bool        waitForInput(int timeoutMs);
     // int readString(char* buffer, const unsigned int buffer_size);
     std::string readString();
     // write
     bool        writeByte(uint8_t byte);
     bool        writeHexString(const std::string &hex_string);
+    /***
+     * @description: Write a buffer with as few write() calls as the driver allows: partial writes are continued and a
+     * full output buffer (EAGAIN) is waited out with poll(), at most timeoutMs in total
+     * @param {uint8_t} *buffer
+     * @param {size_t} length
+     * @param {int} timeoutMs
+     * @return {size_t} bytes written, less than length on timeout; throws on a write error
+     */
+    size_t      writeBytes(const uint8_t *buffer, size_t length, int timeoutMs = WRITE_TIMEOUT_MS);
     bool        flush();
     void        close();
 
+    static const int WRITE_TIMEOUT_MS = 1000; // default of writeBytes(), writeByte() and writeHexString()
+
 private:
-    int            file_handle_;
+    int            file_handle_ = -1;
     struct termios config_;
 };
 
@@ -0,0 +1,139 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 16:12:08
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 16:12:08
+ * @FilePath: /Raspi2USBL/dataio/serialWriter.cpp
+ * @Description: See serialWriter.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "serialWriter.h"
+#include "../tool/ColorParse.h"
+#include "../tool/ThreadPolicy.h"
+#include <algorithm>
+
+SerialWriter::SerialWriter(SerialDriver &serial, int queueDepth, int writeTimeoutMs)
+    : serial_(serial)
+    , queueDepth_(queueDepth > 0 ? queueDepth : 1)
+    , writeTimeoutMs_(writeTimeoutMs) {
+    if (!serial_.setNonBlocking(true)) {
+        std::cerr << termColor("red") << "SerialWriter: the port can not be switched to non-blocking"
+                  << termColor("nocolor") << std::endl;
+    }
+}
+
+SerialWriter::~SerialWriter() {
+    stop();
+}
+
+void SerialWriter::start(const std::string &name, const ThreadSchedInfo &sched, size_t prefaultStackSize) {
+    thread_ = std::thread([this, name, sched, prefaultStackSize] {
+        applyThreadPolicy(name, sched, prefaultStackSize);
+        writeLoop();
+    });
+}
+
+void SerialWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopped_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool SerialWriter::write(const uint8_t *data, size_t length) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (stopped_) {
+        return false;
+    }
+    if (queue_.size() >= queueDepth_) {
+        spare_.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+        stats_.framesDropped++;
+    }
+    Frame frame;
+    if (!spare_.empty()) {
+        frame = std::move(spare_.back());
+        spare_.pop_back();
+    }
+    frame.data.assign(data, data + length);
+    frame.time = Clock::now();
+    queue_.push_back(std::move(frame));
+    stats_.framesQueued++;
+    stats_.maxQueueDepth = std::max(stats_.maxQueueDepth, queue_.size());
+    cond_.notify_one();
+    return true;
+}
+
+bool SerialWriter::write(const std::string &frame) {
+    return write(reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+}
+
+SerialWriterStats SerialWriter::getStats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    SerialWriterStats           stats = stats_;
+    stats.queueDepth                  = queue_.size();
+    stats.meanLatencyUs               = stats_.framesWritten > 0 ? latencySumUs_ / stats_.framesWritten : 0;
+    return stats;
+}
+
+void SerialWriter::writeLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            // the written frames go back to the spare buffers
+            for (Frame &frame : batch_) {
+                spare_.push_back(std::move(frame));
+            }
+            batch_.clear();
+            cond_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                break;
+            }
+            for (Frame &frame : queue_) {
+                batch_.push_back(std::move(frame));
+            }
+            queue_.clear();
+        }
+
+        // the whole batch in one buffer, so the driver sees a single write
+        buffer_.clear();
+        for (const Frame &frame : batch_) {
+            buffer_.insert(buffer_.end(), frame.data.begin(), frame.data.end());
+        }
+        size_t written = 0;
+        bool   isError = false;
+        try {
+            written = serial_.writeBytes(buffer_.data(), buffer_.size(), writeTimeoutMs_);
+        } catch (const std::exception &e) {
+            isError = true;
+            if (stats_.errorNum == 0) {
+                std::cerr << termColor("red") << "SerialWriter: " << e.what() << termColor("nocolor") << std::endl;
+            }
+        }
+        Clock::time_point now = Clock::now();
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        stats_.batchNum++;
+        stats_.bytesWritten += written;
+        stats_.errorNum += isError ? 1 : 0;
+        stats_.timeoutNum += (!isError && written < buffer_.size()) ? 1 : 0;
+        size_t end = 0;
+        for (const Frame &frame : batch_) {
+            end += frame.data.size();
+            if (end > written) {
+                stats_.framesDropped++; // not or only partly written
+                continue;
+            }
+            double latencyUs = std::chrono::duration<double, std::micro>(now - frame.time).count();
+            latencySumUs_ += latencyUs;
+            stats_.maxLatencyUs = std::max(stats_.maxLatencyUs, latencyUs);
+            stats_.framesWritten++;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 16:12:08
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 16:12:08
+ * @FilePath: /Raspi2USBL/dataio/serialWriter.h
+ * @Description: Buffered serial writer: frames are queued by the producers and written in batches by its own thread
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _SERIALWRITER_H_
+#define _SERIALWRITER_H_
+
+#include "../core/systeminfo.h"
+#include "serialDriver.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// counters of a SerialWriter, see SerialWriter::getStats()
+typedef struct SerialWriterStats {
+    uint64_t framesQueued  = 0;
+    uint64_t framesWritten = 0; // written completely
+    uint64_t framesDropped = 0; // queue full (oldest frame) or write timeout
+    uint64_t bytesWritten  = 0;
+    uint64_t batchNum      = 0; // writeBytes() calls, each takes every frame queued at the time
+    uint64_t timeoutNum    = 0; // batches the driver did not take within the write timeout
+    uint64_t errorNum      = 0; // batches lost to a write error
+    size_t   queueDepth    = 0; // frames waiting now
+    size_t   maxQueueDepth = 0;
+    double   meanLatencyUs = 0; // from write() to the end of its batch, over the frames written
+    double   maxLatencyUs  = 0;
+} SerialWriterStats;
+
+/***
+ * @description: Decouples the producers from the serial port: write() copies the frame into the queue and returns,
+ * the writer thread takes every queued frame at once and hands them to the driver with one writeBytes() (one write()
+ * unless the driver takes only part of it). The port is switched to non-blocking, a full output buffer is waited out
+ * with poll() for at most writeTimeoutMs, then the rest of the batch is dropped. When queueDepth frames are waiting
+ * the oldest one is dropped: a stale position fix is worth less than the new one.
+ */
+class SerialWriter {
+public:
+    SerialWriter() = delete;
+    /***
+     * @param {SerialDriver} &serial    An open port, shared with readers (the reads become non-blocking too)
+     * @param {int} queueDepth          Frames waiting at most
+     * @param {int} writeTimeoutMs      Time the driver gets for one batch
+     */
+    SerialWriter(SerialDriver &serial, int queueDepth, int writeTimeoutMs);
+    ~SerialWriter();
+
+    SerialWriter(const SerialWriter &)            = delete;
+    SerialWriter &operator=(const SerialWriter &) = delete;
+
+    // start the writer thread, name and policy as in applyThreadPolicy()
+    void start(const std::string &name, const ThreadSchedInfo &sched, size_t prefaultStackSize);
+    // write the frames still queued, then stop the thread
+    void stop();
+
+    // queue one frame, never waits for the port; false after stop()
+    bool write(const uint8_t *data, size_t length);
+    bool write(const std::string &frame);
+
+    SerialWriterStats getStats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Frame {
+        std::vector<uint8_t> data;
+        Clock::time_point    time; // queued
+    };
+
+    void writeLoop();
+
+    SerialDriver &serial_;
+    size_t        queueDepth_;
+    int           writeTimeoutMs_;
+
+    mutable std::mutex      mtx_;
+    std::condition_variable cond_;
+    std::deque<Frame>       queue_;
+    std::vector<Frame>      spare_; // buffers of written frames, reused by write()
+    bool                    stopped_ = false;
+    SerialWriterStats       stats_;
+    double                  latencySumUs_ = 0;
+
+    std::vector<Frame>   batch_;  // writer thread only
+    std::vector<uint8_t> buffer_; // the batch in one piece
+    std::thread          thread_;
+};
+
+#endif // _SERIALWRITER_H_
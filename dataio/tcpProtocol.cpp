@@ -0,0 +1,608 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 10:12:36
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 10:12:36
+ * @FilePath: /Raspi2USBL/dataio/tcpProtocol.cpp
+ * @Description: See tcpProtocol.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "tcpProtocol.h"
+#include "thread_tcpComm.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+// values of a product, a run of doubles each
+typedef std::vector<std::pair<const double *, size_t>> Segments;
+
+uint32_t allChannels(int channelNum) {
+    return channelNum >= 32 ? 0xFFFFFFFFu : (1u << channelNum) - 1;
+}
+
+void writeSubscription(uint8_t *buffer, const TcpSubscription &subscription) {
+    int offset = 0;
+    memcpy(buffer + offset, &subscription.product, sizeof(subscription.product));
+    offset += sizeof(subscription.product);
+    memcpy(buffer + offset, &subscription.encoding, sizeof(subscription.encoding));
+    offset += sizeof(subscription.encoding);
+    memcpy(buffer + offset, &subscription.decimation, sizeof(subscription.decimation));
+    offset += sizeof(subscription.decimation);
+    memcpy(buffer + offset, &subscription.channelMask, sizeof(subscription.channelMask));
+    offset += sizeof(subscription.channelMask);
+    memcpy(buffer + offset, &subscription.windowBefore, sizeof(subscription.windowBefore));
+    offset += sizeof(subscription.windowBefore);
+    memcpy(buffer + offset, &subscription.windowAfter, sizeof(subscription.windowAfter));
+}
+
+void readSubscription(const uint8_t *buffer, TcpSubscription &subscription) {
+    int offset = 0;
+    memcpy(&subscription.product, buffer + offset, sizeof(subscription.product));
+    offset += sizeof(subscription.product);
+    memcpy(&subscription.encoding, buffer + offset, sizeof(subscription.encoding));
+    offset += sizeof(subscription.encoding);
+    memcpy(&subscription.decimation, buffer + offset, sizeof(subscription.decimation));
+    offset += sizeof(subscription.decimation);
+    memcpy(&subscription.channelMask, buffer + offset, sizeof(subscription.channelMask));
+    offset += sizeof(subscription.channelMask);
+    memcpy(&subscription.windowBefore, buffer + offset, sizeof(subscription.windowBefore));
+    offset += sizeof(subscription.windowBefore);
+    memcpy(&subscription.windowAfter, buffer + offset, sizeof(subscription.windowAfter));
+}
+
+// every row of a signal, the channels of channelMask only (0: all) from sample firstSample on
+uint32_t channelSegments(const ChannelSignalVector &signal, uint32_t channelMask, int firstSample, int columns,
+                         Segments &segments) {
+    uint32_t sent = 0;
+    for (int i = 0; i < signal.channelNum && i < 32; ++i) {
+        if (channelMask == 0 || (channelMask >> i) & 1u) {
+            segments.emplace_back(signal.channels[i].data() + firstSample, columns);
+            sent |= 1u << i;
+        }
+    }
+    return sent;
+}
+
+// encoded segments of a product frame and what lies in front of them (scales, lengths), owned by the frame
+struct EncodedPayload {
+    std::vector<uint8_t>              prefix;
+    std::vector<std::vector<uint8_t>> segments;
+};
+
+// number and length of the segments of a product packet
+void segmentShape(int product, int rows, int columns, int &segmentNum, int &segmentLength) {
+    bool isColumn = product == PRODUCT_BEAM_PATTERN;
+    segmentNum    = isColumn ? columns : rows;
+    segmentLength = isColumn ? rows : columns;
+}
+
+// bytes in front of the segments and of each value
+int prefixBytes(int encoding) {
+    switch (encoding) {
+        case ENCODING_INT16:
+            return sizeof(float);
+        case ENCODING_DELTA_ZLIB:
+            return sizeof(float) + sizeof(uint32_t);
+        default:
+            return 0;
+    }
+}
+
+int valueBytes(int encoding) {
+    switch (encoding) {
+        case ENCODING_FLOAT64:
+            return sizeof(double);
+        case ENCODING_FLOAT32:
+            return sizeof(float);
+        default:
+            return sizeof(int16_t);
+    }
+}
+
+// IEEE 754 binary16, rounded to nearest even, overflow to infinity
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign      = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    uint32_t magnitude = bits & 0x7FFFFFFFu;
+    if (magnitude >= 0x7F800000u) {
+        // infinity or NaN (kept a quiet NaN)
+        return sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x0200u : 0u);
+    }
+    if (magnitude >= 0x477FF000u) {
+        // rounds to 65520 or more
+        return sign | 0x7C00u;
+    }
+    if (magnitude < 0x38800000u) {
+        // below 2^-14: subnormal half, in units of 2^-24
+        if (magnitude < 0x33000000u) {
+            return sign;
+        }
+        uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+        int      shift    = 126 - static_cast<int>(magnitude >> 23);
+        uint32_t half     = mantissa >> shift;
+        uint32_t rest     = mantissa & ((1u << shift) - 1);
+        uint32_t halfway  = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) {
+            ++half;
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+    // normal: exponent bias 127 -> 15, 23 -> 10 mantissa bits, a carry into the exponent is right
+    uint32_t half = (magnitude - 0x38000000u) >> 13;
+    uint32_t rest = magnitude & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return sign | static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t half) {
+    uint32_t sign     = static_cast<uint32_t>(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    if (exponent == 0) {
+        float value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -value : value;
+    }
+    uint32_t bits = exponent == 0x1Fu ? sign | 0x7F800000u | (mantissa << 13)
+                                      : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// int16 codes of a segment, value = code * scale
+float quantize(const double *data, size_t length, int16_t *codes) {
+    double peak = 0;
+    for (size_t i = 0; i < length; ++i) {
+        peak = std::max(peak, std::abs(data[i]));
+    }
+    float scale = static_cast<float>(peak / 32767.0);
+    if (!(scale > 0) || !std::isfinite(scale)) {
+        std::fill(codes, codes + length, 0);
+        return 0.0f;
+    }
+    double inverse = 1.0 / scale;
+    for (size_t i = 0; i < length; ++i) {
+        double code = std::round(data[i] * inverse);
+        codes[i]    = static_cast<int16_t>(std::min(std::max(code, -32767.0), 32767.0));
+    }
+    return scale;
+}
+
+// delta coding and byte planes of ENCODING_DELTA_ZLIB, in place on one block
+void deltaBlock(const int16_t *codes, int length, uint8_t *bytes) {
+    uint16_t previous = 0;
+    for (int i = 0; i < length; ++i) {
+        uint16_t code  = static_cast<uint16_t>(codes[i]);
+        uint16_t delta    = i == 0 ? code : static_cast<uint16_t>(code - previous);
+        previous          = code;
+        bytes[i]          = static_cast<uint8_t>(delta & 0xFFu);
+        bytes[length + i] = static_cast<uint8_t>(delta >> 8);
+    }
+}
+
+void undeltaBlock(const uint8_t *bytes, int length, int16_t *codes) {
+    uint16_t previous = 0;
+    for (int i = 0; i < length; ++i) {
+        uint16_t delta = static_cast<uint16_t>(bytes[i] | (bytes[length + i] << 8));
+        previous       = i == 0 ? delta : static_cast<uint16_t>(previous + delta);
+        codes[i]       = static_cast<int16_t>(previous);
+    }
+}
+
+// one segment in an encoding other than double, false when zlib fails
+bool encodeSegment(const double *data, size_t length, int encoding, int compressionLevel, uint8_t *prefix,
+                   std::vector<uint8_t> &output) {
+    switch (encoding) {
+        case ENCODING_FLOAT32: {
+            output.resize(length * sizeof(float));
+            float *values = reinterpret_cast<float *>(output.data());
+            for (size_t i = 0; i < length; ++i) {
+                values[i] = static_cast<float>(data[i]);
+            }
+            return true;
+        }
+        case ENCODING_FLOAT16: {
+            output.resize(length * sizeof(uint16_t));
+            for (size_t i = 0; i < length; ++i) {
+                uint16_t half = floatToHalf(static_cast<float>(data[i]));
+                memcpy(output.data() + i * sizeof(half), &half, sizeof(half));
+            }
+            return true;
+        }
+        case ENCODING_INT16: {
+            output.resize(length * sizeof(int16_t));
+            float scale = quantize(data, length, reinterpret_cast<int16_t *>(output.data()));
+            memcpy(prefix, &scale, sizeof(scale));
+            return true;
+        }
+        case ENCODING_DELTA_ZLIB: {
+            std::vector<int16_t> codes(length);
+            std::vector<uint8_t> planes(length * sizeof(int16_t));
+            float                scale = quantize(data, length, codes.data());
+            for (size_t first = 0; first < length; first += DELTA_BLOCK) {
+                int blockLength = static_cast<int>(std::min<size_t>(DELTA_BLOCK, length - first));
+                deltaBlock(codes.data() + first, blockLength, planes.data() + first * sizeof(int16_t));
+            }
+            uLongf compressedLength = compressBound(planes.size());
+            output.resize(compressedLength);
+            if (compress2(output.data(), &compressedLength, planes.data(), planes.size(), compressionLevel) != Z_OK) {
+                return false;
+            }
+            output.resize(compressedLength);
+            uint32_t streamLength = static_cast<uint32_t>(compressedLength);
+            memcpy(prefix, &scale, sizeof(scale));
+            memcpy(prefix + sizeof(scale), &streamLength, sizeof(streamLength));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+} // namespace
+
+bool parseSubscribeRequest(const uint8_t *packet, size_t length, std::vector<TcpSubscription> &subscriptions) {
+    int      packetLength, signalType, channelNum, signalLength;
+    uint32_t checksum;
+    if (length < static_cast<size_t>(TcpSignalType::HEADER_LENGTH) + sizeof(checksum)) {
+        return false;
+    }
+    int offset = 0;
+    memcpy(&packetLength, packet + offset, sizeof(packetLength));
+    offset += sizeof(packetLength);
+    memcpy(&signalType, packet + offset, sizeof(signalType));
+    offset += sizeof(signalType) + sizeof(bool);
+    memcpy(&channelNum, packet + offset, sizeof(channelNum));
+    offset += sizeof(channelNum);
+    memcpy(&signalLength, packet + offset, sizeof(signalLength));
+    offset += sizeof(signalLength);
+
+    if (signalType != TCP_PACKET_SUBSCRIBE || signalLength != SUBSCRIPTION_LENGTH || channelNum < 0 ||
+        channelNum > MAX_SUBSCRIPTIONS ||
+        length != static_cast<size_t>(offset + channelNum * SUBSCRIPTION_LENGTH) + sizeof(checksum) ||
+        packetLength != static_cast<int>(length)) {
+        return false;
+    }
+    memcpy(&checksum, packet + offset + channelNum * SUBSCRIPTION_LENGTH, sizeof(checksum));
+    if (checksum != crc32(0L, packet + offset, channelNum * SUBSCRIPTION_LENGTH)) {
+        return false;
+    }
+
+    subscriptions.resize(channelNum);
+    for (int i = 0; i < channelNum; ++i) {
+        readSubscription(packet + offset + i * SUBSCRIPTION_LENGTH, subscriptions[i]);
+    }
+    return true;
+}
+
+void makeSubscribeRequest(const std::vector<TcpSubscription> &subscriptions, std::vector<uint8_t> &packet) {
+    int entryNum     = static_cast<int>(subscriptions.size());
+    int packetLength = TcpSignalType::HEADER_LENGTH + entryNum * SUBSCRIPTION_LENGTH + sizeof(uint32_t);
+    packet.assign(packetLength, 0);
+
+    int offset = TcpSignalType::serializeHeader(reinterpret_cast<char *>(packet.data()), packetLength,
+                                                TCP_PACKET_SUBSCRIBE, true, entryNum, SUBSCRIPTION_LENGTH);
+    for (int i = 0; i < entryNum; ++i) {
+        writeSubscription(packet.data() + offset + i * SUBSCRIPTION_LENGTH, subscriptions[i]);
+    }
+    uint32_t checksum = crc32(0L, packet.data() + offset, entryNum * SUBSCRIPTION_LENGTH);
+    memcpy(packet.data() + offset + entryNum * SUBSCRIPTION_LENGTH, &checksum, sizeof(checksum));
+}
+
+SUBSCRIBE_STATUS checkSubscription(TcpSubscription &subscription, int channelNum) {
+    uint32_t product = subscription.product;
+    if (product == 0 || (product & (product - 1)) != 0 || (product & ~static_cast<uint32_t>(PRODUCT_ALL)) != 0) {
+        return SUBSCRIBE_UNKNOWN_PRODUCT;
+    }
+    if (subscription.encoding >= ENCODING_UNKNOWN) {
+        return SUBSCRIBE_UNKNOWN_ENCODING;
+    }
+    if (subscription.decimation == 0) {
+        subscription.decimation = 1;
+    }
+    // only the raw samples have a channel subset and a window, the others are cleared so equal requests share frames
+    if (product != PRODUCT_RAW) {
+        subscription.channelMask  = 0;
+        subscription.windowBefore = 0;
+        subscription.windowAfter  = 0;
+        return SUBSCRIBE_OK;
+    }
+    if ((subscription.channelMask & ~allChannels(channelNum)) != 0) {
+        return SUBSCRIBE_INVALID_CHANNEL;
+    }
+    if (subscription.windowBefore < 0 || subscription.windowAfter < 0) {
+        return SUBSCRIBE_INVALID_WINDOW;
+    }
+    return SUBSCRIBE_OK;
+}
+
+tcpServer::Frame makeSubscribeAnswer(const std::vector<TcpSubscription> &subscriptions,
+                                     const std::vector<uint8_t>         &status) {
+    const int                             entryLength = SUBSCRIPTION_LENGTH + 1;
+    int                                   entryNum    = static_cast<int>(subscriptions.size());
+    std::shared_ptr<std::vector<uint8_t>> entries = std::make_shared<std::vector<uint8_t>>(entryNum * entryLength, 0);
+    for (int i = 0; i < entryNum; ++i) {
+        writeSubscription(entries->data() + i * entryLength, subscriptions[i]);
+        (*entries)[i * entryLength + SUBSCRIPTION_LENGTH] = status[i];
+    }
+    uint32_t checksum = crc32(0L, entries->data(), entries->size());
+
+    std::shared_ptr<TcpFrame> frame = std::make_shared<TcpFrame>();
+    int packetLength = static_cast<int>(TcpSignalType::HEADER_LENGTH + entries->size() + sizeof(checksum));
+    frame->headerLength = TcpSignalType::serializeHeader(reinterpret_cast<char *>(frame->header), packetLength,
+                                                         TCP_PACKET_SUBSCRIBE_ANSWER, true, entryNum, entryLength);
+    frame->blocks.emplace_back(entries->data(), entries->size());
+    frame->owner = entries;
+    memcpy(frame->trailer, &checksum, sizeof(checksum));
+    frame->trailerLength = sizeof(checksum);
+    return frame;
+}
+
+tcpServer::Frame makeProductFrame(const std::shared_ptr<const PingProducts> &products,
+                                  const TcpSubscription &subscription, ThreadPool *threadPool, int compressionLevel) {
+    if (!(products->products & subscription.product)) {
+        return nullptr;
+    }
+
+    Segments segments;
+    int      rows        = 0;
+    int      columns     = 0;
+    uint32_t channelMask = 0;
+    int      firstSample = 0;
+    switch (subscription.product) {
+        case PRODUCT_RAW: {
+            const ChannelSignalVector &signal = products->signal;
+            columns                           = signal.signalLength;
+            if ((subscription.windowBefore > 0 || subscription.windowAfter > 0) && !products->tofResult.empty()) {
+                // the window around the earliest arrival, cut at the ends of the ping
+                double tof   = *std::min_element(products->tofResult.begin(), products->tofResult.end());
+                int    index = static_cast<int>(std::lround(tof * products->sampleRate));
+                firstSample  = std::min(std::max(index - subscription.windowBefore, 0), signal.signalLength);
+                columns = std::max(std::min(index + subscription.windowAfter, signal.signalLength) - firstSample, 0);
+            }
+            channelMask = channelSegments(signal, subscription.channelMask, firstSample, columns, segments);
+            rows        = static_cast<int>(segments.size());
+            break;
+        }
+        case PRODUCT_CORRELATION:
+        case PRODUCT_SIDE_AMP_SPEC: {
+            const ChannelSignalVector &signal =
+                subscription.product == PRODUCT_CORRELATION ? products->correlation : products->sideAmpSpec;
+            columns     = signal.signalLength;
+            channelMask = channelSegments(signal, 0, 0, columns, segments);
+            rows        = static_cast<int>(segments.size());
+            break;
+        }
+        case PRODUCT_BEAM_PATTERN: {
+            const Eigen::MatrixXd &beamPattern = products->beamPattern;
+            rows                               = static_cast<int>(beamPattern.rows());
+            columns                            = static_cast<int>(beamPattern.cols());
+            for (int column = 0; column < columns; ++column) {
+                segments.emplace_back(beamPattern.data() + static_cast<size_t>(column) * rows, rows);
+            }
+            break;
+        }
+        case PRODUCT_POSITION: {
+            rows        = 1;
+            columns     = static_cast<int>(products->tofResult.size());
+            channelMask = allChannels(columns);
+            segments.emplace_back(products->tofResult.data(), products->tofResult.size());
+            break;
+        }
+        default:
+            return nullptr;
+    }
+
+    // payload blocks, every segment is encoded and checksummed on its own
+    std::shared_ptr<TcpFrame>       frame      = std::make_shared<TcpFrame>();
+    int                             segmentNum = static_cast<int>(segments.size());
+    std::vector<uLong>              segmentCRC(segmentNum);
+    std::vector<size_t>             segmentBytes(segmentNum);
+    std::shared_ptr<EncodedPayload> payload;
+    if (subscription.encoding != ENCODING_FLOAT64) {
+        payload = std::make_shared<EncodedPayload>();
+        payload->prefix.assign(static_cast<size_t>(segmentNum) * prefixBytes(subscription.encoding), 0);
+        payload->segments.resize(segmentNum);
+    }
+    std::vector<char> isEncoded(segmentNum, 1);
+
+    auto encode = [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const uint8_t *data   = reinterpret_cast<const uint8_t *>(segments[i].first);
+            size_t         length = segments[i].second * sizeof(double);
+            if (payload) {
+                uint8_t *prefix = payload->prefix.data() + i * prefixBytes(subscription.encoding);
+                isEncoded[i]    = encodeSegment(segments[i].first, segments[i].second, subscription.encoding,
+                                                compressionLevel, prefix, payload->segments[i]);
+                data            = payload->segments[i].data();
+                length          = payload->segments[i].size();
+            }
+            segmentCRC[i]   = crc32(0L, data, length);
+            segmentBytes[i] = length;
+        }
+    };
+    if (threadPool != nullptr && segmentNum > 1) {
+        threadPool->parallelFor(0, segmentNum, 1, encode);
+    } else {
+        encode(0, segmentNum);
+    }
+    if (std::find(isEncoded.begin(), isEncoded.end(), 0) != isEncoded.end()) {
+        return nullptr;
+    }
+
+    uLong  checksum    = crc32(0L, Z_NULL, 0);
+    size_t payloadSize = 0;
+    if (payload && !payload->prefix.empty()) {
+        frame->blocks.emplace_back(payload->prefix.data(), payload->prefix.size());
+        checksum    = crc32(checksum, payload->prefix.data(), payload->prefix.size());
+        payloadSize = payload->prefix.size();
+    }
+    for (int i = 0; i < segmentNum; ++i) {
+        const uint8_t *data =
+            payload ? payload->segments[i].data() : reinterpret_cast<const uint8_t *>(segments[i].first);
+        frame->blocks.emplace_back(data, segmentBytes[i]);
+        checksum = crc32_combine(checksum, segmentCRC[i], segmentBytes[i]);
+        payloadSize += segmentBytes[i];
+    }
+    if (payload) {
+        frame->owner = payload;
+    } else {
+        frame->owner = products;
+    }
+
+    // common header and product header in the inline buffer
+    uint32_t checksum32   = static_cast<uint32_t>(checksum);
+    int      packetLength = static_cast<int>(TcpSignalType::HEADER_LENGTH + PRODUCT_HEADER_LENGTH + payloadSize +
+                                             sizeof(checksum32));
+    char    *header       = reinterpret_cast<char *>(frame->header);
+    int      offset = TcpSignalType::serializeHeader(header, packetLength, TCP_PACKET_PRODUCT, true, rows, columns);
+    memcpy(header + offset, &subscription.product, sizeof(subscription.product));
+    offset += sizeof(subscription.product);
+    memcpy(header + offset, &subscription.encoding, sizeof(subscription.encoding));
+    offset += sizeof(subscription.encoding);
+    memcpy(header + offset, &products->seq, sizeof(products->seq));
+    offset += sizeof(products->seq);
+    memcpy(header + offset, &products->sampleIndex, sizeof(products->sampleIndex));
+    offset += sizeof(products->sampleIndex);
+    memcpy(header + offset, &channelMask, sizeof(channelMask));
+    offset += sizeof(channelMask);
+    memcpy(header + offset, &firstSample, sizeof(firstSample));
+    offset += sizeof(firstSample);
+    memcpy(header + offset, &products->tof, sizeof(products->tof));
+    offset += sizeof(products->tof);
+    memcpy(header + offset, &products->doa, sizeof(products->doa));
+    offset += sizeof(products->doa);
+    memcpy(header + offset, &products->gainTag.state, sizeof(products->gainTag.state));
+    offset += sizeof(products->gainTag.state);
+    memcpy(header + offset, &products->gainTag.gainDb, sizeof(products->gainTag.gainDb));
+    offset += sizeof(products->gainTag.gainDb);
+    frame->headerLength = offset;
+
+    memcpy(frame->trailer, &checksum32, sizeof(checksum32));
+    frame->trailerLength = sizeof(checksum32);
+    return frame;
+}
+
+bool decodeProductPacket(const uint8_t *packet, size_t length, TcpProduct &product) {
+    const size_t headerLength = TcpSignalType::HEADER_LENGTH + PRODUCT_HEADER_LENGTH;
+    int          packetLength, signalType;
+    uint32_t     checksum;
+    if (length < headerLength + sizeof(checksum)) {
+        return false;
+    }
+    int offset = 0;
+    memcpy(&packetLength, packet + offset, sizeof(packetLength));
+    offset += sizeof(packetLength);
+    memcpy(&signalType, packet + offset, sizeof(signalType));
+    offset += sizeof(signalType) + sizeof(bool);
+    memcpy(&product.rows, packet + offset, sizeof(product.rows));
+    offset += sizeof(product.rows);
+    memcpy(&product.columns, packet + offset, sizeof(product.columns));
+    offset += sizeof(product.columns);
+    memcpy(&product.product, packet + offset, sizeof(product.product));
+    offset += sizeof(product.product);
+    memcpy(&product.encoding, packet + offset, sizeof(product.encoding));
+    offset += sizeof(product.encoding);
+    memcpy(&product.seq, packet + offset, sizeof(product.seq));
+    offset += sizeof(product.seq);
+    memcpy(&product.sampleIndex, packet + offset, sizeof(product.sampleIndex));
+    offset += sizeof(product.sampleIndex);
+    memcpy(&product.channelMask, packet + offset, sizeof(product.channelMask));
+    offset += sizeof(product.channelMask);
+    memcpy(&product.firstSample, packet + offset, sizeof(product.firstSample));
+    offset += sizeof(product.firstSample);
+    memcpy(&product.tof, packet + offset, sizeof(product.tof));
+    offset += sizeof(product.tof);
+    memcpy(&product.doa, packet + offset, sizeof(product.doa));
+    offset += sizeof(product.doa);
+    memcpy(&product.gainState, packet + offset, sizeof(product.gainState));
+    offset += sizeof(product.gainState);
+    memcpy(&product.gainDb, packet + offset, sizeof(product.gainDb));
+    offset += sizeof(product.gainDb);
+
+    if (signalType != TCP_PACKET_PRODUCT || packetLength != static_cast<int>(length) || product.rows < 0 ||
+        product.columns < 0 || product.encoding >= ENCODING_UNKNOWN) {
+        return false;
+    }
+    const uint8_t *payload     = packet + offset;
+    size_t         payloadSize = length - headerLength - sizeof(checksum);
+    memcpy(&checksum, payload + payloadSize, sizeof(checksum));
+    if (checksum != crc32(0L, payload, payloadSize)) {
+        return false;
+    }
+
+    int segmentNum, segmentLength;
+    segmentShape(product.product, product.rows, product.columns, segmentNum, segmentLength);
+    size_t valueNum    = static_cast<size_t>(segmentNum) * segmentLength;
+    size_t prefixSize  = static_cast<size_t>(segmentNum) * prefixBytes(product.encoding);
+    size_t segmentSize = static_cast<size_t>(segmentLength) * valueBytes(product.encoding);
+    if (payloadSize < prefixSize ||
+        (product.encoding != ENCODING_DELTA_ZLIB && payloadSize != prefixSize + segmentNum * segmentSize)) {
+        return false;
+    }
+    product.values.resize(valueNum);
+
+    const uint8_t       *data = payload + prefixSize;
+    std::vector<int16_t> codes(segmentLength);
+    std::vector<uint8_t> planes(segmentSize);
+    for (int i = 0; i < segmentNum; ++i) {
+        double        *values   = product.values.data() + static_cast<size_t>(i) * segmentLength;
+        const uint8_t *prefix   = payload + static_cast<size_t>(i) * prefixBytes(product.encoding);
+        size_t         consumed = segmentSize;
+        float          scale    = 0;
+        switch (product.encoding) {
+            case ENCODING_FLOAT64:
+                memcpy(values, data, segmentSize);
+                break;
+            case ENCODING_FLOAT32:
+                for (int j = 0; j < segmentLength; ++j) {
+                    float value;
+                    memcpy(&value, data + j * sizeof(value), sizeof(value));
+                    values[j] = value;
+                }
+                break;
+            case ENCODING_FLOAT16:
+                for (int j = 0; j < segmentLength; ++j) {
+                    uint16_t half;
+                    memcpy(&half, data + j * sizeof(half), sizeof(half));
+                    values[j] = halfToFloat(half);
+                }
+                break;
+            case ENCODING_INT16:
+                memcpy(&scale, prefix, sizeof(scale));
+                memcpy(codes.data(), data, segmentSize);
+                for (int j = 0; j < segmentLength; ++j) {
+                    values[j] = codes[j] * static_cast<double>(scale);
+                }
+                break;
+            case ENCODING_DELTA_ZLIB: {
+                uint32_t streamLength;
+                memcpy(&scale, prefix, sizeof(scale));
+                memcpy(&streamLength, prefix + sizeof(scale), sizeof(streamLength));
+                uLongf planeLength = planes.size();
+                if (streamLength > static_cast<size_t>(payload + payloadSize - data) ||
+                    (!planes.empty() && (uncompress(planes.data(), &planeLength, data, streamLength) != Z_OK ||
+                                         planeLength != planes.size()))) {
+                    return false;
+                }
+                for (int first = 0; first < segmentLength; first += DELTA_BLOCK) {
+                    int blockLength = std::min(DELTA_BLOCK, segmentLength - first);
+                    undeltaBlock(planes.data() + first * sizeof(int16_t), blockLength, codes.data() + first);
+                }
+                for (int j = 0; j < segmentLength; ++j) {
+                    values[j] = codes[j] * static_cast<double>(scale);
+                }
+                consumed = streamLength;
+                break;
+            }
+        }
+        data += consumed;
+    }
+    return data == payload + payloadSize;
+}
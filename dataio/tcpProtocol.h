@@ -0,0 +1,179 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 10:12:36
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 10:12:36
+ * @FilePath: /Raspi2USBL/dataio/tcpProtocol.h
+ * @Description: Subscription protocol of the TCP port: packet types, subscribe request / answer and product packets
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _TCPPROTOCOL_H_
+#define _TCPPROTOCOL_H_
+
+#include "../general/typedef.h"
+#include "../tool/ThreadPool.h"
+#include "tcpServer.h"
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+/***
+ * Every packet starts with the common header of TcpSignalType (native byte order, no padding):
+ *     int packetLength | int signalType | bool isInit | int channelNum | int signalLength
+ * and ends with the CRC32 (uint32) of what lies between the header and the checksum.
+ *
+ * A client gets the whole ping (TCP_PACKET_SIGNAL) until it subscribes. A subscribe request replaces all subscriptions
+ * of the client (no entry: nothing but heartbeats), the server answers with the entries and their status:
+ *     request  channelNum = entries, signalLength = SUBSCRIPTION_LENGTH, entries
+ *     answer   channelNum = entries, signalLength = SUBSCRIPTION_LENGTH + 1, entries each followed by its status
+ *     entry    uint8 product | uint8 encoding | uint16 decimation | uint32 channelMask | int32 windowBefore |
+ *              int32 windowAfter
+ * Every accepted subscription yields one product packet per decimation-th ping (ping sequence number % decimation
+ * == 0, so subscriptions with the same decimation get the same pings):
+ *     channelNum = rows, signalLength = columns, then
+ *     uint8 product | uint8 encoding | uint64 seq | uint64 sampleIndex | uint32 channelMask | int32 firstSample |
+ *     double tof | double doa | uint8 gainState | double gainDb
+ * gainState (GAIN_STATE) and gainDb are the receive gain the ping was acquired with; PRODUCT_CORRELATION is
+ * normalized by it (divided by 10^(gainDb / 20)) unless gainState is GAIN_UNKNOWN, the other products are as received.
+ * followed by the rows x columns values, segment after segment:
+ *     PRODUCT_RAW            rows: the channels of channelMask, samples firstSample.. of the ping, as acquired
+ *                            (before the [PreFilter] band-pass)
+ *     PRODUCT_CORRELATION    rows: channels x correlation length
+ *     PRODUCT_SIDE_AMP_SPEC  rows: channels x spectrum length
+ *     PRODUCT_BEAM_PATTERN   columns: the matrix of the beamformer, column after column (Eigen storage order)
+ *     PRODUCT_POSITION       rows: 1 x channels, the TOF of every channel (s); TOF and DOA are in the header
+ * in the encoding of the subscription:
+ *     ENCODING_FLOAT64       double
+ *     ENCODING_FLOAT32       float
+ *     ENCODING_INT16         float scale of every segment, then int16 codes, value = code * scale (scale = largest
+ *                            magnitude of the segment / 32767)
+ *     ENCODING_FLOAT16       IEEE 754 half precision (binary16)
+ *     ENCODING_DELTA_ZLIB    float scale and uint32 compressed length of every segment, then the zlib stream of every
+ *                            segment: the int16 codes (as ENCODING_INT16), delta coded in blocks of DELTA_BLOCK codes
+ *                            (the first code of a block as it is, then the difference to the previous one, modulo
+ *                            2^16), stored as the low bytes of the block followed by the high bytes
+ * decodeProductPacket() is the reference decoder of the client side.
+ */
+
+// signalType of the common header
+enum TCP_PACKET_TYPE {
+    TCP_PACKET_HEARTBEAT          = 0, // server -> client
+    TCP_PACKET_SIGNAL             = 1, // server -> client, all channels of a ping in double
+    TCP_PACKET_PRODUCT            = 2, // server -> client, one subscribed product of a ping
+    TCP_PACKET_SUBSCRIBE          = 3, // client -> server
+    TCP_PACKET_SUBSCRIBE_ANSWER   = 4, // server -> client
+    TCP_PACKET_HEARTBEAT_RESPONSE = 9  // client -> server
+};
+
+// sample encoding of a product packet
+enum TCP_ENCODING {
+    ENCODING_FLOAT64    = 0, // sent straight from the products, no copy
+    ENCODING_FLOAT32    = 1, // 1/2 of the size, about 7 significant digits
+    ENCODING_INT16      = 2, // 1/4 of the size, 16 bit like the ADC, scaled per segment
+    ENCODING_FLOAT16    = 3, // 1/4 of the size, about 3 significant digits over a large range (spectra, beam pattern)
+    ENCODING_DELTA_ZLIB = 4, // ENCODING_INT16 delta coded and compressed, lossless on the int16 codes
+    ENCODING_UNKNOWN
+};
+
+// status of a subscription in the answer
+enum SUBSCRIBE_STATUS {
+    SUBSCRIBE_OK               = 0,
+    SUBSCRIBE_UNKNOWN_PRODUCT  = 1, // not a single PING_PRODUCT bit
+    SUBSCRIBE_UNKNOWN_ENCODING = 2,
+    SUBSCRIBE_INVALID_CHANNEL  = 3, // channelMask names a channel the array does not have
+    SUBSCRIBE_INVALID_WINDOW   = 4  // negative window
+};
+
+typedef struct TcpSubscription {
+    uint8_t  product      = PRODUCT_RAW;      // one PING_PRODUCT bit
+    uint8_t  encoding     = ENCODING_FLOAT64; // TCP_ENCODING
+    uint16_t decimation   = 1;                // every decimation-th ping, 0 is taken as 1
+    uint32_t channelMask  = 0;                // PRODUCT_RAW: bit i sends channel i, 0 sends all
+    int32_t  windowBefore = 0;                // PRODUCT_RAW: samples before the earliest TOF of the channels,
+    int32_t  windowAfter  = 0;                // and after it, both 0 sends the whole ping
+
+    bool operator<(const TcpSubscription &other) const {
+        return std::tie(product, encoding, decimation, channelMask, windowBefore, windowAfter) <
+               std::tie(other.product, other.encoding, other.decimation, other.channelMask, other.windowBefore,
+                        other.windowAfter);
+    }
+} TcpSubscription;
+
+static const int SUBSCRIPTION_LENGTH   = 16;  // bytes of an entry on the wire
+static const int MAX_SUBSCRIPTIONS     = 32;  // entries of a request
+static const int PRODUCT_HEADER_LENGTH = 51;  // bytes of the product header behind the common header
+static const int DELTA_BLOCK           = 256; // codes per delta block of ENCODING_DELTA_ZLIB
+
+// a product packet read back by decodeProductPacket()
+typedef struct TcpProduct {
+    uint8_t             product     = 0;
+    uint8_t             encoding    = 0;
+    uint64_t            seq         = 0;
+    uint64_t            sampleIndex = 0;
+    uint32_t            channelMask = 0;
+    int32_t             firstSample = 0;
+    double              tof         = 0;
+    double              doa         = 0;
+    uint8_t             gainState   = GAIN_UNKNOWN;
+    double              gainDb      = 0;
+    int                 rows        = 0;
+    int                 columns     = 0;
+    std::vector<double> values; // segment after segment, as in the packet
+} TcpProduct;
+
+/***
+ * @description: Read the entries of a subscribe request
+ * @param {uint8_t} *packet                            The whole packet, packetLength bytes
+ * @param {size_t} length                              packetLength
+ * @param {std::vector<TcpSubscription>} &subscriptions The entries
+ * @return {bool} false when the length, the entry number or the checksum is wrong
+ */
+bool parseSubscribeRequest(const uint8_t *packet, size_t length, std::vector<TcpSubscription> &subscriptions);
+
+/***
+ * @description: Build a subscribe request, the client side of parseSubscribeRequest()
+ * @param {std::vector<TcpSubscription>} &subscriptions
+ * @param {std::vector<uint8_t>} &packet                The whole packet
+ * @return {*}
+ */
+void makeSubscribeRequest(const std::vector<TcpSubscription> &subscriptions, std::vector<uint8_t> &packet);
+
+/***
+ * @description: Check a subscription and bring it into its normal form (decimation 0 -> 1)
+ * @param {TcpSubscription} &subscription
+ * @param {int} channelNum                  Channels of the array
+ * @return {SUBSCRIBE_STATUS}
+ */
+SUBSCRIBE_STATUS checkSubscription(TcpSubscription &subscription, int channelNum);
+
+// answer to a subscribe request, one status per entry
+tcpServer::Frame makeSubscribeAnswer(const std::vector<TcpSubscription> &subscriptions,
+                                     const std::vector<uint8_t>         &status);
+
+/***
+ * @description: Product packet of one subscription. In double the values are sent straight from the products (the
+ * frame keeps them alive), the other encodings write every segment into a buffer of the frame. The segments are
+ * encoded and checksummed in parallel on the thread pool, the CRC32 of the packet is combined from theirs.
+ * @param {shared_ptr<const PingProducts>} &products
+ * @param {TcpSubscription} &subscription   A checked subscription
+ * @param {ThreadPool} *threadPool          Encoder workers, nullptr: on the calling thread
+ * @param {int} compressionLevel            zlib level of ENCODING_DELTA_ZLIB (1~9)
+ * @return {tcpServer::Frame} nullptr when the ping does not carry the product
+ */
+tcpServer::Frame makeProductFrame(const std::shared_ptr<const PingProducts> &products,
+                                  const TcpSubscription &subscription, ThreadPool *threadPool = nullptr,
+                                  int compressionLevel = 1);
+
+/***
+ * @description: Reference decoder of a product packet (client side)
+ * @param {uint8_t} *packet         The whole packet, packetLength bytes
+ * @param {size_t} length           packetLength
+ * @param {TcpProduct} &product     The header fields and the decoded values
+ * @return {bool} false when the packet is not a valid product packet (type, lengths, checksum, zlib stream)
+ */
+bool decodeProductPacket(const uint8_t *packet, size_t length, TcpProduct &product);
+
+#endif // _TCPPROTOCOL_H_
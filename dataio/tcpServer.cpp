@@ -1,21 +1,45 @@
 #include "tcpServer.h"
 #include "../config/defineconfig.h"
 #include "../tool/ColorParse.h"
+#include "../tool/ThreadPolicy.h"
+#include <algorithm>
 #include <arpa/inet.h>
+#include <climits>
 #include <cstring>
 #include <errno.h>
 #include <fcntl.h>
+#include <iomanip>
 #include <iostream>
-#include <sys/select.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
-tcpServer::tcpServer(int port)
-    : port(port)
-    , server_fd(-1)
-    , client_fd(-1)
-    , connection_open(false) {
+namespace {
+// epoll tags of the server descriptors, the client sockets are tagged with their id
+const uint64_t LISTEN_TAG         = ~0ULL;
+const uint64_t WAKE_TAG           = ~0ULL - 1;
+const uint64_t TIMER_TAG          = ~0ULL - 2;
+// the event loop also wakes up this often to apply the send timeout
+const int      POLL_INTERVAL_MS   = 50;
+// grace for the response to the last heartbeat before a silent client is closed
+const int      HEARTBEAT_GRACE_MS = 300;
+} // namespace
+
+tcpServer::tcpServer(const TcpInfo &tcpInfo, const ThreadSchedInfo &threadSched, size_t prefaultStackSize)
+    : server_fd(-1)
+    , epoll_fd(-1)
+    , wake_fd(-1)
+    , timer_fd(-1)
+    , tcp_info(tcpInfo)
+    , thread_sched(threadSched)
+    , prefault_stack_size(prefaultStackSize)
+    , stop_flag(false) {
     // create server socket
-    server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd == -1) {
         handleError("socket creation");
         exit(EXIT_FAILURE);
@@ -25,11 +49,20 @@ tcpServer::tcpServer(int port)
     std::memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family      = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port        = htons(port);
+    server_addr.sin_port        = htons(tcp_info.serverPort);
 }
 
 tcpServer::~tcpServer() {
-    closeConnection(); // make sure the connection is closed
+    stop(); // make sure the connections are closed
+    if (timer_fd != -1) {
+        close(timer_fd);
+    }
+    if (wake_fd != -1) {
+        close(wake_fd);
+    }
+    if (epoll_fd != -1) {
+        close(epoll_fd);
+    }
     if (server_fd != -1) {
         close(server_fd);
     }
@@ -53,107 +86,575 @@ bool tcpServer::bindServer() {
     return true;
 }
 
-bool tcpServer::acceptClient(int timeout_ms) {
-    if (listen(server_fd, 1) < 0) {
+bool tcpServer::start() {
+    if (!bindServer()) {
+        return false;
+    }
+    if (listen(server_fd, std::max(tcp_info.maxClients, 4)) < 0) {
         return handleError("listen");
     }
 
-    fd_set         set;
-    struct timeval timeout;
-    FD_ZERO(&set);
-    FD_SET(server_fd, &set);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1) {
+        return handleError("epoll_create1");
+    }
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd == -1) {
+        return handleError("eventfd");
+    }
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1) {
+        return handleError("timerfd_create");
+    }
 
-    timeout.tv_sec  = timeout_ms / 1000;
-    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    struct epoll_event event;
+    event.events   = EPOLLIN;
+    event.data.u64 = LISTEN_TAG;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_fd, &event) < 0) {
+        return handleError("epoll_ctl (listen)");
+    }
+    event.data.u64 = WAKE_TAG;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) < 0) {
+        return handleError("epoll_ctl (wake)");
+    }
+    event.data.u64 = TIMER_TAG;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event) < 0) {
+        return handleError("epoll_ctl (timer)");
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        armHeartbeat(); // set before the start
+    }
 
-    int rv          = select(server_fd + 1, &set, nullptr, nullptr, &timeout);
+    stop_flag   = false;
+    loop_thread = std::thread(&tcpServer::eventLoop, this);
+    return true;
+}
 
-    if (rv == -1) {
-        return handleError("select");
-    } else if (rv == 0) {
-        std::cerr << termColor("red") << "Timeout: No client connected within " << timeout_ms << " milliseconds."
-                  << termColor("nocolor") << std::endl;
-        return false;
+void tcpServer::stop() {
+    stop_flag = true;
+    if (loop_thread.joinable()) {
+        wake();
+        loop_thread.join();
     }
+    closeConnection();
+    conn_cv.notify_all();
+}
 
-    client_fd = accept(server_fd, nullptr, nullptr);
-    if (client_fd < 0) {
-        return handleError("accept");
+void tcpServer::wake() {
+    uint64_t one = 1;
+    if (wake_fd != -1 && write(wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        handleError("eventfd write");
     }
+}
 
-    connection_open = true; // mark the connection is open
-    return true;
+void tcpServer::eventLoop() {
+    applyThreadPolicy("TCP Server", thread_sched, prefault_stack_size);
+
+    std::vector<struct epoll_event> events(std::max(tcp_info.maxClients, 1) + 3);
+    while (!stop_flag) {
+        int eventNum = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), POLL_INTERVAL_MS);
+        if (eventNum < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            handleError("epoll_wait");
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(conn_mutex);
+        for (int i = 0; i < eventNum; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == WAKE_TAG) {
+                uint64_t count;
+                while (read(wake_fd, &count, sizeof(count)) > 0) {
+                }
+                continue;
+            }
+            if (tag == TIMER_TAG) {
+                uint64_t expirations;
+                if (read(timer_fd, &expirations, sizeof(expirations)) > 0) {
+                    sendHeartbeat();
+                }
+                continue;
+            }
+            if (tag == LISTEN_TAG) {
+                acceptClients();
+                continue;
+            }
+            // the client may already be closed by an earlier event of this round
+            auto it = clients.find(static_cast<int>(tag));
+            if (it == clients.end()) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeClient(it->first, "connection lost");
+                continue;
+            }
+            const char *reason = nullptr;
+            if ((events[i].events & EPOLLIN) && !readClient(it->second, reason)) {
+                closeClient(it->first, reason);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !flushClient(it->second)) {
+                closeClient(it->first, "send failed");
+            }
+        }
+
+        // frames queued since the last round, the armed clients are flushed by EPOLLOUT
+        std::vector<int> failed;
+        for (auto &item : clients) {
+            const Client &client    = item.second;
+            bool          isPending = !client.queue.empty() || !client.controls.empty();
+            if (!client.isWriteArmed && isPending && !flushClient(item.second)) {
+                failed.push_back(item.first);
+            }
+        }
+        for (int id : failed) {
+            closeClient(id, "send failed");
+        }
+        checkStalledClients();
+    }
 }
 
-bool tcpServer::start() {
-    if (!bindServer()) {
-        return false;
+void tcpServer::acceptClients() {
+    while (true) {
+        struct sockaddr_in address;
+        socklen_t          addressLength = sizeof(address);
+        int fd = accept4(server_fd, (struct sockaddr *) &address, &addressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                handleError("accept");
+            }
+            return;
+        }
+
+        char ip[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &address.sin_addr, ip, sizeof(ip));
+        std::string peer = std::string(ip) + ":" + std::to_string(ntohs(address.sin_port));
+        if (static_cast<int>(clients.size()) >= tcp_info.maxClients) {
+            std::cerr << termColor("red") << "Refused TCP client " << peer << ", already " << clients.size()
+                      << " clients connected" << termColor("nocolor") << std::endl;
+            close(fd);
+            continue;
+        }
+
+        // small frames (heartbeats) go out at once, the send buffer holds a few pings
+        int opt = 1;
+        if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)) < 0) {
+            handleError("setsockopt TCP_NODELAY");
+        }
+        if (tcp_info.sendBufferSize > 0 &&
+            setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &tcp_info.sendBufferSize, sizeof(tcp_info.sendBufferSize)) < 0) {
+            handleError("setsockopt SO_SNDBUF");
+        }
+
+        int                id = next_client_id++;
+        struct epoll_event event;
+        event.events   = EPOLLIN;
+        event.data.u64 = static_cast<uint64_t>(id);
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            handleError("epoll_ctl (client)");
+            close(fd);
+            continue;
+        }
+
+        Client &client         = clients[id];
+        client.fd              = fd;
+        client.id              = id;
+        client.address         = peer;
+        client.connectTime     = Clock::now();
+        client.lastReceiveTime = client.connectTime;
+        client.headStartTime   = client.connectTime;
+        std::cout << termColor("green") << "TCP client #" << id << " connected from " << peer << " ("
+                  << clients.size() << "/" << tcp_info.maxClients << ")" << termColor("nocolor") << std::endl;
+        conn_cv.notify_all();
+    }
+}
+
+bool tcpServer::readClient(Client &client, const char *&reason) {
+    // heartbeat responses and requests come back, any byte keeps the client alive; a client sending a lot yields to
+    // the others after MAX_READ_PER_EVENT bytes, epoll reports the rest in the next round
+    uint8_t buffer[4096];
+    size_t  budget = MAX_READ_PER_EVENT;
+    while (budget > 0) {
+        ssize_t bytesRead = recv(client.fd, buffer, std::min(sizeof(buffer), budget), 0);
+        if (bytesRead > 0) {
+            client.lastReceiveTime = Clock::now();
+            budget -= bytesRead;
+            if (!receiveBytes(client, buffer, bytesRead, reason)) {
+                return false;
+            }
+            continue;
+        }
+        if (bytesRead == 0) {
+            reason = "disconnected by the client";
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            reason = "receive failed";
+            return false;
+        }
+        break;
     }
     return true;
 }
 
-bool tcpServer::sendVector(const std::vector<uint8_t> &data, int timeout_ms) {
-    std::lock_guard<std::mutex> lock(conn_mutex); // protect the connection resource
+bool tcpServer::receiveBytes(Client &client, const uint8_t *data, size_t length, const char *&reason) {
+    while (length > 0) {
+        // the length field first, then the packet is received in place behind it
+        if (client.received.size() < sizeof(int)) {
+            client.received.resize(sizeof(int));
+        }
+        size_t taken = std::min(length, client.received.size() - client.receivedLength);
+        memcpy(client.received.data() + client.receivedLength, data, taken);
+        client.receivedLength += taken;
+        data += taken;
+        length -= taken;
+        if (client.receivedLength < client.received.size()) {
+            break;
+        }
 
-    if (!connection_open) {
-        std::cerr << termColor("red") << "No open connection. Call waitForConnection first." << termColor("nocolor")
-                  << std::endl;
-        return false;
-    }
+        if (client.receiveState == RECEIVE_LENGTH) {
+            // checked before anything of the packet is buffered
+            int packetLength;
+            memcpy(&packetLength, client.received.data(), sizeof(packetLength));
+            if (packetLength < static_cast<int>(sizeof(packetLength)) || packetLength > MAX_PACKET_LENGTH) {
+                reason = "invalid packet length";
+                return false;
+            }
+            client.received.resize(packetLength);
+            client.receiveState = RECEIVE_PACKET;
+            if (client.receivedLength < client.received.size()) {
+                continue;
+            }
+        }
 
-    size_t      dataSize = data.size();                                 // data size
-    const char *buffer   = reinterpret_cast<const char *>(data.data()); // convert data to char buffer
+        // a complete packet, the answer goes out before the queued pings
+        if (packet_handler) {
+            Frame answer = packet_handler(client.id, client.received.data(), client.received.size());
+            if (answer && !enqueueControl(client, answer)) {
+                reason = "not reading, control queue full";
+                return false;
+            }
+        }
+        client.received.resize(sizeof(int)); // the capacity stays for the next packet
+        client.receivedLength = 0;
+        client.receiveState   = RECEIVE_LENGTH;
+    }
+    return true;
+}
 
-    size_t bytesSent     = 0;
+bool tcpServer::flushClient(Client &client) {
+    std::vector<struct iovec> segments;
+    while (true) {
+        // between two frames the control frames go first, a started frame is finished
+        if (client.offset == 0) {
+            client.isControlHead = !client.controls.empty();
+        }
+        if (!client.isControlHead && client.queue.empty()) {
+            break;
+        }
 
-    while (bytesSent < dataSize) {
-        size_t remainingBytes = dataSize - bytesSent;
+        // the unwritten part of the current frame: header, payload blocks, trailer
+        const TcpFrame &frame = client.isControlHead ? *client.controls.front() : *client.queue.front();
+        size_t          skip  = client.offset;
+        segments.clear();
+        auto add = [&](const uint8_t *data, size_t length) {
+            if (skip >= length) {
+                skip -= length;
+                return;
+            }
+            segments.push_back({const_cast<uint8_t *>(data) + skip, length - skip});
+            skip = 0;
+        };
+        add(frame.header, frame.headerLength);
+        for (const auto &block : frame.blocks) {
+            add(block.first, block.second);
+        }
+        add(frame.trailer, frame.trailerLength);
 
-        fd_set         set;
-        struct timeval timeout;
-        FD_ZERO(&set);
-        FD_SET(client_fd, &set);
+        struct msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov    = segments.data();
+        message.msg_iovlen = std::min<size_t>(segments.size(), IOV_MAX);
+        ssize_t sent       = segments.empty() ? 0 : sendmsg(client.fd, &message, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return handleError("send data");
+            }
+            // the socket buffer is full, go on when it drains
+            if (!client.isWriteArmed) {
+                struct epoll_event event;
+                event.events   = EPOLLIN | EPOLLOUT;
+                event.data.u64 = static_cast<uint64_t>(client.id);
+                if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client.fd, &event) < 0) {
+                    return handleError("epoll_ctl (arm)");
+                }
+                client.isWriteArmed = true;
+            }
+            return true;
+        }
 
-        timeout.tv_sec  = timeout_ms / 1000;
-        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        client.bytesSent += sent;
+        client.offset += sent;
+        if (client.offset == frame.size()) {
+            client.offset = 0;
+            client.framesSent++;
+            if (client.isControlHead) {
+                client.controls.pop_front();
+            } else {
+                client.queue.pop_front();
+                client.headStartTime = Clock::now();
+            }
+        }
+    }
 
-        int rv          = select(client_fd + 1, nullptr, &set, nullptr, &timeout);
+    if (client.isWriteArmed) {
+        struct epoll_event event;
+        event.events   = EPOLLIN;
+        event.data.u64 = static_cast<uint64_t>(client.id);
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client.fd, &event) < 0) {
+            return handleError("epoll_ctl (disarm)");
+        }
+        client.isWriteArmed = false;
+    }
+    return true;
+}
 
-        if (rv == -1) {
-            return handleError("select on send");
-        } else if (rv == 0) {
-            std::cerr << termColor("red") << "Timeout: Client did not ready for data transmission within "
-                      << termColor("nocolor") << timeout_ms << " milliseconds." << std::endl;
-            closeConnection(); // close the connection when timeout
+bool tcpServer::enqueue(Client &client, const Frame &frame) {
+    if (static_cast<int>(client.queue.size()) >= tcp_info.clientQueueDepth) {
+        if (tcp_info.slowClientPolicy == SLOW_CLIENT_DISCONNECT) {
             return false;
         }
+        // drop the oldest frame that is not partly written, the newest data is the most useful one
+        bool isHeadStarted = client.offset > 0 && !client.isControlHead;
+        auto oldest        = isHeadStarted ? client.queue.begin() + 1 : client.queue.begin();
+        client.framesDropped++;
+        if (oldest == client.queue.end()) {
+            return true;
+        }
+        if (oldest == client.queue.begin()) {
+            client.headStartTime = Clock::now();
+        }
+        client.queue.erase(oldest);
+    }
+    if (client.queue.empty()) {
+        client.headStartTime = Clock::now();
+    }
+    client.queue.push_back(frame);
+    return true;
+}
+
+bool tcpServer::enqueueControl(Client &client, const Frame &frame) {
+    // control frames are small and jump the queue, a client that lets them pile up does not read at all
+    if (static_cast<int>(client.controls.size()) >= std::max(tcp_info.clientQueueDepth, 4)) {
+        return false;
+    }
+    client.controls.push_back(frame);
+    return true;
+}
+
+void tcpServer::armHeartbeat() {
+    if (timer_fd == -1) {
+        return;
+    }
+    struct itimerspec period;
+    std::memset(&period, 0, sizeof(period));
+    if (heartbeat_frame && heartbeat_interval > 0) {
+        period.it_interval.tv_sec  = heartbeat_interval / 1000;
+        period.it_interval.tv_nsec = (heartbeat_interval % 1000) * 1000000L;
+        period.it_value            = period.it_interval;
+    }
+    if (timerfd_settime(timer_fd, 0, &period, nullptr) < 0) {
+        handleError("timerfd_settime");
+    }
+}
+
+void tcpServer::sendHeartbeat() {
+    if (!heartbeat_frame) {
+        return;
+    }
+    std::vector<int> failed;
+    for (auto &item : clients) {
+        if (!enqueueControl(item.second, heartbeat_frame)) {
+            failed.push_back(item.first);
+        }
+    }
+    for (int id : failed) {
+        closeClient(id, "not reading, control queue full");
+    }
+    // a client that answered none of the last heartbeats is gone
+    if (max_missed > 0) {
+        closeSilent(max_missed * heartbeat_interval + HEARTBEAT_GRACE_MS);
+    }
+}
 
-        ssize_t sent = send(client_fd, buffer + bytesSent, remainingBytes, 0);
-        if (sent == -1) {
-            return handleError("send data");
+void tcpServer::checkStalledClients() {
+    if (tcp_info.slowClientPolicy != SLOW_CLIENT_DISCONNECT || tcp_info.sendTimeout <= 0) {
+        return;
+    }
+    auto             now = Clock::now();
+    std::vector<int> stalled;
+    for (const auto &item : clients) {
+        if (!item.second.queue.empty() &&
+            now - item.second.headStartTime > std::chrono::milliseconds(tcp_info.sendTimeout)) {
+            stalled.push_back(item.first);
         }
+    }
+    for (int id : stalled) {
+        closeClient(id, "slow client, send timeout");
+    }
+}
+
+void tcpServer::closeClient(int id, const char *reason) {
+    auto it = clients.find(id);
+    if (it == clients.end()) {
+        return;
+    }
+    const Client &client = it->second;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client.fd, nullptr);
+    close(client.fd);
+
+    double seconds = std::chrono::duration<double>(Clock::now() - client.connectTime).count();
+    std::cout << termColor("yellow") << "TCP client #" << client.id << " (" << client.address << ") closed: " << reason
+              << ", " << client.framesSent << " frames / " << std::fixed << std::setprecision(1)
+              << client.bytesSent / 1e6 << " MB in " << seconds << " s ("
+              << (seconds > 0 ? client.bytesSent / 1e3 / seconds : 0.0) << " kB/s), " << client.framesDropped
+              << " dropped" << termColor("nocolor") << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+    clients.erase(it);
+}
 
-        bytesSent += sent;
+bool tcpServer::broadcast(const Frame &frame) {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    if (clients.empty()) {
+        return false;
+    }
+    std::vector<int> slow;
+    for (auto &item : clients) {
+        if (!enqueue(item.second, frame)) {
+            slow.push_back(item.first);
+        }
+    }
+    for (int id : slow) {
+        closeClient(id, "slow client, send queue full");
     }
-#ifdef _THREAD_TCPCLIENT_DEBUG_
-    std::cout << termColor("green") << "Data sent successfully, total size: " << dataSize << " bytes."
-              << termColor("nocolor") << std::endl;
-#endif // _THREAD_TCPCLIENT_DEBUG_
+    wake();
     return true;
 }
 
+bool tcpServer::sendTo(int clientId, const Frame &frame) {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    auto                        it = clients.find(clientId);
+    if (it == clients.end()) {
+        return false;
+    }
+    if (!enqueue(it->second, frame)) {
+        closeClient(clientId, "slow client, send queue full");
+        return false;
+    }
+    wake();
+    return true;
+}
+
+void tcpServer::setPacketHandler(const PacketHandler &handler) {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    packet_handler = handler;
+}
+
+void tcpServer::setHeartbeat(const Frame &frame, int interval_ms, int maxMissed) {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    heartbeat_frame    = frame;
+    heartbeat_interval = interval_ms;
+    max_missed         = maxMissed;
+    armHeartbeat();
+}
+
+bool tcpServer::sendVector(const std::vector<uint8_t> &data, int timeout_ms) {
+    (void) timeout_ms;
+    std::shared_ptr<const std::vector<uint8_t>> copy  = std::make_shared<const std::vector<uint8_t>>(data);
+    std::shared_ptr<TcpFrame>                   frame = std::make_shared<TcpFrame>();
+    frame->blocks.emplace_back(copy->data(), copy->size());
+    frame->owner = copy;
+    return broadcast(frame);
+}
+
 void tcpServer::closeConnection() {
-    std::lock_guard<std::mutex> lock(conn_mutex); // make sure the connection is closed safely
-    if (client_fd != -1) {
-        close(client_fd);
-        client_fd       = -1;
-        connection_open = false;
-#ifdef _THREAD_TCPCLIENT_DEBUG_
-        std::cout << termColor("blue") << "Connection closed." << termColor("nocolor") << std::endl;
-#endif // _THREAD_TCPCLIENT_DEBUG_
+    std::lock_guard<std::mutex> lock(conn_mutex); // make sure the connections are closed safely
+    while (!clients.empty()) {
+        closeClient(clients.begin()->first, "closed by the server");
     }
 }
 
+int tcpServer::closeSilentClients(int timeout_ms) {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    return closeSilent(timeout_ms);
+}
+
+int tcpServer::closeSilent(int timeout_ms) {
+    auto             now = Clock::now();
+    std::vector<int> silent;
+    for (const auto &item : clients) {
+        if (now - item.second.lastReceiveTime > std::chrono::milliseconds(timeout_ms)) {
+            silent.push_back(item.first);
+        }
+    }
+    for (int id : silent) {
+        closeClient(id, "too many missed heartbeats");
+    }
+    return static_cast<int>(silent.size());
+}
+
 bool tcpServer::waitForConnection(int timeout_ms) {
-    return acceptClient(timeout_ms);
-}
\ No newline at end of file
+    std::unique_lock<std::mutex> lock(conn_mutex);
+    if (conn_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                         [this]() { return !clients.empty() || stop_flag; }) &&
+        !clients.empty()) {
+        return true;
+    }
+    if (!stop_flag) {
+        std::cerr << termColor("red") << "Timeout: No client connected within " << timeout_ms << " milliseconds."
+                  << termColor("nocolor") << std::endl;
+    }
+    return false;
+}
+
+int tcpServer::getClientNum() const {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    return static_cast<int>(clients.size());
+}
+
+void tcpServer::getClientIds(std::vector<int> &ids) const {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    ids.clear();
+    for (const auto &item : clients) {
+        ids.push_back(item.first);
+    }
+}
+
+void tcpServer::getClientStats(std::vector<TcpClientStats> &stats) const {
+    std::lock_guard<std::mutex> lock(conn_mutex);
+    auto                        now = Clock::now();
+    stats.clear();
+    for (const auto &item : clients) {
+        const Client  &client = item.second;
+        TcpClientStats stat;
+        stat.id            = client.id;
+        stat.address       = client.address;
+        stat.bytesSent     = client.bytesSent;
+        stat.framesSent    = client.framesSent;
+        stat.framesDropped = client.framesDropped;
+        stat.queueLength   = static_cast<int>(client.queue.size() + client.controls.size());
+        stat.connectedTime = std::chrono::duration<double>(now - client.connectTime).count();
+        stat.throughput    = stat.connectedTime > 0 ? client.bytesSent / stat.connectedTime : 0.0;
+        stats.push_back(stat);
+    }
+}
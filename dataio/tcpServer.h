@@ -12,37 +12,185 @@
 #ifndef TCPSERVER_H
 #define TCPSERVER_H
 
+#include "../core/systeminfo.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <netinet/in.h>
+#include <string>
+#include <thread>
 #include <vector>
 
+// throughput counters of one client, see tcpServer::getClientStats()
+typedef struct TcpClientStats {
+    int         id;            // connection number, counts up from 1
+    std::string address;       // peer ip:port
+    uint64_t    bytesSent;     // bytes written to the socket
+    uint64_t    framesSent;    // frames written completely
+    uint64_t    framesDropped; // frames dropped by the slow-client policy
+    int         queueLength;   // frames waiting in the send queue
+    double      connectedTime; // s
+    double      throughput;    // bytes/s since the connection
+} TcpClientStats;
+
+/***
+ * @description: One frame of the stream, written with a single sendmsg (scatter-gather): a small header built in place,
+ * the payload blocks straight from the memory of their owner (e.g. the channels of a ping, no flattening copy) and a
+ * small trailer (e.g. the checksum). The frame is shared by the queues of all clients and keeps the owner alive until
+ * the last client has written it.
+ */
+struct TcpFrame {
+    static const int MAX_INLINE = 80;
+
+    uint8_t header[MAX_INLINE];
+    int     headerLength = 0;
+    uint8_t trailer[MAX_INLINE];
+    int     trailerLength = 0;
+
+    std::vector<std::pair<const uint8_t *, size_t>> blocks; // payload, owned by owner
+    std::shared_ptr<const void>                     owner;
+
+    size_t size() const {
+        size_t total = headerLength + trailerLength;
+        for (const auto &block : blocks) {
+            total += block.second;
+        }
+        return total;
+    }
+};
+
+/***
+ * @description: Multi-client TCP streaming server. One epoll thread accepts the clients ([TCP] maxClients), reads what
+ * they send and writes the queued frames with non-blocking sends (TCP_NODELAY, SO_SNDBUF from [TCP] sendBufferSize).
+ * sendVector() / broadcast() only append one shared frame to the bounded queue of every client ([TCP]
+ * clientQueueDepth) and return at once, so a slow client never stalls the others or the caller. A client whose queue
+ * is full, or whose head frame has not gone out within [TCP] sendTimeout, is handled by [TCP] slowClientPolicy: its
+ * oldest waiting frame is dropped (SLOW_CLIENT_DROP) or it is disconnected (SLOW_CLIENT_DISCONNECT).
+ * What a client sends is split into packets, each starting with its length (int, bytes of the whole packet, at most
+ * MAX_PACKET_LENGTH), and handed to the packet handler; the frame it returns is queued as the answer to that client.
+ * A timerfd in the same loop queues the heartbeat to every client (setHeartbeat()) and closes the clients that sent
+ * nothing for maxMissed intervals. Answers and heartbeats are control frames: they go out right after the frame being
+ * written, ahead of the queued pings, and are never dropped by the slow-client policy.
+ */
 class tcpServer {
 public:
-    tcpServer(int port);
+    typedef std::shared_ptr<const TcpFrame> Frame;
+    // called on the event loop thread for every complete packet of a client, must not call back into the server;
+    // returns the answer for the client or nullptr
+    typedef std::function<Frame(int clientId, const uint8_t *packet, size_t length)> PacketHandler;
+
+    static const int MAX_PACKET_LENGTH  = 65536; // longer packets from a client close it
+    static const int MAX_READ_PER_EVENT = 65536; // bytes read from one client before serving the others
+
+    tcpServer(const TcpInfo &tcpInfo, const ThreadSchedInfo &threadSched = ThreadSchedInfo(),
+              size_t prefaultStackSize = 0);
     ~tcpServer();
 
-    bool start(); // start server
-    // bool sendVector(const std::vector<double>& data, int timeout_ms = 5000);  // send data, timeout precision is
-    // millisecond
+    bool start(); // bind, listen and start the event loop thread
+    void stop();  // close every connection and stop the event loop thread
+
+    // queue a copy of the data to every client, false when no client is connected (the timeout is not used any more,
+    // the send never blocks)
     bool sendVector(const std::vector<uint8_t> &data, int timeout_ms);
-    bool waitForConnection(int timeout_ms); // encapsulate the call logic of acceptClient
-    void closeConnection();                 // close connection manually
-    // get client file descriptor
-    int  getClientFd() const {
-        return client_fd;
-    }
+    // same without any copy, the frame is shared by all client queues
+    bool broadcast(const Frame &frame);
+    // queue the frame to one client, false when it is not connected (any more)
+    bool sendTo(int clientId, const Frame &frame);
+
+    void setPacketHandler(const PacketHandler &handler);
+
+    /***
+     * @description: Queue the frame to every client every interval_ms on the event loop, and close the clients that
+     * sent nothing (no heartbeat response) for maxMissed intervals
+     * @param {Frame} &frame        The heartbeat packet, nullptr stops the heartbeat
+     * @param {int} interval_ms     Heartbeat interval, <= 0 stops the heartbeat
+     * @param {int} maxMissed       Missed heartbeats before a client is closed
+     * @return {*}
+     */
+    void setHeartbeat(const Frame &frame, int interval_ms, int maxMissed);
+
+    bool waitForConnection(int timeout_ms); // wait until at least one client is connected
+    void closeConnection();                 // close all connections manually
+
+    // close the clients that sent nothing for timeout_ms (missed heartbeat responses), returns how many
+    int closeSilentClients(int timeout_ms);
+
+    int  getClientNum() const;
+    void getClientIds(std::vector<int> &ids) const;
+    void getClientStats(std::vector<TcpClientStats> &stats) const;
 
 private:
-    int port;
+    typedef std::chrono::steady_clock Clock;
+
+    // receive state of a client: the length of the next packet, then the rest of it
+    enum ReceiveState { RECEIVE_LENGTH, RECEIVE_PACKET };
+
+    struct Client {
+        int                  fd;
+        int                  id;
+        std::string          address;
+        std::deque<Frame>    queue;                          // frames waiting, the front one may be partly written
+        std::deque<Frame>    controls;                       // answers and heartbeats, go out before queue.front()
+        size_t               offset        = 0;              // bytes of the current frame already written
+        bool                 isControlHead = false;          // the frame being written is controls.front()
+        bool                 isWriteArmed  = false;          // EPOLLOUT registered, the socket buffer was full
+        ReceiveState         receiveState  = RECEIVE_LENGTH; // waiting for the length or the rest of a packet
+        std::vector<uint8_t> received;                       // the packet being received, sized to what is expected
+        size_t               receivedLength = 0;             // bytes of it received so far
+        Clock::time_point    connectTime;
+        Clock::time_point    lastReceiveTime;
+        Clock::time_point    headStartTime;                  // when the front frame reached the head of the queue
+        uint64_t             bytesSent     = 0;
+        uint64_t             framesSent    = 0;
+        uint64_t             framesDropped = 0;
+    };
+
     int server_fd; // server file descriptor
-    int client_fd; // client connection file descriptor
-
-    struct sockaddr_in server_addr;
-    std::mutex         conn_mutex;                       // mutex lock to protect connection resource
-    bool               bindServer();                     // bind server
-    bool               acceptClient(int timeout_ms);     // private, function to wait for connection
-    bool               handleError(const char *context); // print error message and return false
-    bool               connection_open;                  // used to mark whether the connection is open
+    int epoll_fd;  // event loop
+    int wake_fd;   // eventfd, wakes the event loop when a frame is queued or the server stops
+    int timer_fd;  // timerfd, heartbeat interval
+
+    TcpInfo         tcp_info;
+    ThreadSchedInfo thread_sched;
+    size_t          prefault_stack_size;
+
+    struct sockaddr_in      server_addr;
+    mutable std::mutex      conn_mutex; // mutex lock to protect the client map
+    std::condition_variable conn_cv;    // signalled when a client connects
+    std::map<int, Client>   clients;    // by client id, also the epoll tag of the client socket
+    int                     next_client_id = 1;
+    std::thread             loop_thread;
+    std::atomic<bool>       stop_flag;
+    PacketHandler           packet_handler;
+    Frame                   heartbeat_frame;        // nullptr: no heartbeat
+    int                     heartbeat_interval = 0; // ms
+    int                     max_missed         = 0; // heartbeats
+
+    bool bindServer();                     // bind server
+    void eventLoop();                      // thread function
+    void wake();                           // interrupt epoll_wait
+    bool handleError(const char *context); // print error message and return false
+
+    // called with conn_mutex held
+    void acceptClients(); // accept all pending connections
+    // drain what the client sent and hand the packets over, false (and the reason) when the client has to be closed
+    bool readClient(Client &client, const char *&reason);
+    // feed received bytes to the receive state machine of the client
+    bool receiveBytes(Client &client, const uint8_t *data, size_t length, const char *&reason);
+    bool flushClient(Client &client);                        // write queued frames until EAGAIN, false on failure
+    bool enqueue(Client &client, const Frame &frame);        // false when the slow-client policy disconnects it
+    bool enqueueControl(Client &client, const Frame &frame); // false when the client does not read any more
+    void closeClient(int id, const char *reason);
+    void checkStalledClients(); // slow-client policy on a frame stuck at the head
+    void armHeartbeat();        // (re)start the heartbeat timer
+    void sendHeartbeat();       // on the heartbeat timer
+    int  closeSilent(int timeout_ms);
 };
 
 #endif // TCPSERVER_H
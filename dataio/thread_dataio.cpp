@@ -27,6 +27,11 @@ void ThreadDataIO::setPosResQueue(sfq::Safe_Queue<PositionResult> *posResQueue)
 void ThreadDataIO::openPosResSerial(const std::string &serial_port_name, const std::string &baudrate) {
     posResSerial_.open(serial_port_name, baudrate);
     posResSerial_.flush();
+    // the sentences are written by the serial writer, the send thread never waits for the port
+    posResWriter_.reset(new SerialWriter(posResSerial_, systemInfo_.dataIOInfo.outputQueueDepth,
+                                         systemInfo_.dataIOInfo.outputWriteTimeout));
+    posResWriter_->start("Serial Output", systemInfo_.threadPolicyInfo.dspOutput,
+                         systemInfo_.threadPolicyInfo.prefaultStackSize);
 
 #ifdef _THREAD_DATAIO_DEBUG_
     std::cout << termColor("green") << "Serial Port: Position Result Sender is opened" << termColor("nocolor") << "\n";
@@ -34,6 +39,11 @@ void ThreadDataIO::openPosResSerial(const std::string &serial_port_name, const s
 }
 
 void ThreadDataIO::closePosResSerial() {
+    // write what is still queued before the port goes away
+    if (posResWriter_) {
+        posResWriter_->stop();
+        posResWriter_.reset();
+    }
     posResSerial_.close();
 
 #ifdef _THREAD_DATAIO_DEBUG_
@@ -52,7 +62,7 @@ void ThreadDataIO::sendPosResult() {
         // send the data
         tempStr_.clear();
         tempStr_ = posResSender_->data2OutputString(posResData_);
-        sendString(&posResSerial_, tempStr_);
+        sendString(tempStr_);
 
 #ifdef _THREAD_DATAIO_DEBUG_
         std::cout << termColor("green") << "Position Result is sent: " << termColor("nocolor");
@@ -92,17 +102,16 @@ void ThreadDataIO::closeThreadSendPosResult() {
     }
 }
 
-void ThreadDataIO::sendString(SerialDriver *serial, const std::string &str) {
-    for (char ch : str) {
-        if (!serial->isOpen()) {
-            // process error
-            std::cerr << "Serial port is not open" << std::endl;
-            exit(EXIT_FAILURE);
-        }
-        if (!serial->writeByte(static_cast<uint8_t>(ch))) {
-            // process error
-            std::cerr << "Failed to send character: " << ch << std::endl;
-            exit(EXIT_FAILURE);
-        }
+bool ThreadDataIO::sendString(const std::string &str) {
+    if (!posResWriter_) {
+        // process error
+        std::cerr << "Serial port is not open" << std::endl;
+        exit(EXIT_FAILURE);
     }
-}
\ No newline at end of file
+    // one frame per sentence, written with one write() together with the sentences queued meanwhile
+    return posResWriter_->write(str);
+}
+
+SerialWriterStats ThreadDataIO::getPosResWriterStats() const {
+    return posResWriter_ ? posResWriter_->getStats() : SerialWriterStats();
+}
@@ -19,6 +19,8 @@
 #include "../tool/SafeQueue.hpp"
 #include "posResSender.h"
 #include "serialDriver.h"
+#include "serialWriter.h"
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -43,8 +45,11 @@ public:
     // Send Data Function
     void sendPosResult();
 
-    // Send String
-    void sendString(SerialDriver *serial, const std::string &str);
+    // Send String: queued to the serial writer, false when it is dropped (port closed)
+    bool sendString(const std::string &str);
+
+    // Counters of the serial writer of the position results
+    SerialWriterStats getPosResWriterStats() const;
 
     // Thread Function
     // creat thread
@@ -74,7 +79,8 @@ private:
     PositionResult posResData_;
 
     // Serial Port
-    SerialDriver posResSerial_;
+    SerialDriver                  posResSerial_;
+    std::unique_ptr<SerialWriter> posResWriter_; // whole sentences, written by its own thread
 
     // Thread
     std::thread threadSendPosResult_;
@@ -11,6 +11,8 @@
 #include "thread_tcpComm.h"
 #include "../config/defineconfig.h"
 #include "../tool/ColorParse.h"
+#include "../tool/ThreadPolicy.h"
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <iostream>
@@ -19,12 +21,19 @@
 
 ThreadTcpCommunication::ThreadTcpCommunication(SystemInfo &systemInfo, tcpServer &server)
     : systemInfo_(systemInfo)
-    , server_(server)
-    , stopFlag_(false) {
+    , server_(server) {
     init();
+    server_.setPacketHandler([this](int clientId, const uint8_t *packet, size_t length) {
+        return handlePacket(clientId, packet, length);
+    });
+    // the heartbeats go out on the server event loop, whether pings arrive or not
+    server_.setHeartbeat(heartbeatFrame_, systemInfo_.tcpInfo.heartbeatInterval,
+                         systemInfo_.tcpInfo.maxMissedHeartbeats);
 }
 
 ThreadTcpCommunication::~ThreadTcpCommunication() {
+    server_.setHeartbeat(nullptr, 0, 0);
+    server_.setPacketHandler(nullptr);
     stopThread();
     if (sendThread_.joinable()) {
         sendThread_.join();
@@ -32,195 +41,172 @@ ThreadTcpCommunication::~ThreadTcpCommunication() {
 }
 
 void ThreadTcpCommunication::init() {
-    stopFlag_       = false;
-    connectTimeout_ = systemInfo_.tcpInfo.connectTimeout;
-    sendTimeout_    = systemInfo_.tcpInfo.sendTimeout;
+    // heartbeat packet, no signal data (the same bytes as TcpSignalType(false, 0, 0, {}, TCP_PACKET_HEARTBEAT))
+    std::shared_ptr<TcpFrame> heartbeat = std::make_shared<TcpFrame>();
+    uint32_t                  checksum  = crc32(0L, Z_NULL, 0);
+    int                       length    = TcpSignalType::HEADER_LENGTH + sizeof(checksum);
+    heartbeat->headerLength             = TcpSignalType::serializeHeader(reinterpret_cast<char *>(heartbeat->header),
+                                                                         length, TCP_PACKET_HEARTBEAT, false, 0, 0);
+    memcpy(heartbeat->trailer, &checksum, sizeof(checksum));
+    heartbeat->trailerLength = sizeof(checksum);
+    heartbeatFrame_          = heartbeat;
+
+    // the segments of a product packet are encoded in parallel, 0 workers encode on the send thread
+    ThreadPolicyInfo &policy = systemInfo_.threadPolicyInfo;
+    encoderPool_.reset(new ThreadPool(systemInfo_.tcpInfo.encodeWorkerNum, [&policy](int index) {
+        applyThreadPolicy("TCP Encoder " + std::to_string(index), policy.tcp, policy.prefaultStackSize);
+    }));
 }
 
-void ThreadTcpCommunication::setDataQueue(sfq::Safe_Queue<ChannelSignalVector> *dataQueue) {
+void ThreadTcpCommunication::setProductQueue(sfq::Safe_Queue<std::shared_ptr<const PingProducts>> *productQueue) {
     if (signalQueue_ != nullptr) {
         std::cerr << termColor("red") << "Data queue is setted." << termColor("nocolor") << std::endl;
         return;
     }
-    signalQueue_ = dataQueue;
+    signalQueue_ = productQueue;
 }
 
-void ThreadTcpCommunication::startSending() {
-    stopFlag_   = false;
-    sendThread_ = std::thread(&ThreadTcpCommunication::sendData, this);
+uint32_t ThreadTcpCommunication::productDemand(uint64_t seq) {
+    std::vector<int> ids;
+    server_.getClientIds(ids);
+
+    std::lock_guard<std::mutex> lock(subscriptionMtx_);
+    uint32_t                    demand = 0;
+    for (int id : ids) {
+        auto it = subscriptions_.find(id);
+        if (it == subscriptions_.end()) {
+            demand |= PRODUCT_RAW;
+            continue;
+        }
+        for (const auto &subscription : it->second) {
+            if (seq % subscription.decimation == 0) {
+                demand |= subscription.product;
+            }
+        }
+    }
+    return demand;
 }
 
-bool ThreadTcpCommunication::waitForHeartbeatResponse() {
-    const int responseTimeout = 300; /// wait for response timeout in ms
-
-    // use select to wait for response from client
-    fd_set         set;
-    struct timeval timeout;
-    FD_ZERO(&set);
-    FD_SET(server_.getClientFd(), &set); // use getter function to access client_fd
-
-    timeout.tv_sec  = responseTimeout / 1000;
-    timeout.tv_usec = (responseTimeout % 1000) * 1000;
-
-    int rv =
-        select(server_.getClientFd() + 1, &set, nullptr, nullptr, &timeout); // use getter function to access client_fd
-
-    if (rv == -1) {
-        std::cerr << termColor("red") << "Error while waiting for heartbeat response: " << strerror(errno)
-                  << termColor("nocolor") << std::endl;
-        return false;
-    } else if (rv == 0) {
-        std::cerr << termColor("red") << "Heartbeat response timed out." << termColor("nocolor") << std::endl;
-        return false;
+tcpServer::Frame ThreadTcpCommunication::handlePacket(int clientId, const uint8_t *packet, size_t length) {
+    int signalType = -1;
+    if (length >= static_cast<size_t>(TcpSignalType::HEADER_LENGTH)) {
+        memcpy(&signalType, packet + sizeof(int), sizeof(signalType));
     }
 
-    // data received, read and check if it is a heartbeat response packet
-    char    buffer[1024];                                       // temporarily set to 1024 bytes buffer
-    ssize_t bytesRead =
-        recv(server_.getClientFd(), buffer, sizeof(buffer), 0); // use getter function to access client_fd
+    switch (signalType) {
+        case TCP_PACKET_HEARTBEAT_RESPONSE:
+            // receiving it already keeps the client alive
+            if (length != TcpSignalType::HEADER_LENGTH + sizeof(uint32_t)) {
+                std::cerr << termColor("red") << "TCP client #" << clientId << ": invalid heartbeat response length "
+                          << length << termColor("nocolor") << std::endl;
+            }
+            return nullptr;
 
-    if (bytesRead <= 0) {
-        std::cerr << termColor("red") << "Error reading heartbeat response: " << strerror(errno) << termColor("nocolor")
-                  << std::endl;
-        return false;
-    }
+        case TCP_PACKET_SUBSCRIBE: {
+            std::vector<TcpSubscription> subscriptions;
+            if (!parseSubscribeRequest(packet, length, subscriptions)) {
+                std::cerr << termColor("red") << "TCP client #" << clientId << ": invalid subscribe request"
+                          << termColor("nocolor") << std::endl;
+                return nullptr;
+            }
 
-    TcpSignalType response = TcpSignalType::deserialize(buffer);
+            // the accepted entries replace all subscriptions of the client
+            const AIScanInfo            &scanInfo   = systemInfo_.aiScanInfo;
+            int                          channelNum = scanInfo.highChan - scanInfo.lowChan + 1;
+            std::vector<uint8_t>         status(subscriptions.size());
+            std::vector<TcpSubscription> accepted;
+            for (size_t i = 0; i < subscriptions.size(); ++i) {
+                status[i] = checkSubscription(subscriptions[i], channelNum);
+                if (status[i] == SUBSCRIBE_OK) {
+                    accepted.push_back(subscriptions[i]);
+                }
+            }
+            std::cout << termColor("green") << "TCP client #" << clientId << " subscribed to " << accepted.size() << "/"
+                      << subscriptions.size() << " products" << termColor("nocolor") << std::endl;
+            {
+                std::lock_guard<std::mutex> lock(subscriptionMtx_);
+                subscriptions_[clientId] = std::move(accepted);
+            }
+            return makeSubscribeAnswer(subscriptions, status);
+        }
 
-    // if signalType is 9, it is a heartbeat response
-    if (response.signalType == 9) {
-#ifdef _THREAD_TCPCLIENT_DEBUG_
-        std::cout << termColor("green") << "Received heartbeat response." << termColor("nocolor") << std::endl;
-#endif // _THREAD_TCPCLIENT_DEBUG_
-        return true;
+        default:
+            std::cerr << termColor("red") << "TCP client #" << clientId << ": unknown packet type " << signalType
+                      << termColor("nocolor") << std::endl;
+            return nullptr;
     }
-
-    std::cerr << termColor("red") << "Received non-heartbeat response." << termColor("nocolor") << std::endl;
-    return false;
 }
 
-void ThreadTcpCommunication::sendData() {
-    int       missedHeartbeats    = 0;
-    const int maxMissedHeartbeats = 3;
-    const int heartbeatInterval   = 5000; // heartbeat interval, 5 seconds
-    auto      lastHeartbeatTime   = std::chrono::steady_clock::now();
-    int       currentQueueSize    = 0;
-
-    std::vector<char>    buffer;     // declare buffer for serializing data
-    std::vector<uint8_t> byteData;   // declare byte array for sending
-    size_t               packetSize; // declare variable for storing packet size
+void ThreadTcpCommunication::sendProducts(const std::shared_ptr<const PingProducts> &products) {
+    server_.getClientIds(clientIds_);
 
-    while (true) {
-#ifdef _THREAD_TCPCLIENT_DEBUG_
-        std::cout << termColor("yellow") << "Thread started, waiting for TCP connection..." << termColor("nocolor")
-                  << std::endl;
-#endif // _THREAD_TCPCLIENT_DEBUG_
-
-        // wait for TCP connection
-        while (true) {
-            {
-                std::lock_guard<std::mutex> lock(mtx_);
-                if (stopFlag_) {
-#ifdef _THREAD_TCPCLIENT_DEBUG_
-                    std::cout << termColor("yellow") << "Thread stopped while waiting for connection."
-                              << termColor("nocolor") << std::endl;
-#endif // _THREAD_TCPCLIENT_DEBUG_
-                    return;
-                }
-            }
+    std::lock_guard<std::mutex> lock(subscriptionMtx_);
+    // forget the clients that left, their ids are never used again
+    for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+        if (std::find(clientIds_.begin(), clientIds_.end(), it->first) == clientIds_.end()) {
+            it = subscriptions_.erase(it);
+        } else {
+            ++it;
+        }
+    }
 
-            if (server_.waitForConnection(connectTimeout_)) {
-#ifdef _THREAD_TCPCLIENT_DEBUG_
-                std::cout << termColor("green") << "TCP connection established, starting data transmission."
-                          << termColor("nocolor") << std::endl;
-#endif // _THREAD_TCPCLIENT_DEBUG_
-                break;
+    // one frame per distinct subscription, shared by the clients that have it
+    std::map<TcpSubscription, tcpServer::Frame> frames;
+    tcpServer::Frame                            signalFrame;
+    for (int id : clientIds_) {
+        auto it = subscriptions_.find(id);
+        if (it == subscriptions_.end()) {
+            if (!(products->products & PRODUCT_RAW)) {
+                continue;
             }
-
-            std::cerr << termColor("red") << "Failed to establish connection, retrying..." << termColor("nocolor")
-                      << std::endl;
-            // clear the data send queue
-            currentQueueSize = signalQueue_->size();
-            for (int i = 0; i < currentQueueSize; i++) {
-                signalQueue_->try_pop(data_);
+            if (!signalFrame) {
+                // the whole ping, written from the channel memory of the products
+                signalFrame = TcpSignalType::makeFrame(
+                    std::shared_ptr<const ChannelSignalVector>(products, &products->signal), TCP_PACKET_SIGNAL);
             }
+            server_.sendTo(id, signalFrame);
+            continue;
         }
-
-        // start data transmission
-        while (true) {
-            {
-                std::lock_guard<std::mutex> lock(mtx_);
-                if (stopFlag_) {
-                    std::cout << termColor("yellow") << "Thread stopped before finishing all data."
-                              << termColor("nocolor") << std::endl;
-                    return;
-                }
+        for (const auto &subscription : it->second) {
+            if (products->seq % subscription.decimation != 0) {
+                continue;
             }
-
-            // calculate the time interval between current time and last heartbeat packet sent time
-            auto now = std::chrono::steady_clock::now();
-            auto timeSinceLastHeartbeat =
-                std::chrono::duration_cast<std::chrono::milliseconds>(now - lastHeartbeatTime).count();
-
-            if (timeSinceLastHeartbeat >= heartbeatInterval) {
-                // send heartbeat packet
-                TcpSignalType heartbeatPacket(false, 0, 0, {}, 0); // create heartbeat packet
-                packetSize = heartbeatPacket.packetLength;         // calculate heartbeat packet size
-                buffer.resize(packetSize);                         // resize buffer
-                heartbeatPacket.serialize(buffer.data());
-
-                // send heartbeat packet through tcpServer
-                byteData.assign(buffer.begin(), buffer.end()); // convert buffer to byteData
-                if (!server_.sendVector(byteData, sendTimeout_)) {
-                    std::cerr << termColor("red") << "Failed to send heartbeat packet." << termColor("nocolor")
-                              << std::endl;
-                    missedHeartbeats++;
-                } else {
-                    // wait for heartbeat packet response
-                    if (!waitForHeartbeatResponse()) {
-                        missedHeartbeats++;
-                        std::cerr << termColor("red") << "Missed heartbeat response (" << missedHeartbeats << "/"
-                                  << maxMissedHeartbeats << ")" << termColor("nocolor") << std::endl;
-
-                        if (missedHeartbeats >= maxMissedHeartbeats) {
-                            std::cerr << termColor("red") << "Too many missed heartbeats. Closing connection..."
-                                      << termColor("nocolor") << std::endl;
-                            server_.closeConnection(); // close connection
-                            break;                     // exit current sending loop, wait for connection again
-                        }
-                    } else {
-                        missedHeartbeats = 0; // reset counter when heartbeat response received
-                    }
-                }
-
-                lastHeartbeatTime = std::chrono::steady_clock::now(); // update last heartbeat sent time
+            auto frame = frames.find(subscription);
+            if (frame == frames.end()) {
+                frame = frames
+                            .emplace(subscription, makeProductFrame(products, subscription, encoderPool_.get(),
+                                                                    systemInfo_.tcpInfo.compressionLevel))
+                            .first;
+            }
+            if (frame->second) {
+                server_.sendTo(id, frame->second);
             }
+        }
+    }
+}
 
-            // continue sending actual data if heartbeat successful
-            data_ = signalQueue_->wait_and_pop();
-            TcpSignalType signalPacket(true, data_.channelNum, data_.signalLength, data_.channels);
+void ThreadTcpCommunication::startSending() {
+    sendThread_ = std::thread(&ThreadTcpCommunication::sendData, this);
+}
 
-            packetSize = signalPacket.packetLength; // calculate data packet size
-            buffer.resize(packetSize);              // resize buffer
-            signalPacket.serialize(buffer.data());
+void ThreadTcpCommunication::sendData() {
+    applyThreadPolicy("TCP Send", systemInfo_.threadPolicyInfo.tcp, systemInfo_.threadPolicyInfo.prefaultStackSize);
 
-            byteData.assign(buffer.begin(), buffer.end()); // convert buffer to byteData
-            if (!server_.sendVector(byteData, sendTimeout_)) {
-                std::cerr << termColor("red") << "Failed to send data packet." << termColor("nocolor") << std::endl;
-                continue;
-            }
-#ifdef _THREAD_TCPCLIENT_DEBUG_
-            // std::cout << termColor("blue") << "Sent data packet successfully." << termColor("nocolor") << std::endl;
-#endif // _THREAD_TCPCLIENT_DEBUG_
-       // std::this_thread::sleep_for(std::chrono::milliseconds(1000)); // wait for 1 second
-        }
+    if (signalQueue_ == nullptr) {
+        std::cerr << termColor("red") << "Product queue is not set." << termColor("nocolor") << std::endl;
+        return;
+    }
 
-// after connection closed, re-enter waiting for connection state
+    // the products are queued to every client without waiting for the slow ones, the packets are written from the
+    // memory of the products; without clients they are dropped here (the DSP pipeline computes none of them).
+    // Heartbeats and client packets are handled by the server event loop, so nothing here waits for the network.
+    while (signalQueue_->wait_and_pop(data_)) {
+        sendProducts(data_);
+        data_.reset();
+    }
 #ifdef _THREAD_TCPCLIENT_DEBUG_
-        std::cout << termColor("yellow") << "Connection closed, waiting for new connection." << termColor("nocolor")
-                  << std::endl;
+    std::cout << termColor("yellow") << "TCP send thread stopped." << termColor("nocolor") << std::endl;
 #endif // _THREAD_TCPCLIENT_DEBUG_
-    }
 }
 
 void ThreadTcpCommunication::joinThread() {
@@ -230,8 +216,9 @@ void ThreadTcpCommunication::joinThread() {
 }
 
 void ThreadTcpCommunication::stopThread() {
-    std::lock_guard<std::mutex> lock(mtx_);
-    stopFlag_ = true;
+    if (signalQueue_ != nullptr) {
+        signalQueue_->close();
+    }
 }
 
 TcpSignalType::TcpSignalType(bool init, int cn, int sl, const std::vector<std::vector<double>> &channels, int type)
@@ -265,6 +252,16 @@ uint32_t TcpSignalType::calculateChecksum() const {
 
 // serialize to byte array
 void TcpSignalType::serialize(char *buffer) const {
+    int offset = serializeHeader(buffer, packetLength, signalType, isInit, channelNum, signalLength);
+
+    memcpy(buffer + offset, channelData.data(), channelData.size() * sizeof(double));
+    offset += channelData.size() * sizeof(double);
+
+    memcpy(buffer + offset, &checksum, sizeof(checksum));
+}
+
+int TcpSignalType::serializeHeader(char *buffer, int packetLength, int signalType, bool isInit, int channelNum,
+                                   int signalLength) {
     int offset = 0;
 
     memcpy(buffer + offset, &packetLength, sizeof(packetLength));
@@ -282,20 +279,43 @@ void TcpSignalType::serialize(char *buffer) const {
     memcpy(buffer + offset, &signalLength, sizeof(signalLength));
     offset += sizeof(signalLength);
 
-    memcpy(buffer + offset, channelData.data(), channelData.size() * sizeof(double));
-    offset += channelData.size() * sizeof(double);
+    return offset;
+}
 
-    memcpy(buffer + offset, &checksum, sizeof(checksum));
+tcpServer::Frame TcpSignalType::makeFrame(const std::shared_ptr<const ChannelSignalVector> &signal, int type) {
+    std::shared_ptr<TcpFrame> frame    = std::make_shared<TcpFrame>();
+    uLong                     checksum = crc32(0L, Z_NULL, 0);
+    size_t                    dataSize = 0;
+    for (const auto &channel : signal->channels) {
+        const uint8_t *data   = reinterpret_cast<const uint8_t *>(channel.data());
+        size_t         length = channel.size() * sizeof(double);
+        frame->blocks.emplace_back(data, length);
+        checksum = crc32(checksum, data, length);
+        dataSize += length;
+    }
+    frame->owner = signal;
+
+    uint32_t checksum32   = static_cast<uint32_t>(checksum);
+    int      packetLength = static_cast<int>(HEADER_LENGTH + dataSize + sizeof(checksum32));
+    frame->headerLength   = serializeHeader(reinterpret_cast<char *>(frame->header), packetLength, type, true,
+                                            signal->channelNum, signal->signalLength);
+    memcpy(frame->trailer, &checksum32, sizeof(checksum32));
+    frame->trailerLength = sizeof(checksum32);
+    return frame;
 }
 
 // deserialize from byte array
-TcpSignalType TcpSignalType::deserialize(const char *buffer) {
+bool TcpSignalType::deserialize(const char *buffer, size_t length, TcpSignalType &packet) {
     int      offset = 0;
     int      packetLength, signalType;
     bool     isInit;
     int      channelNum, signalLength;
     uint32_t checksum;
 
+    if (length < static_cast<size_t>(HEADER_LENGTH) + sizeof(checksum)) {
+        return false;
+    }
+
     memcpy(&packetLength, buffer + offset, sizeof(packetLength));
     offset += sizeof(packetLength);
 
@@ -311,13 +331,22 @@ TcpSignalType TcpSignalType::deserialize(const char *buffer) {
     memcpy(&signalLength, buffer + offset, sizeof(signalLength));
     offset += sizeof(signalLength);
 
-    std::vector<std::vector<double>> channels(channelNum, std::vector<double>(signalLength));
-    for (int i = 0; i < channelNum; ++i) {
-        memcpy(channels[i].data(), buffer + offset, signalLength * sizeof(double));
+    // heartbeats carry no data whatever channelNum and signalLength say
+    bool    isHeartbeat = signalType == TCP_PACKET_HEARTBEAT || signalType == TCP_PACKET_HEARTBEAT_RESPONSE;
+    int64_t dataSize    = isHeartbeat ? 0 : static_cast<int64_t>(channelNum) * signalLength * sizeof(double);
+    if (packetLength < 0 || static_cast<size_t>(packetLength) != length || channelNum < 0 || signalLength < 0 ||
+        HEADER_LENGTH + dataSize + static_cast<int64_t>(sizeof(checksum)) != packetLength) {
+        return false;
+    }
+
+    std::vector<std::vector<double>> channels(isHeartbeat ? 0 : channelNum, std::vector<double>(signalLength));
+    for (auto &channel : channels) {
+        memcpy(channel.data(), buffer + offset, signalLength * sizeof(double));
         offset += signalLength * sizeof(double);
     }
 
     memcpy(&checksum, buffer + offset, sizeof(checksum));
 
-    return TcpSignalType(isInit, channelNum, signalLength, channels, signalType);
-}
\ No newline at end of file
+    packet = TcpSignalType(isInit, channelNum, signalLength, channels, signalType);
+    return packet.checksum == checksum;
+}
@@ -16,14 +16,24 @@
 #include "../general/typedef.h"
 #include "../tool/ColorParse.h"
 #include "../tool/SafeQueue.hpp"
+#include "tcpProtocol.h"
 #include "tcpServer.h"
 #include <cstdint> // for uint32_t
+#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 typedef struct TcpSignalType TcpSignalType;
 
+/***
+ * @description: Streams the ping products of the DSP pipeline to the TCP clients (see tcpProtocol.h). A client gets
+ * every ping in full (TCP_PACKET_SIGNAL) until it subscribes; from then on it gets one product packet per subscription
+ * and decimation-th ping. Clients with the same subscription share the frame of a ping, and the DSP pipeline only
+ * computes the products some client currently asks for (productDemand()). The heartbeats and what the clients send
+ * are handled on the server event loop, the send thread only waits for the products.
+ */
 class ThreadTcpCommunication {
 public:
     ThreadTcpCommunication() = delete;
@@ -32,41 +42,49 @@ public:
 
     void init();
 
-    // add data queue
-    void setDataQueue(sfq::Safe_Queue<ChannelSignalVector> *dataQueue);
+    // add product queue (output of the DSP pipeline)
+    void setProductQueue(sfq::Safe_Queue<std::shared_ptr<const PingProducts>> *productQueue);
+
+    // PING_PRODUCT bits the connected clients want from the ping with this sequence number, see ThreadDSP
+    uint32_t productDemand(uint64_t seq);
 
     // init and start thread
     void startSending();
 
-    // wait for heartbeat response
-    bool waitForHeartbeatResponse();
-
     // wait for thread to finish
     void joinThread();
 
-    // stop thread
+    // stop thread: closes the product queue, the products already queued are still sent and later ones are dropped
     void stopThread();
 
 private:
-    // Configuration
-    int connectTimeout_ = 0; // [ms]
-    int sendTimeout_    = 0; // [ms]
-
     // system info
     SystemInfo systemInfo_; // system info
 
     // thread function
     void sendData(); // data sending function in thread
 
+    // queue the packets of one ping to every client
+    void sendProducts(const std::shared_ptr<const PingProducts> &products);
+
+    // packets from the clients, runs on the server event loop
+    tcpServer::Frame handlePacket(int clientId, const uint8_t *packet, size_t length);
+
     // data queue
-    sfq::Safe_Queue<ChannelSignalVector> *signalQueue_ = nullptr; // data queue
-    ChannelSignalVector                   data_;                  // data
+    sfq::Safe_Queue<std::shared_ptr<const PingProducts>> *signalQueue_ = nullptr; // data queue
+    std::shared_ptr<const PingProducts>                   data_;                  // data
+
+    // subscriptions by client id, a connected client without an entry gets the whole ping
+    std::map<int, std::vector<TcpSubscription>> subscriptions_;
+    std::mutex                                  subscriptionMtx_;
+    std::vector<int>                            clientIds_; // connected clients, refreshed every ping
+
+    std::unique_ptr<ThreadPool> encoderPool_;    // encodes the segments of the product packets
+    tcpServer::Frame            heartbeatFrame_; // sent by the server event loop
 
     // server reference
     tcpServer  &server_;     // server reference
     std::thread sendThread_; // sending thread
-    bool        stopFlag_;   // stop flag
-    std::mutex  mtx_;        // mutex to protect stopFlag
 };
 
 struct TcpSignalType {
@@ -102,8 +120,31 @@ struct TcpSignalType {
     // serialize to byte array
     void serialize(char *buffer) const;
 
-    // deserialize from byte array
-    static TcpSignalType deserialize(const char *buffer);
+    // bytes in front of the channel data: packetLength, signalType, isInit, channelNum, signalLength
+    static const int HEADER_LENGTH = 4 * sizeof(int) + sizeof(bool);
+
+    // write the header fields, returns HEADER_LENGTH
+    static int serializeHeader(char *buffer, int packetLength, int signalType, bool isInit, int channelNum,
+                               int signalLength);
+
+    /***
+     * @description: Signal packet of a ping as a scatter-gather frame, the same bytes as serialize() without flattening
+     * or copying the samples: the header is written in the frame, every channel is sent straight from the ping and the
+     * CRC32 is accumulated over the same channel blocks, so the samples are read once before the socket copy
+     * @param {shared_ptr<const ChannelSignalVector>} &signal   The ping, kept alive by the frame
+     * @param {int} type                                        Signal type
+     * @return {tcpServer::Frame}
+     */
+    static tcpServer::Frame makeFrame(const std::shared_ptr<const ChannelSignalVector> &signal, int type = 1);
+
+    /***
+     * @description: Read a packet back (client side)
+     * @param {char} *buffer            The whole packet
+     * @param {size_t} length           Bytes received for it
+     * @param {TcpSignalType} &packet   The packet
+     * @return {bool} false when packetLength, the sizes or the checksum do not match
+     */
+    static bool deserialize(const char *buffer, size_t length, TcpSignalType &packet);
 
     ~TcpSignalType() = default; // use default destructor
 };
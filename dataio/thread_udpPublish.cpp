@@ -0,0 +1,107 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 14:31:47
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 14:31:47
+ * @FilePath: /Raspi2USBL/dataio/thread_udpPublish.cpp
+ * @Description: See thread_udpPublish.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "thread_udpPublish.h"
+#include "../tool/ColorParse.h"
+#include "../tool/ThreadPolicy.h"
+#include <algorithm>
+#include <iostream>
+
+ThreadUdpPublish::ThreadUdpPublish(SystemInfo &systemInfo)
+    : systemInfo_(systemInfo)
+    , publisher_(systemInfo.udpInfo)
+    , textSender_(systemInfo) {
+}
+
+ThreadUdpPublish::~ThreadUdpPublish() {
+    stopThread();
+    joinThread();
+}
+
+void ThreadUdpPublish::setPosResQueue(sfq::Safe_Queue<PositionResult> *posResQueue) {
+    if (posResQueue_ != nullptr) {
+        std::cerr << termColor("red") << "Position result queue is setted." << termColor("nocolor") << std::endl;
+        return;
+    }
+    posResQueue_ = posResQueue;
+}
+
+void ThreadUdpPublish::setTelemetrySource(TelemetrySource source) {
+    telemetrySource_ = std::move(source);
+}
+
+bool ThreadUdpPublish::startPublishing() {
+    if (posResQueue_ == nullptr) {
+        std::cerr << termColor("red") << "Position result queue is not set." << termColor("nocolor") << std::endl;
+        return false;
+    }
+    if (!publisher_.open()) {
+        return false;
+    }
+    startTime_     = Clock::now();
+    publishThread_ = std::thread(&ThreadUdpPublish::publishData, this);
+    return true;
+}
+
+void ThreadUdpPublish::publishData() {
+    applyThreadPolicy("UDP Publish", systemInfo_.threadPolicyInfo.tcp, systemInfo_.threadPolicyInfo.prefaultStackSize);
+
+    const UdpInfo    &udpInfo  = systemInfo_.udpInfo;
+    Clock::duration   interval = std::chrono::milliseconds(udpInfo.telemetryInterval);
+    Clock::time_point deadline = startTime_ + interval;
+
+    // a fix goes out the moment the DSP pipeline hands it over, the telemetry when the wait for fixes times out
+    while (true) {
+        if (posResQueue_->wait_until_and_pop(data_, deadline)) {
+            agcGain_ = data_.agcGain;
+            publisher_.publishFix(data_);
+            if (udpInfo.textPort > 0) {
+                publisher_.publishText(textSender_.data2OutputString(data_));
+            }
+        } else if (posResQueue_->is_closed() && posResQueue_->Is_empty()) {
+            break;
+        }
+        if (Clock::now() >= deadline) {
+            publishTelemetry();
+            // a late deadline (the thread was held up) is not caught up with a burst of packets
+            deadline = std::max(deadline + interval, Clock::now());
+        }
+    }
+    publishTelemetry();
+#ifdef _THREAD_UDPPUBLISH_DEBUG_
+    std::cout << termColor("yellow") << "UDP publish thread stopped." << termColor("nocolor") << std::endl;
+#endif // _THREAD_UDPPUBLISH_DEBUG_
+}
+
+void ThreadUdpPublish::publishTelemetry() {
+    UdpTelemetry telemetry;
+    if (telemetrySource_) {
+        telemetrySource_(telemetry);
+    }
+    telemetry.uptimeMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime_).count();
+    telemetry.fixNum       = publisher_.getFixNum();
+    telemetry.sendErrorNum = publisher_.getSendErrorNum();
+    telemetry.agcGain      = agcGain_;
+    publisher_.publishTelemetry(telemetry);
+}
+
+void ThreadUdpPublish::joinThread() {
+    if (publishThread_.joinable()) {
+        publishThread_.join();
+    }
+}
+
+void ThreadUdpPublish::stopThread() {
+    if (posResQueue_ != nullptr) {
+        posResQueue_->close();
+    }
+}
@@ -0,0 +1,73 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 14:31:47
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 14:31:47
+ * @FilePath: /Raspi2USBL/dataio/thread_udpPublish.h
+ * @Description: UDP multicast publish thread of the position fixes and the telemetry
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _THREAD_UDPPUBLISH_H_
+#define _THREAD_UDPPUBLISH_H_
+
+#include "../core/systeminfo.h"
+#include "../general/typedef.h"
+#include "../tool/SafeQueue.hpp"
+#include "posResSender.h"
+#include "udpPublisher.h"
+#include <chrono>
+#include <functional>
+#include <thread>
+
+/***
+ * @description: Publishes every position fix of the DSP pipeline on the multicast group as soon as it arrives (and its
+ * $USBL sentence on the text port when there is one), and the telemetry every [UDP][telemetryInterval] ms in between.
+ * Nothing waits for the listeners, see UdpPublisher.
+ */
+class ThreadUdpPublish {
+public:
+    ThreadUdpPublish() = delete;
+    explicit ThreadUdpPublish(SystemInfo &systemInfo);
+    ~ThreadUdpPublish();
+
+    // counters of the other threads, filled in before every telemetry packet (on the publish thread)
+    typedef std::function<void(UdpTelemetry &telemetry)> TelemetrySource;
+
+    // set position result queue (output of the DSP pipeline)
+    void setPosResQueue(sfq::Safe_Queue<PositionResult> *posResQueue);
+    // set telemetry source, called before the thread is started
+    void setTelemetrySource(TelemetrySource source);
+
+    // open the socket and start thread, false when the socket can not be set up
+    bool startPublishing();
+
+    // wait for thread to finish
+    void joinThread();
+
+    // stop thread: closes the position result queue, the fixes already queued are still published
+    void stopThread();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // thread function
+    void publishData();
+    void publishTelemetry();
+
+    SystemInfo &systemInfo_;
+
+    UdpPublisher    publisher_;
+    PosResSender    textSender_; // $USBL sentence of the text mirror
+    TelemetrySource telemetrySource_;
+
+    sfq::Safe_Queue<PositionResult> *posResQueue_ = nullptr;
+    PositionResult                   data_        = PositionResult();
+    double                           agcGain_     = 0.0; // of the last fix
+    Clock::time_point                startTime_;
+
+    std::thread publishThread_;
+};
+
+#endif // _THREAD_UDPPUBLISH_H_
@@ -0,0 +1,259 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: /Raspi2USBL/dataio/udpPublisher.cpp
+ * @Description: See udpPublisher.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "udpPublisher.h"
+#include "../tool/ColorParse.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+
+// write a value at p and step past it
+template <typename T>
+void putValue(uint8_t *&p, const T &value) {
+    memcpy(p, &value, sizeof(T));
+    p += sizeof(T);
+}
+
+// read a value at p and step past it
+template <typename T>
+void getValue(const uint8_t *&p, T &value) {
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+}
+
+uint64_t realtimeUs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000ULL + static_cast<uint64_t>(ts.tv_nsec) / 1000ULL;
+}
+
+// UDP socket connected to group:port, -1 on failure
+int openSocket(const UdpInfo &udpInfo, int port) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << termColor("red") << "UdpPublisher: socket failed: " << strerror(errno) << termColor("nocolor")
+                  << std::endl;
+        return -1;
+    }
+
+    unsigned char ttl  = static_cast<unsigned char>(udpInfo.ttl);
+    unsigned char loop = udpInfo.isLoopback ? 1 : 0;
+    if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+        std::cerr << termColor("red") << "UdpPublisher: multicast options failed: " << strerror(errno)
+                  << termColor("nocolor") << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    if (!udpInfo.interfaceAddress.empty()) {
+        in_addr interface;
+        if (inet_pton(AF_INET, udpInfo.interfaceAddress.c_str(), &interface) != 1 ||
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) < 0) {
+            std::cerr << termColor("red") << "UdpPublisher: interface " << udpInfo.interfaceAddress
+                      << " can not be used: " << strerror(errno) << termColor("nocolor") << std::endl;
+            ::close(fd);
+            return -1;
+        }
+    }
+
+    // connected, so every datagram is a plain send() without the address lookup of sendto()
+    sockaddr_in group;
+    memset(&group, 0, sizeof(group));
+    group.sin_family = AF_INET;
+    group.sin_port   = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, udpInfo.group.c_str(), &group.sin_addr) != 1 ||
+        !IN_MULTICAST(ntohl(group.sin_addr.s_addr))) {
+        std::cerr << termColor("red") << "UdpPublisher: " << udpInfo.group << " is not a multicast group."
+                  << termColor("nocolor") << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&group), sizeof(group)) < 0) {
+        std::cerr << termColor("red") << "UdpPublisher: connect to " << udpInfo.group << ":" << port
+                  << " failed: " << strerror(errno) << termColor("nocolor") << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+UdpPublisher::UdpPublisher(const UdpInfo &udpInfo)
+    : udpInfo_(udpInfo) {
+}
+
+UdpPublisher::~UdpPublisher() {
+    close();
+}
+
+bool UdpPublisher::open() {
+    close();
+    fd_ = openSocket(udpInfo_, udpInfo_.port);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (udpInfo_.textPort > 0) {
+        textFd_ = openSocket(udpInfo_, udpInfo_.textPort);
+        if (textFd_ < 0) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void UdpPublisher::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (textFd_ >= 0) {
+        ::close(textFd_);
+        textFd_ = -1;
+    }
+}
+
+size_t UdpPublisher::makePacket(uint8_t type, uint32_t sequence, const uint8_t *body, size_t bodyLength) {
+    uint16_t length = static_cast<uint16_t>(UDP_HEADER_LENGTH + bodyLength + sizeof(uint32_t));
+    uint8_t *p      = buffer_;
+    putValue(p, UDP_MAGIC);
+    putValue(p, UDP_VERSION);
+    putValue(p, type);
+    putValue(p, length);
+    putValue(p, sequence);
+    putValue(p, realtimeUs());
+    memcpy(p, body, bodyLength);
+    p += bodyLength;
+    uint32_t checksum = crc32(0L, buffer_, p - buffer_);
+    putValue(p, checksum);
+    return length;
+}
+
+bool UdpPublisher::send(int fd, size_t length) {
+    // never waits: a full socket buffer or a missing route drops the datagram, as the network would
+    if (fd < 0 || ::send(fd, buffer_, length, MSG_DONTWAIT) != static_cast<ssize_t>(length)) {
+        sendErrorNum_++;
+        return false;
+    }
+    return true;
+}
+
+bool UdpPublisher::publishFix(const PositionResult &fix) {
+    uint8_t  body[UDP_FIX_LENGTH];
+    uint8_t *p = body;
+    putValue(p, fix.seq);
+    putValue(p, fix.sampleIndex);
+    putValue(p, fix.tof);
+    putValue(p, fix.doa);
+    putValue(p, fix.position.x());
+    putValue(p, fix.position.y());
+    putValue(p, fix.position.z());
+    putValue(p, fix.agcGain);
+
+    size_t length = makePacket(UDP_PACKET_FIX, fixSeq_++, body, sizeof(body));
+    fixNum_++;
+    return send(fd_, length);
+}
+
+bool UdpPublisher::publishTelemetry(const UdpTelemetry &telemetry) {
+    uint8_t  body[UDP_TELEMETRY_LENGTH];
+    uint8_t *p = body;
+    putValue(p, telemetry.uptimeMs);
+    putValue(p, telemetry.pingNum);
+    putValue(p, telemetry.outOfOrderNum);
+    putValue(p, telemetry.inputBacklog);
+    putValue(p, telemetry.tcpClientNum);
+    putValue(p, telemetry.tcpFramesDropped);
+    putValue(p, telemetry.fixNum);
+    putValue(p, telemetry.sendErrorNum);
+    putValue(p, telemetry.agcGain);
+
+    size_t length = makePacket(UDP_PACKET_TELEMETRY, telemetrySeq_++, body, sizeof(body));
+    return send(fd_, length);
+}
+
+bool UdpPublisher::publishText(const std::string &sentence) {
+    if (textFd_ < 0) {
+        return false;
+    }
+    if (::send(textFd_, sentence.data(), sentence.size(), MSG_DONTWAIT) != static_cast<ssize_t>(sentence.size())) {
+        sendErrorNum_++;
+        return false;
+    }
+    return true;
+}
+
+bool decodeUdpPacket(const uint8_t *packet, size_t length, UdpPacket &result) {
+    if (length < UDP_HEADER_LENGTH + sizeof(uint32_t)) {
+        return false;
+    }
+    const uint8_t *p = packet;
+    uint32_t       magic;
+    uint8_t        version;
+    uint16_t       packetLength;
+    getValue(p, magic);
+    getValue(p, version);
+    getValue(p, result.type);
+    getValue(p, packetLength);
+    getValue(p, result.sequence);
+    getValue(p, result.timeUs);
+    if (magic != UDP_MAGIC || version != UDP_VERSION || packetLength != length) {
+        return false;
+    }
+
+    size_t bodyLength = length - UDP_HEADER_LENGTH - sizeof(uint32_t);
+    if ((result.type == UDP_PACKET_FIX && bodyLength != UDP_FIX_LENGTH) ||
+        (result.type == UDP_PACKET_TELEMETRY && bodyLength != UDP_TELEMETRY_LENGTH) ||
+        (result.type != UDP_PACKET_FIX && result.type != UDP_PACKET_TELEMETRY)) {
+        return false;
+    }
+    uint32_t checksum;
+    memcpy(&checksum, packet + length - sizeof(uint32_t), sizeof(checksum));
+    if (checksum != crc32(0L, packet, length - sizeof(uint32_t))) {
+        return false;
+    }
+
+    if (result.type == UDP_PACKET_FIX) {
+        PositionResult &fix = result.fix;
+        double          x, y, z;
+        getValue(p, fix.seq);
+        getValue(p, fix.sampleIndex);
+        getValue(p, fix.tof);
+        getValue(p, fix.doa);
+        getValue(p, x);
+        getValue(p, y);
+        getValue(p, z);
+        getValue(p, fix.agcGain);
+        fix.position = Eigen::Vector3d(x, y, z);
+        fix.time     = result.timeUs * 1e-6;
+    } else {
+        UdpTelemetry &telemetry = result.telemetry;
+        getValue(p, telemetry.uptimeMs);
+        getValue(p, telemetry.pingNum);
+        getValue(p, telemetry.outOfOrderNum);
+        getValue(p, telemetry.inputBacklog);
+        getValue(p, telemetry.tcpClientNum);
+        getValue(p, telemetry.tcpFramesDropped);
+        getValue(p, telemetry.fixNum);
+        getValue(p, telemetry.sendErrorNum);
+        getValue(p, telemetry.agcGain);
+    }
+    return true;
+}
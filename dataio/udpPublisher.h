@@ -0,0 +1,122 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: /Raspi2USBL/dataio/udpPublisher.h
+ * @Description: UDP multicast publisher of the position fixes and the telemetry: packet layout, socket and decoder
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _UDPPUBLISHER_H_
+#define _UDPPUBLISHER_H_
+
+#include "../core/systeminfo.h"
+#include "../general/typedef.h"
+#include <cstdint>
+#include <string>
+
+/***
+ * Every datagram is one packet (native byte order, no padding):
+ *     uint32 magic | uint8 version | uint8 type | uint16 length | uint32 sequence | uint64 timeUs
+ * followed by the body of the type and the CRC32 (uint32) of everything in front of it. length counts the whole
+ * packet, sequence counts the packets of the type (a gap is a lost datagram), timeUs is the wall clock
+ * (CLOCK_REALTIME, us since the epoch) when the packet was made.
+ *     UDP_PACKET_FIX          uint64 pingSeq | uint64 sampleIndex | double tof | double doa | double x | double y |
+ *                             double z | double agcGain
+ *     UDP_PACKET_TELEMETRY    uint64 uptimeMs | uint64 pingNum | uint64 outOfOrderNum | uint32 inputBacklog |
+ *                             uint32 tcpClientNum | uint64 tcpFramesDropped | uint64 fixNum | uint64 sendErrorNum |
+ *                             double agcGain
+ * The $USBL text mirror (PosResSender) goes to its own port, one sentence per datagram.
+ * decodeUdpPacket() is the reference decoder of the listener side.
+ */
+
+// type of the packet header
+enum UDP_PACKET_TYPE {
+    UDP_PACKET_FIX       = 1, // one position fix per ping
+    UDP_PACKET_TELEMETRY = 2  // health counters, every telemetryInterval ms
+};
+
+static const uint32_t UDP_MAGIC            = 0x4C425355; // "USBL" in little endian
+static const uint8_t  UDP_VERSION          = 1;
+static const int      UDP_HEADER_LENGTH    = 20;
+static const int      UDP_FIX_LENGTH       = 64; // body bytes
+static const int      UDP_TELEMETRY_LENGTH = 64;
+static const int      UDP_MAX_PACKET       = UDP_HEADER_LENGTH + 64 + 4; // header, the longest body, checksum
+
+// health counters of the telemetry packet
+typedef struct UdpTelemetry {
+    uint64_t uptimeMs         = 0; // since the publisher started
+    uint64_t pingNum          = 0; // pings that left the DSP pipeline
+    uint64_t outOfOrderNum    = 0; // of them out of order
+    uint32_t inputBacklog     = 0; // blocks waiting in front of the DSP pipeline
+    uint32_t tcpClientNum     = 0;
+    uint64_t tcpFramesDropped = 0; // by the slow-client policy, summed over the connected clients
+    uint64_t fixNum           = 0; // fixes published
+    uint64_t sendErrorNum     = 0; // datagrams the socket did not take
+    double   agcGain          = 0; // gain voltage of the last fix
+} UdpTelemetry;
+
+// a packet read back by decodeUdpPacket()
+typedef struct UdpPacket {
+    uint8_t        type     = 0;
+    uint32_t       sequence = 0;
+    uint64_t       timeUs   = 0;
+    PositionResult fix      = PositionResult(); // UDP_PACKET_FIX, time is timeUs in s
+    UdpTelemetry   telemetry;                   // UDP_PACKET_TELEMETRY
+} UdpPacket;
+
+/***
+ * @description: Connectionless sender of the multicast group: the datagrams are written without waiting, a listener
+ * that joins or leaves changes nothing on this side. Not thread safe, one thread publishes.
+ */
+class UdpPublisher {
+public:
+    UdpPublisher() = delete;
+    explicit UdpPublisher(const UdpInfo &udpInfo);
+    ~UdpPublisher();
+
+    UdpPublisher(const UdpPublisher &)            = delete;
+    UdpPublisher &operator=(const UdpPublisher &) = delete;
+
+    /***
+     * @description: Create the socket (TTL, loopback, interface) and connect it to the group
+     * @return {bool} false when the socket can not be set up, the reason is printed
+     */
+    bool open();
+    void close();
+
+    // one packet each, false when the socket did not take it (counted in getSendErrorNum())
+    bool publishFix(const PositionResult &fix);
+    bool publishTelemetry(const UdpTelemetry &telemetry);
+    bool publishText(const std::string &sentence);
+
+    uint64_t getFixNum() const { return fixNum_; }
+    uint64_t getSendErrorNum() const { return sendErrorNum_; }
+
+private:
+    // header, body and checksum of one packet into buffer_, returns the packet length
+    size_t makePacket(uint8_t type, uint32_t sequence, const uint8_t *body, size_t bodyLength);
+    bool   send(int fd, size_t length);
+
+    UdpInfo  udpInfo_;
+    int      fd_           = -1; // connected to group:port
+    int      textFd_       = -1; // connected to group:textPort
+    uint32_t fixSeq_       = 0;
+    uint32_t telemetrySeq_ = 0;
+    uint64_t fixNum_       = 0;
+    uint64_t sendErrorNum_ = 0;
+    uint8_t  buffer_[UDP_MAX_PACKET];
+};
+
+/***
+ * @description: Reference decoder of a packet (listener side)
+ * @param {uint8_t} *packet     The datagram
+ * @param {size_t} length       Bytes received
+ * @param {UdpPacket} &result   The header fields and the body of its type
+ * @return {bool} false when magic, version, type, length or checksum are wrong
+ */
+bool decodeUdpPacket(const uint8_t *packet, size_t length, UdpPacket &result);
+
+#endif // _UDPPUBLISHER_H_
@@ -0,0 +1,145 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 20:06:52
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 20:06:52
+ * @FilePath: /Raspi2USBL/dsp/agcBenchmark.cpp
+ * @Description: See agcBenchmark.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "agcBenchmark.h"
+#include "agcController.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+
+namespace {
+const double PING_PERIOD     = 1.0;  // s
+const double HEADROOM_DB     = 12.0; // raw peak below the clip level for a peak in the middle of the window
+const double FADING_DB       = 1.0;
+const int    CLIPPED_SAMPLES = 100;
+const double CLIPPED_PEAK    = 0.5; // correlation peak of a clipped ping, relative to the peak at the clip level
+
+typedef struct AgcScenario {
+    std::string                name;
+    int                        pingNum;
+    int                        eventPing; // settling is counted from here
+    double                     startGain; // the first ping is in the middle of the window at this gain
+    std::function<double(int)> range;     // m, of a ping
+    std::function<double(int)> sourceDb;  // source level change (dB), of a ping
+} AgcScenario;
+
+typedef struct AgcScore {
+    int    settlePings  = -1; // -1: still outside at the end
+    int    outsidePings = 0;
+    int    clippedPings = 0;
+    double meanErrorDb  = 0.0;
+} AgcScore;
+
+double transmissionLoss(double range, double absorption) {
+    range = std::max(range, 1.0);
+    return 20.0 * std::log10(range) + absorption * range / 1000.0;
+}
+
+AgcScore runScenario(const SystemInfo &systemInfo, AGC_CONTROLLER type, const AgcScenario &scenario) {
+    SystemInfo info            = systemInfo;
+    info.agcInfo.controller    = type;
+    info.agcInfo.initGainValue = scenario.startGain;
+    const AgcInfo &agcInfo     = info.agcInfo;
+    double         soundSpeed  = info.signalProcessInfo.soundSpeed;
+    auto           gainDb      = [&](double gain) { return agcInfo.gainSlope * gain + agcInfo.gainOffset; };
+
+    std::unique_ptr<AgcController> controller = createAgcController(info);
+
+    double center   = std::sqrt(agcInfo.minPower * agcInfo.maxPower);
+    double centerDb = 20.0 * std::log10(center);
+    double levelDb  = centerDb - gainDb(scenario.startGain) + transmissionLoss(scenario.range(0), agcInfo.absorption);
+    double clipPeak = center * std::pow(10.0, HEADROOM_DB / 20.0);
+
+    std::mt19937                           generator(1);
+    std::uniform_real_distribution<double> fading(-FADING_DB, FADING_DB);
+
+    AgcScore score;
+    int      lastOutside = -1;
+    double   gain        = scenario.startGain;
+    for (int i = 0; i < scenario.pingNum; i++) {
+        double range  = scenario.range(i);
+        double peakDb = levelDb + scenario.sourceDb(i) + gainDb(gain) - transmissionLoss(range, agcInfo.absorption) +
+                        fading(generator);
+        double peak = std::pow(10.0, peakDb / 20.0);
+
+        AgcMeasurement measurement;
+        measurement.time      = i * PING_PERIOD;
+        measurement.tof       = range / soundSpeed;
+        measurement.peakPower = peak;
+        measurement.rawPeak   = agcInfo.saturationLevel * peak / clipPeak;
+        bool isClipped        = peak >= clipPeak;
+        if (isClipped) {
+            // the clipped pulse spreads out of the band, the correlation peak drops
+            measurement.clippedNum = CLIPPED_SAMPLES;
+            measurement.peakPower  = clipPeak * CLIPPED_PEAK;
+            measurement.rawPeak    = agcInfo.saturationLevel;
+        }
+        // the gain of the last update is confirmed before the next ping
+        measurement.gainTag.state  = GAIN_SETTLED;
+        measurement.gainTag.gain   = gain;
+        measurement.gainTag.gainDb = gainDb(gain);
+        measurement.gainTag.scale  = std::pow(10.0, -measurement.gainTag.gainDb / 20.0);
+        measurement.gainTag.seq    = static_cast<uint64_t>(i);
+        gain                       = controller->update(measurement);
+
+        bool isInside = !isClipped && peak >= agcInfo.minPower && peak <= agcInfo.maxPower;
+        if (!isInside) {
+            score.outsidePings++;
+            lastOutside = i;
+        }
+        score.clippedPings += isClipped ? 1 : 0;
+        score.meanErrorDb += std::abs(peakDb - centerDb) / scenario.pingNum;
+    }
+    if (lastOutside < scenario.pingNum - 1) {
+        score.settlePings = std::max(lastOutside + 1 - scenario.eventPing, 0);
+    }
+    return score;
+}
+
+void printScore(const std::string &name, const AgcScore &score) {
+    std::cout << termColor("blue") << std::left << std::setw(30) << name << termColor("yellow") << std::right;
+    if (score.settlePings < 0) {
+        std::cout << std::setw(10) << "-" << " settle";
+    } else {
+        std::cout << std::setw(10) << score.settlePings << " settle";
+    }
+    std::cout << std::setw(10) << score.outsidePings << " outside" << std::setw(6) << score.clippedPings
+              << " clipped" << std::fixed << std::setprecision(1) << std::setw(8) << score.meanErrorDb << " dB"
+              << termColor("nocolor") << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+} // namespace
+
+void benchmarkAgcControllers(SystemInfo &systemInfo) {
+    std::vector<AgcScenario> scenarios;
+    scenarios.push_back({"Range step 50 -> 1000 m", 80, 10, 1.0, [](int i) { return i < 10 ? 50.0 : 1000.0; },
+                         [](int) { return 0.0; }});
+    scenarios.push_back({"Approach 10 m/s, 600 -> 30 m", 80, 0, 2.5,
+                         [](int i) { return std::max(600.0 - 10.0 * i * PING_PERIOD, 30.0); },
+                         [](int) { return 0.0; }});
+    scenarios.push_back({"Source +24 dB (clipping)", 80, 10, 1.5, [](int) { return 300.0; },
+                         [](int i) { return i < 10 ? 0.0 : 24.0; }});
+
+    const AgcInfo &agcInfo = systemInfo.agcInfo;
+    std::cout << termColor("blue") << "AGC benchmark: " << termColor("yellow") << "window [" << agcInfo.minPower << ", "
+              << agcInfo.maxPower << "], " << agcInfo.gainSlope << " dB/V" << termColor("nocolor") << std::endl;
+    for (const AgcScenario &scenario : scenarios) {
+        std::cout << termColor("blue") << scenario.name << termColor("nocolor") << std::endl;
+        for (AGC_CONTROLLER type : {AGC_BANG_BANG, AGC_PI, AGC_FEED_FORWARD}) {
+            printScore("  " + agcController2Str(type), runScenario(systemInfo, type, scenario));
+        }
+    }
+    std::cout << termColor("blue")
+              << "---------------------------------------------------------------------------------------------"
+              << termColor("nocolor") << std::endl;
+}
@@ -0,0 +1,30 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 20:06:52
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 20:06:52
+ * @FilePath: /Raspi2USBL/dsp/agcBenchmark.h
+ * @Description: Replay of the AGC controllers on simulated range and level scenarios, run in benchmark mode
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _AGCBENCHMARK_H_
+#define _AGCBENCHMARK_H_
+
+#include "../core/systeminfo.h"
+
+/***
+ * @description: Run every AGC controller (benchmark mode, see runBenchmarks()) on the same simulated pings, one per
+ * second: a range step (50 m to 1000 m), a fast approach (10 m/s from 600 m to 30 m) and a source level step of
+ * +24 dB that clips the ADC. The level of a ping follows the gain it was acquired with (gainSlope, gainOffset), the
+ * transmission loss (spreading and absorption) and +-1 dB of fading; a ping clips above saturationLevel, which lowers
+ * its correlation peak. Printed per controller: the pings to settle after the event (the peak stays inside
+ * [minPower, maxPower] from then on), the pings outside the window, the clipped pings and the mean level error (dB
+ * from the middle of the window).
+ * @param {SystemInfo} &systemInfo
+ * @return {*}
+ */
+void benchmarkAgcControllers(SystemInfo &systemInfo);
+
+#endif // _AGCBENCHMARK_H_
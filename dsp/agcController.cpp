@@ -0,0 +1,146 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 19:24:37
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 19:24:37
+ * @FilePath: /Raspi2USBL/dsp/agcController.cpp
+ * @Description: See agcController.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "agcController.h"
+#include <algorithm>
+#include <cmath>
+
+constexpr double PIController::MAX_ERROR_DB;
+constexpr double FeedForwardController::MAX_RANGE_RATE;
+constexpr double FeedForwardController::MIN_RANGE;
+
+void detectSaturation(const ChannelSignalVector &signal, double level, AgcMeasurement &measurement) {
+    for (const auto &channel : signal.channels) {
+        for (double value : channel) {
+            double magnitude = std::abs(value);
+            if (magnitude >= level) {
+                measurement.clippedNum++;
+            }
+            measurement.rawPeak = std::max(measurement.rawPeak, magnitude);
+        }
+    }
+}
+
+AgcController::AgcController(const AgcInfo &agcInfo)
+    : agcInfo_(agcInfo)
+    , gain_(agcInfo.initGainValue) {
+}
+
+void AgcController::reset() {
+    gain_ = agcInfo_.initGainValue;
+}
+
+bool AgcController::isSaturated(const AgcMeasurement &measurement) const {
+    return measurement.clippedNum >= SATURATION_SAMPLES;
+}
+
+double AgcController::appliedGain(const AgcMeasurement &measurement) const {
+    return measurement.gainTag.state == GAIN_UNKNOWN ? gain_ : measurement.gainTag.gain;
+}
+
+double AgcController::clampGain(double gain) const {
+    return std::min(std::max(gain, agcInfo_.minGainValue), agcInfo_.maxGainValue);
+}
+
+BangBangController::BangBangController(const AgcInfo &agcInfo)
+    : AgcController(agcInfo) {
+}
+
+double BangBangController::update(const AgcMeasurement &measurement) {
+    if (measurement.peakPower > agcInfo_.maxPower || isSaturated(measurement)) {
+        gain_ -= agcInfo_.gainStep;
+    } else if (measurement.peakPower < agcInfo_.minPower) {
+        gain_ += agcInfo_.gainStep;
+    }
+    return gain_ = clampGain(gain_);
+}
+
+PIController::PIController(const AgcInfo &agcInfo)
+    : AgcController(agcInfo) {
+}
+
+void PIController::reset() {
+    AgcController::reset();
+    lastError_ = 0.0;
+}
+
+double PIController::update(const AgcMeasurement &measurement) {
+    double correctionDb;
+    if (isSaturated(measurement)) {
+        correctionDb = -agcInfo_.saturationBackoff;
+        lastError_   = 0.0;
+    } else {
+        double error = 0.0;
+        if (measurement.peakPower > agcInfo_.maxPower || measurement.peakPower < agcInfo_.minPower) {
+            double target = std::sqrt(agcInfo_.minPower * agcInfo_.maxPower);
+            error         = MAX_ERROR_DB; // no peak at all
+            if (measurement.peakPower > 0) {
+                error = 20.0 * std::log10(target / measurement.peakPower);
+                error = std::min(std::max(error, -MAX_ERROR_DB), MAX_ERROR_DB);
+            }
+        }
+        correctionDb = agcInfo_.piKp * (error - lastError_) + agcInfo_.piKi * error;
+        lastError_   = error;
+    }
+    return gain_ = clampGain(appliedGain(measurement) + correctionDb / agcInfo_.gainSlope);
+}
+
+FeedForwardController::FeedForwardController(const AgcInfo &agcInfo, double soundSpeed)
+    : PIController(agcInfo)
+    , soundSpeed_(soundSpeed) {
+}
+
+void FeedForwardController::reset() {
+    PIController::reset();
+    isRangeKnown_ = false;
+}
+
+double FeedForwardController::transmissionLoss(double range) const {
+    range = std::max(range, MIN_RANGE);
+    return 20.0 * std::log10(range) + agcInfo_.absorption * range / 1000.0;
+}
+
+double FeedForwardController::update(const AgcMeasurement &measurement) {
+    double gain = PIController::update(measurement);
+    if (measurement.tof <= 0) {
+        isRangeKnown_ = false;
+        return gain;
+    }
+
+    double range = soundSpeed_ * measurement.tof;
+    double dt    = measurement.time - lastTime_;
+    if (isRangeKnown_ && dt > 0 && !isSaturated(measurement)) {
+        double rangeRate = (range - lastRange_) / dt;
+        if (std::abs(rangeRate) <= MAX_RANGE_RATE) {
+            // the next ping comes after about the same interval
+            double nextRange = range + rangeRate * dt;
+            double lossDb    = transmissionLoss(nextRange) - transmissionLoss(range);
+            gain_            = clampGain(gain + lossDb / agcInfo_.gainSlope);
+        }
+    }
+    isRangeKnown_ = true;
+    lastRange_    = range;
+    lastTime_     = measurement.time;
+    return gain_;
+}
+
+std::unique_ptr<AgcController> createAgcController(const SystemInfo &systemInfo) {
+    const AgcInfo &agcInfo = systemInfo.agcInfo;
+    switch (agcInfo.controller) {
+        case AGC_PI:
+            return std::unique_ptr<AgcController>(new PIController(agcInfo));
+        case AGC_FEED_FORWARD:
+            return std::unique_ptr<AgcController>(
+                new FeedForwardController(agcInfo, systemInfo.signalProcessInfo.soundSpeed));
+        default:
+            return std::unique_ptr<AgcController>(new BangBangController(agcInfo));
+    }
+}
@@ -0,0 +1,123 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 19:24:37
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 19:24:37
+ * @FilePath: /Raspi2USBL/dsp/agcController.h
+ * @Description: AGC controllers: derive the gain voltage of the next ping from the level of the last one
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _AGCCONTROLLER_H_
+#define _AGCCONTROLLER_H_
+
+#include "../core/systeminfo.h"
+#include "../general/typedef.h"
+#include <memory>
+
+// what a controller gets from one ping
+typedef struct AgcMeasurement {
+    double  time       = 0.0; // acquisition time of the ping (s, any origin)
+    double  tof        = 0.0; // s, 0 when unknown
+    double  peakPower  = 0.0; // correlation peak, as received
+    int     clippedNum = 0;   // raw samples at or above [AGC] saturationLevel
+    double  rawPeak    = 0.0; // largest raw sample magnitude (V)
+    GainTag gainTag;          // gain the ping was acquired with
+} AgcMeasurement;
+
+/***
+ * @description: Count the raw samples at or above level (the input of the ADC clips there, the correlation peak of a
+ * clipped ping is too low), before any filter
+ * @param {ChannelSignalVector} &signal
+ * @param {double} level            [AGC] saturationLevel
+ * @param {AgcMeasurement} &measurement  clippedNum and rawPeak are added to
+ * @return {*}
+ */
+void detectSaturation(const ChannelSignalVector &signal, double level, AgcMeasurement &measurement);
+
+/***
+ * @description: Base of the AGC controllers ([AGC] controller). update() gets the measurement of every ping and
+ * returns the gain voltage for the next one, within [minGain, maxGain].
+ */
+class AgcController {
+public:
+    explicit AgcController(const AgcInfo &agcInfo);
+    virtual ~AgcController() = default;
+
+    virtual double update(const AgcMeasurement &measurement) = 0;
+    // back to the init gain, the history is forgotten
+    virtual void   reset();
+
+    // a ping with at least this many clipped samples is saturated
+    static const int SATURATION_SAMPLES = 3;
+
+protected:
+    bool   isSaturated(const AgcMeasurement &measurement) const;
+    // the gain the ping was acquired with, the last one returned when it is not known
+    double appliedGain(const AgcMeasurement &measurement) const;
+    double clampGain(double gain) const;
+
+    AgcInfo agcInfo_;
+    double  gain_; // last gain returned
+};
+
+/***
+ * @description: The fixed step controller: gainStep down when the peak is above maxPower or the ping is saturated,
+ * up when it is below minPower. Many pings to recover from a large level change.
+ */
+class BangBangController : public AgcController {
+public:
+    explicit BangBangController(const AgcInfo &agcInfo);
+    double update(const AgcMeasurement &measurement) override;
+};
+
+/***
+ * @description: PI controller on the level in dB. The error is the distance of the peak level from the middle of
+ * [minPower, maxPower] (geometric mean), 0 inside the window so the gain holds there, and at most MAX_ERROR_DB. The
+ * correction piKp * (error - last error) + piKi * error is added to the gain the ping was acquired with, not to the
+ * last command, so the actuation latency does not wind it up; gainSlope turns dB into volts. A saturated ping cuts the
+ * gain by saturationBackoff instead.
+ */
+class PIController : public AgcController {
+public:
+    explicit PIController(const AgcInfo &agcInfo);
+    double update(const AgcMeasurement &measurement) override;
+    void   reset() override;
+
+    // largest error of one ping (dB), a missed ping must not drive the gain to the top
+    static constexpr double MAX_ERROR_DB = 20.0;
+
+protected:
+    double lastError_ = 0.0;
+};
+
+/***
+ * @description: The PI controller plus a feed-forward of the range: the range (soundSpeed * TOF) and its rate from
+ * ping to ping predict the range of the next ping, the change of the transmission loss to it (spherical spreading,
+ * 20 log10 r, and absorption) is added to the gain before the ping arrives. A range rate above MAX_RANGE_RATE is
+ * taken as a TOF outlier and not fed forward.
+ */
+class FeedForwardController : public PIController {
+public:
+    FeedForwardController(const AgcInfo &agcInfo, double soundSpeed);
+    double update(const AgcMeasurement &measurement) override;
+    void   reset() override;
+
+    static constexpr double MAX_RANGE_RATE = 20.0; // m/s
+    static constexpr double MIN_RANGE      = 1.0;  // m, the spreading law does not hold closer
+
+private:
+    // one-way transmission loss at a range (dB)
+    double transmissionLoss(double range) const;
+
+    double soundSpeed_;
+    bool   isRangeKnown_ = false;
+    double lastRange_    = 0.0;
+    double lastTime_     = 0.0;
+};
+
+// the controller of [AGC] controller
+std::unique_ptr<AgcController> createAgcController(const SystemInfo &systemInfo);
+
+#endif // _AGCCONTROLLER_H_
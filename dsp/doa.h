@@ -12,17 +12,40 @@
 #ifndef _DOA_H_
 #define _DOA_H_
 
+#include "../tool/ThreadPool.h"
+#include "fftEngine.h"
+#include "phaseRotator.h"
 #include "signalBase.h"
 #include <Eigen/Dense>
+#include <functional>
 
-class DOA : public SignalBase {
+/***
+ * @description: Degree of arrival calculation, the FFT and the beamforming run in the scalar type T
+ * (see DSPReal in general/typedef.h). Input, output and the saved spectra stay in double.
+ */
+template <typename T>
+class DOAT : public SignalBase {
 public:
-    DOA(SystemInfo &systesminfo, ChannelSignalVector &refSignal);
-    DOA(SystemInfo &systeminfo, ChannelSignalEigenD &refSignal);
-    ~DOA() = default;
+    typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>               MatrixR;
+    typedef Eigen::Matrix<std::complex<T>, Eigen::Dynamic, Eigen::Dynamic> MatrixC;
+    typedef Eigen::Matrix<T, Eigen::Dynamic, 1>                            VectorR;
+
+    DOAT(SystemInfo &systesminfo, ChannelSignalVector &refSignal);
+    DOAT(SystemInfo &systeminfo, ChannelSignalEigenD &refSignal);
+    ~DOAT() = default;
 
     void init();
 
+    // run the channel FFTs and the frequency bins on a thread pool (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool) {
+        threadPool_ = threadPool;
+    }
+
+    // whether the next calculateDOA_CBF() also builds the full side amplitude spectrum (default: saved or not)
+    void setSideAmpSpecEnable(bool isEnable) {
+        isSideAmpSpecEnable_ = isEnable;
+    }
+
     /***
      * @description: Set the parameters for DOA calculation
      * @param {int} startDir                The start direction of the signal
@@ -42,6 +65,36 @@ public:
      */
     void calculateDOA_CBF(ChannelSignalVector &signal, double &doa);
 
+    /***
+     * @description: Calculate the DOA using the minimum variance distortionless response (Capon) beamformer.
+     * The spatial covariance of each bin (averaged over covarianceBinNumber neighbouring bins, diagonally loaded) is
+     * inverted once and reused for every angle, the Capon spectra are summed over the band.
+     * @param {ChannelSignalVector} &signal
+     * @param {double} &doa
+     * @return {*}
+     */
+    void calculateDOA_MVDR(ChannelSignalVector &signal, double &doa);
+
+    /***
+     * @description: Calculate the DOA using incoherent wideband MUSIC. The noise subspace projector of each bin is
+     * built once from the eigen decomposition of its covariance, the projections are summed over the band and the
+     * DOA is the minimum of the sum.
+     * @param {ChannelSignalVector} &signal
+     * @param {double} &doa
+     * @return {*}
+     */
+    void calculateDOA_MUSIC(ChannelSignalVector &signal, double &doa);
+
+    /***
+     * @description: Calculate the DOA on the complex baseband of the decimating front-end, startDir of setParam()
+     * counts baseband samples. The band bins sit around 0 Hz and are steered at their RF frequency (center + offset).
+     * @param {BasebandSignal} &signal
+     * @param {DOA_METHOD} method   DOA_CBF, DOA_MVDR or DOA_MUSIC
+     * @param {double} &doa
+     * @return {*}
+     */
+    void calculateDOA(const BasebandSignal &signal, DOA_METHOD method, double &doa);
+
     /***
      * @description: Calculate the DOA using the convensional beamforming method
      * @param {ChannelSignalEigenD} &signal
@@ -55,29 +108,116 @@ public:
             signalSideAmpSpec.cols() != signalSideAmpSpec_.cols()) {
             signalSideAmpSpec.resize(signalSideAmpSpec_.rows(), signalSideAmpSpec_.cols());
         }
-        signalSideAmpSpec = signalSideAmpSpec_;
+        signalSideAmpSpec = signalSideAmpSpec_.template cast<double>();
     }
 
     void getBeamPattern(Eigen::MatrixXd &beamPattern) {
         if (beamPattern.rows() != beamPattern_.rows() || beamPattern.cols() != beamPattern_.cols()) {
             beamPattern.resize(beamPattern_.rows(), beamPattern_.cols());
         }
-        beamPattern = beamPattern_;
+        beamPattern = beamPattern_.template cast<double>();
     }
 
 private:
-    ChannelSignalVector refSignal_;
-    ChannelSignalEigenD refSignalEigenD_;
-    std::vector<double> signal_freq_;
-    Eigen::MatrixXd     signalSideAmpSpec_;
-    Eigen::MatrixXd     beamPattern_;
-    bool                isSetParam_;
-    int                 startDir_;
-    int                 doaIndex_;
-    double              selectSigDuration_;
-    double              doaFreStart_;
-    double              doaFreEnd_;
-    double              doaStep_;
+    void runParallel(int count, const std::function<void(int, int)> &func);
+
+    // check the input, then the band spectrum (channelNum x binNum), the frequency of its first bin and the bin step
+    void prepareBand(const std::string &caller, ChannelSignalVector &signal, MatrixC &bandSpectrum, double &freqStart,
+                     double &freqStep);
+    void prepareBand(const std::string &caller, const BasebandSignal &signal, MatrixC &bandSpectrum, double &freqStart,
+                     double &freqStep);
+
+    // beam pattern of the band with the given method, then the DOA from its sum over the bins
+    void estimateDOA(DOA_METHOD method, const MatrixC &bandSpectrum, double freqStart, double freqStep, double &doa);
+
+    // element positions of the circular array
+    void arrayPosition(VectorR &arrayXPos, VectorR &arrayYPos) const;
+
+    /***
+     * @description: Delay-and-sum power of every bin and angle. N is the element number known at compile time
+     * (4, 6, 8 or 16, Eigen::Dynamic otherwise). The steering vectors of all angles come from a PhaseRotatorT, so
+     * one bin costs one complex multiply per element and angle plus the product x^H A.
+     * @param {MatrixC} &bandSpectrum   channelNum x binNum
+     * @param {T} waveNumberStart       The wave number of the first bin (unit: rad/m)
+     * @param {T} waveNumberStep        The wave number step between bins (unit: rad/m)
+     * @param {MatrixR} &beamPattern    binNum x angleNum, |a^H x|^2
+     * @return {*}
+     */
+    void conventionalBeamform(const MatrixC &bandSpectrum, T waveNumberStart, T waveNumberStep, MatrixR &beamPattern);
+    template <int N>
+    void conventionalBeamformN(const MatrixC &bandSpectrum, T waveNumberStart, T waveNumberStep,
+                               MatrixR &beamPattern);
+
+    /***
+     * @description: MVDR spectrum or MUSIC projection of every bin and angle, the per-bin matrices are fixed size
+     * for the 4, 6, 8 and 16 element arrays
+     * @param {MatrixC} &bandSpectrum   channelNum x binNum
+     * @param {T} waveNumberStart       The wave number of the first bin (unit: rad/m)
+     * @param {T} waveNumberStep        The wave number step between bins (unit: rad/m)
+     * @param {DOA_METHOD} method       DOA_MVDR or DOA_MUSIC
+     * @param {MatrixR} &beamPattern    binNum x angleNum, 1 / (a^H R^-1 a) for MVDR, a^H En En^H a for MUSIC
+     * @return {*}
+     */
+    void subspaceBeamform(const MatrixC &bandSpectrum, T waveNumberStart, T waveNumberStep, DOA_METHOD method,
+                          MatrixR &beamPattern);
+    template <int N>
+    void subspaceBeamformN(const MatrixC &bandSpectrum, T waveNumberStart, T waveNumberStep, DOA_METHOD method,
+                           MatrixR &beamPattern);
+
+    // path difference of every element along the look directions, cached until the step or the grid changes
+    const MatrixR &lookDistance(int angleNum);
+
+    // angle of the maximum of the summed pattern, refined between the grid points
+    double refinePeak(const VectorR &bp);
+
+    /***
+     * @description: Cost model choosing the band spectrum path: a Goertzel bank over the band bins when the band
+     * is narrow, the full FFT otherwise. The full FFT is always used when the side amplitude spectrum is built.
+     * @param {int} signalLength    The DFT length
+     * @param {int} binNum          The number of bins inside the band
+     * @return {bool}               true for the Goertzel bank
+     */
+    bool isGoertzelCheaper(int signalLength, int binNum) const;
+
+    /***
+     * @description: Spectrum of the selected window, bins dirFFTStart..dirFFTStart + binNum - 1 of each channel,
+     * scaled as the single side amplitude spectrum. The full FFT path also fills signalSideAmpSpec_ when it is enabled.
+     * @param {ChannelSignalVector} &signal     The input signal
+     * @param {int} signalLength                The DFT length
+     * @param {int} dirFFTStart                 The first bin of the band
+     * @param {int} binNum                      The number of bins inside the band
+     * @param {MatrixC} &bandSpectrum           channelNum x binNum
+     * @return {*}
+     */
+    void fftSpectrum(const ChannelSignalVector &signal, int signalLength, int dirFFTStart, int binNum,
+                     MatrixC &bandSpectrum);
+    void goertzelSpectrum(const ChannelSignalVector &signal, int signalLength, int dirFFTStart, int binNum,
+                          MatrixC &bandSpectrum);
+
+    ChannelSignalVector                        refSignal_;
+    ChannelSignalEigenD                        refSignalEigenD_;
+    std::vector<double>                        signal_freq_;
+    MatrixR                                    signalSideAmpSpec_;
+    MatrixR                                    beamPattern_;
+    std::vector<std::unique_ptr<FFTEngine<T>>> fftEngines_;
+    std::vector<double>                        goertzelCoef_;    // 2cos(w) of each band bin
+    std::vector<std::complex<double>>          goertzelTwiddle_; // exp(-jw) of each band bin
+    int                                        goertzelLength_ = 0;
+    int                                        goertzelStart_  = -1;
+    MatrixR                                    lookDistance_;          // elementNum x angleNum, see lookDistance()
+    double                                     lookDistanceStep_ = 0;  // doaStep_ of lookDistance_
+    static const int                           STEERING_ANCHOR   = 16; // bins between exact steering evaluations
+    bool                                       isSetParam_;
+    bool                                       isSideAmpSpecEnable_;
+    int                                        startDir_;
+    int                                        doaIndex_;
+    double                                     selectSigDuration_;
+    double                                     doaFreStart_;
+    double                                     doaFreEnd_;
+    double                                     doaStep_;
+    ThreadPool                                *threadPool_ = nullptr;
 };
 
+typedef DOAT<DSPReal> DOA;
+
 #endif // _DOA_H_
\ No newline at end of file
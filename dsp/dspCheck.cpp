@@ -0,0 +1,183 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 21:52:40
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 21:52:40
+ * @FilePath: /Raspi2USBL/dsp/dspCheck.cpp
+ * @Description: See dspCheck.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "dspCheck.h"
+#include "doa.h"
+#include "fftEngine.h"
+#include "tof.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+namespace {
+const double CHECK_DOA       = 60.0; // deg, direction of the synthetic ping
+const int    CHECK_OFFSET    = 1000; // samples of noise before the ping
+const double CHECK_SNR_DB    = 20.0; // reference power over noise power
+const double DOA_TOLERANCE   = 2.0;  // deg, DOA against CHECK_DOA
+const double FLOAT_TOLERANCE = 0.5;  // deg, float DOA against double
+
+// the reference at CHECK_OFFSET, delayed on every element by the plane wave from CHECK_DOA, plus white noise
+ChannelSignalVector synthesizePing(const SystemInfo &systemInfo, const ChannelSignalVector &refSignal) {
+    const ArrayInfo &arrayInfo    = systemInfo.arrayInfo;
+    double           sampleRate   = systemInfo.signalInfo.sampleRate;
+    double           soundSpeed   = systemInfo.signalProcessInfo.soundSpeed;
+    int              refLength    = refSignal.signalLength;
+    int              windowLength = static_cast<int>(systemInfo.signalProcessInfo.processDuration * sampleRate);
+    int              length       = CHECK_OFFSET + std::max(refLength, windowLength) + refLength;
+
+    double refPower = 0.0;
+    for (double value : refSignal.channels[0]) {
+        refPower += value * value / refLength;
+    }
+    std::mt19937                     generator(1);
+    std::normal_distribution<double> noise(0.0, std::sqrt(refPower / std::pow(10.0, CHECK_SNR_DB / 10.0)));
+
+    ChannelSignalVector   ping(arrayInfo.arrayNum, length);
+    FFTEngine<double>     engine(fftGoodSize(length + refLength));
+    int                   fftLength = engine.size();
+    std::complex<double> *buffer    = engine.data();
+    double                doa       = CHECK_DOA * M_PI / 180.0;
+    for (int ch = 0; ch < arrayInfo.arrayNum; ++ch) {
+        // element positions as in DOA::arrayPosition(), the element nearer to the source hears the ping earlier
+        double angle = 2 * M_PI * ch / arrayInfo.arrayNum;
+        double x     = arrayInfo.arrayDiameter / 2.0 * std::cos(angle);
+        double y     = arrayInfo.arrayDiameter / 2.0 * std::sin(angle);
+        double delay = CHECK_OFFSET - (x * std::cos(doa) + y * std::sin(doa)) / soundSpeed * sampleRate;
+
+        // fractional delay: linear phase on the spectrum of the zero padded reference
+        std::fill(buffer, buffer + fftLength, std::complex<double>(0, 0));
+        for (int i = 0; i < refLength; ++i) {
+            buffer[i] = refSignal.channels[0][i];
+        }
+        engine.forward();
+        for (int k = 0; k < fftLength; ++k) {
+            double frequency = static_cast<double>(k < fftLength / 2 ? k : k - fftLength) / fftLength;
+            buffer[k] *= std::polar(1.0, -2 * M_PI * frequency * delay);
+        }
+        engine.inverse();
+        for (int i = 0; i < length; ++i) {
+            ping.channels[ch][i] = buffer[i].real() + noise(generator);
+        }
+    }
+    return ping;
+}
+
+// peak index of every channel of the direct correlation, the TOF before the FFT matched filter
+std::vector<int> directPeakIndex(SystemInfo &systemInfo, const ChannelSignalVector &ping,
+                                 const ChannelSignalVector &refSignal) {
+    ChannelSignalVector refFliplr = refSignal;
+    std::reverse(refFliplr.channels[0].begin(), refFliplr.channels[0].end());
+    ChannelSignalVector correlation;
+    SignalBase(systemInfo).csvconv_valid(ping, refFliplr, correlation);
+
+    std::vector<int> index(ping.channelNum);
+    for (int ch = 0; ch < ping.channelNum; ++ch) {
+        const std::vector<double> &channel = correlation.channels[ch];
+        index[ch] = static_cast<int>(std::max_element(channel.begin(), channel.end()) - channel.begin());
+    }
+    return index;
+}
+
+template <typename T>
+std::vector<int> matchedFilterPeakIndex(SystemInfo &systemInfo, ChannelSignalVector ping,
+                                        ChannelSignalVector refSignal) {
+    TOFT<T>             tof(systemInfo, refSignal);
+    std::vector<double> tofRes;
+    tof.calculateTOF(ping, tofRes);
+    return tof.getMaxIndex();
+}
+
+template <typename T>
+double estimateDOA(SystemInfo &systemInfo, ChannelSignalVector ping, ChannelSignalVector refSignal, int startIndex) {
+    const SignalProcessInfo &processInfo = systemInfo.signalProcessInfo;
+    DOAT<T>                  doa(systemInfo, refSignal);
+    double                   value = 0.0;
+    doa.setParam(startIndex, processInfo.processDuration, processInfo.startFrequency, processInfo.endFrequency,
+                 processInfo.doaStep);
+    switch (processInfo.doaMethod) {
+        case DOA_MVDR:
+            doa.calculateDOA_MVDR(ping, value);
+            break;
+        case DOA_MUSIC:
+            doa.calculateDOA_MUSIC(ping, value);
+            break;
+        default:
+            doa.calculateDOA_CBF(ping, value);
+            break;
+    }
+    return value;
+}
+
+std::string indexString(const std::vector<int> &index) {
+    std::ostringstream ss;
+    for (size_t i = 0; i < index.size(); ++i) {
+        ss << (i > 0 ? " " : "") << index[i];
+    }
+    return ss.str();
+}
+
+// angle between two directions, in [0, 180]
+double angleDistance(double a, double b) {
+    return std::abs(std::remainder(a - b, 360.0));
+}
+
+bool printCheck(const std::string &name, const std::string &value, bool isPassed) {
+    std::cout << termColor("blue") << std::left << std::setw(36) << name << termColor("yellow") << value << " "
+              << termColor(isPassed ? "green" : "red") << (isPassed ? "ok" : "FAILED") << termColor("nocolor")
+              << std::endl;
+    return isPassed;
+}
+} // namespace
+
+bool checkDSPKernels(SystemInfo &systemInfo, const ChannelSignalVector &refSignal) {
+    std::cout << termColor("blue") << "DSP self-check: " << termColor("yellow")
+              << (sizeof(DSPReal) == sizeof(float) ? "float" : "double") << ", " << systemInfo.arrayInfo.arrayNum
+              << " channels, ping from " << CHECK_DOA << " deg at " << CHECK_SNR_DB << " dB SNR"
+              << termColor("nocolor") << std::endl;
+
+    bool isPassed = true;
+    try {
+        // the plain correlation peak: no pre-filter, front-end, envelope or combined peak search
+        SystemInfo info                           = systemInfo;
+        info.preFilterInfo.isEnable               = false;
+        info.signalProcessInfo.isDecimationEnable = false;
+        info.signalProcessInfo.isEnvelopeEnable   = false;
+        info.signalProcessInfo.tofMethod          = TOF_PER_CHANNEL;
+
+        ChannelSignalVector ping      = synthesizePing(info, refSignal);
+        std::vector<int>    direct    = directPeakIndex(info, ping, refSignal);
+        std::vector<int>    peakIndex = matchedFilterPeakIndex<DSPReal>(info, ping, refSignal);
+        isPassed &= printCheck("TOF peak index (csvconv_valid)", indexString(direct), true);
+        isPassed &= printCheck("TOF peak index (matched filter)", indexString(peakIndex), peakIndex == direct);
+
+        int    startIndex = *std::min_element(peakIndex.begin(), peakIndex.end());
+        double doa        = estimateDOA<DSPReal>(info, ping, refSignal, startIndex);
+        isPassed &= printCheck("DOA (" + doaMethod2Str(info.signalProcessInfo.doaMethod) + ")",
+                               std::to_string(doa) + " deg", angleDistance(doa, CHECK_DOA) <= DOA_TOLERANCE);
+
+#ifdef _DSP_SINGLE_PRECISION_
+        // the double kernels are the reference of the float build
+        std::vector<int> peakIndexDouble = matchedFilterPeakIndex<double>(info, ping, refSignal);
+        double           doaDouble       = estimateDOA<double>(info, ping, refSignal, startIndex);
+        isPassed &= printCheck("TOF peak index (double)", indexString(peakIndexDouble), peakIndexDouble == peakIndex);
+        isPassed &= printCheck("DOA (double)", std::to_string(doaDouble) + " deg",
+                               angleDistance(doa, doaDouble) <= FLOAT_TOLERANCE);
+#endif
+    } catch (const std::exception &e) {
+        std::cerr << termColor("red") << "DSP self-check: " << e.what() << termColor("nocolor") << std::endl;
+        isPassed = false;
+    }
+    std::cout << termColor("blue")
+              << "---------------------------------------------------------------------------------------------"
+              << termColor("nocolor") << std::endl;
+    return isPassed;
+}
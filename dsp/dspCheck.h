@@ -0,0 +1,33 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 21:52:40
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 21:52:40
+ * @FilePath: /Raspi2USBL/dsp/dspCheck.h
+ * @Description: Self-check of the TOF and DOA kernels on a synthetic ping, run in benchmark mode
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _DSPCHECK_H_
+#define _DSPCHECK_H_
+
+#include "../core/systeminfo.h"
+#include "../general/typedef.h"
+
+/***
+ * @description: Build a ping from the reference signal as main() hands it to the DSP pipeline: a plane wave from
+ * CHECK_DOA across the circular array (fractional delay per element), at CHECK_OFFSET samples, in white noise of
+ * CHECK_SNR_DB. Then check, with the configured array, band, duration and DOA method (pre-filter, front-end, envelope
+ * and combined TOF off, so the peak is the one of the plain correlation):
+ *     the peak index of the matched filter of every channel against the direct csvconv_valid(ping, fliplr(ref))
+ *     the DOA against CHECK_DOA, within DOA_TOLERANCE
+ *     with DSPReal float (DSP_SINGLE_PRECISION), the TOF peak indices and the DOA against the double kernels
+ * Each check is printed with its result.
+ * @param {SystemInfo} &systemInfo
+ * @param {ChannelSignalVector} &refSignal  The generated reference signal
+ * @return {bool}                           whether every check passed
+ */
+bool checkDSPKernels(SystemInfo &systemInfo, const ChannelSignalVector &refSignal);
+
+#endif // _DSPCHECK_H_
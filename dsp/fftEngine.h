@@ -0,0 +1,169 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 10:12:05
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 10:12:05
+ * @FilePath: /Raspi2USBL/dsp/fftEngine.h
+ * @Description: FFT engine templated on the DSP scalar type (fftw for double, fftwf for float)
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _FFTENGINE_H_
+#define _FFTENGINE_H_
+
+#include <complex>
+#include <cstddef>
+#include <fftw3.h>
+#include <mutex>
+#include <stdexcept>
+
+// scalar traits mapping the DSP scalar type to the fftw API of the same precision
+// only the specialization selected by DSPReal is instantiated, so the float build only needs fftw3f
+template <typename T>
+struct FFTWTraits;
+
+template <>
+struct FFTWTraits<double> {
+    typedef fftw_complex complex_type;
+    typedef fftw_plan    plan_type;
+
+    static void *malloc(size_t n) {
+        return fftw_malloc(n);
+    }
+    static void free(void *p) {
+        fftw_free(p);
+    }
+    static plan_type plan_dft_1d(int n, std::complex<double> *in, std::complex<double> *out, int sign) {
+        return fftw_plan_dft_1d(n, reinterpret_cast<complex_type *>(in), reinterpret_cast<complex_type *>(out), sign,
+                                FFTW_ESTIMATE);
+    }
+    static void execute(const plan_type p) {
+        fftw_execute(p);
+    }
+    static void destroy_plan(plan_type p) {
+        fftw_destroy_plan(p);
+    }
+};
+
+template <>
+struct FFTWTraits<float> {
+    typedef fftwf_complex complex_type;
+    typedef fftwf_plan    plan_type;
+
+    static void *malloc(size_t n) {
+        return fftwf_malloc(n);
+    }
+    static void free(void *p) {
+        fftwf_free(p);
+    }
+    static plan_type plan_dft_1d(int n, std::complex<float> *in, std::complex<float> *out, int sign) {
+        return fftwf_plan_dft_1d(n, reinterpret_cast<complex_type *>(in), reinterpret_cast<complex_type *>(out), sign,
+                                 FFTW_ESTIMATE);
+    }
+    static void execute(const plan_type p) {
+        fftwf_execute(p);
+    }
+    static void destroy_plan(plan_type p) {
+        fftwf_destroy_plan(p);
+    }
+};
+
+// the fftw planner is not thread safe, all plan creation and destruction goes through this lock
+inline std::mutex &fftwPlannerMutex() {
+    static std::mutex plannerMutex;
+    return plannerMutex;
+}
+
+// smallest length >= n whose prime factors are 2, 3, 5 or 7 (fast FFTW codelets), used for zero padded FFTs
+inline int fftGoodSize(int n) {
+    for (int m = (n > 1 ? n : 1);; ++m) {
+        int r = m;
+        while (r % 2 == 0) {
+            r /= 2;
+        }
+        while (r % 3 == 0) {
+            r /= 3;
+        }
+        while (r % 5 == 0) {
+            r /= 5;
+        }
+        while (r % 7 == 0) {
+            r /= 7;
+        }
+        if (r == 1) {
+            return m;
+        }
+    }
+}
+
+/***
+ * @description: Fixed length in-place complex FFT with plans created once and reused for every call.
+ * The working buffer is allocated with fftw_malloc (SIMD aligned). Not copyable, one engine per thread.
+ */
+template <typename T>
+class FFTEngine {
+public:
+    typedef FFTWTraits<T>   Traits;
+    typedef std::complex<T> Complex;
+
+    explicit FFTEngine(int fftLength)
+        : fftLength_(fftLength) {
+        if (fftLength_ <= 0) {
+            throw std::invalid_argument("[Error] FFTEngine: invalid FFT length.");
+        }
+        buffer_ = static_cast<Complex *>(Traits::malloc(sizeof(Complex) * fftLength_));
+        if (!buffer_) {
+            throw std::runtime_error("[Error] FFTEngine: failed to allocate memory for FFT buffer.");
+        }
+        std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+        planForward_  = Traits::plan_dft_1d(fftLength_, buffer_, buffer_, FFTW_FORWARD);
+        planBackward_ = Traits::plan_dft_1d(fftLength_, buffer_, buffer_, FFTW_BACKWARD);
+        if (!planForward_ || !planBackward_) {
+            Traits::free(buffer_);
+            throw std::runtime_error("[Error] FFTEngine: failed to create FFT plan.");
+        }
+    }
+
+    ~FFTEngine() {
+        {
+            std::lock_guard<std::mutex> lock(fftwPlannerMutex());
+            Traits::destroy_plan(planForward_);
+            Traits::destroy_plan(planBackward_);
+        }
+        Traits::free(buffer_);
+    }
+
+    FFTEngine(const FFTEngine &)            = delete;
+    FFTEngine &operator=(const FFTEngine &) = delete;
+
+    int size() const {
+        return fftLength_;
+    }
+
+    // working buffer, fill it before forward()/inverse() and read the result from it afterwards
+    Complex *data() {
+        return buffer_;
+    }
+
+    void forward() {
+        Traits::execute(planForward_);
+    }
+
+    // inverse FFT normalized by 1/N (same convention as perform_fft)
+    void inverse() {
+        Traits::execute(planBackward_);
+        const T scale = T(1) / static_cast<T>(fftLength_);
+        for (int i = 0; i < fftLength_; ++i) {
+            buffer_[i] *= scale;
+        }
+    }
+
+private:
+    int                        fftLength_;
+    Complex                   *buffer_;
+    typename Traits::plan_type planForward_;
+    typename Traits::plan_type planBackward_;
+};
+
+#endif // _FFTENGINE_H_
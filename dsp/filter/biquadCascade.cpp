@@ -0,0 +1,71 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:34:17
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:34:17
+ * @FilePath: /Raspi2USBL/dsp/filter/biquadCascade.cpp
+ * @Description: See biquadCascade.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "biquadCascade.h"
+#include "filterKernel.h"
+#include <stdexcept>
+
+template <typename T>
+BiquadCascadeT<T>::BiquadCascadeT(const std::vector<BiquadCoefficient> &sections, int channelNum)
+    : sections_(sections)
+    , channelNum_(channelNum)
+    , stride_((channelNum + 3) / 4 * 4) {
+    if (sections_.empty() || channelNum_ < 1) {
+        throw std::invalid_argument("BiquadCascade: no section or no channel");
+    }
+    coef_.resize(5 * sections_.size());
+    for (size_t s = 0; s < sections_.size(); ++s) {
+        coef_[5 * s]     = static_cast<T>(sections_[s].b0);
+        coef_[5 * s + 1] = static_cast<T>(sections_[s].b1);
+        coef_[5 * s + 2] = static_cast<T>(sections_[s].b2);
+        coef_[5 * s + 3] = static_cast<T>(sections_[s].a1);
+        coef_[5 * s + 4] = static_cast<T>(sections_[s].a2);
+    }
+    reset();
+}
+
+template <typename T>
+void BiquadCascadeT<T>::reset() {
+    state_.assign(2 * sections_.size() * stride_, T(0));
+}
+
+template <typename T>
+void BiquadCascadeT<T>::process(ChannelSignalVector &signal) {
+    if (!signal.isInit || signal.channelNum != channelNum_) {
+        throw std::invalid_argument("BiquadCascade::process: signal is not initialized or has the wrong channel "
+                                    "number");
+    }
+    int length = signal.signalLength;
+    if (length == 0) {
+        return;
+    }
+    // the padding lanes stay zero, their state as well
+    interleave_.assign(static_cast<size_t>(length) * stride_, T(0));
+    for (int ch = 0; ch < channelNum_; ++ch) {
+        const std::vector<double> &x = signal.channels[ch];
+        for (int n = 0; n < length; ++n) {
+            interleave_[static_cast<size_t>(n) * stride_ + ch] = static_cast<T>(x[n]);
+        }
+    }
+
+    biquadCascade(interleave_.data(), length, stride_, coef_.data(), static_cast<int>(sections_.size()),
+                  state_.data());
+
+    for (int ch = 0; ch < channelNum_; ++ch) {
+        std::vector<double> &y = signal.channels[ch];
+        for (int n = 0; n < length; ++n) {
+            y[n] = interleave_[static_cast<size_t>(n) * stride_ + ch];
+        }
+    }
+}
+
+// only the configured precision is instantiated
+template class BiquadCascadeT<DSPReal>;
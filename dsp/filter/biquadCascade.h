@@ -0,0 +1,70 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:34:17
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:34:17
+ * @FilePath: /Raspi2USBL/dsp/filter/biquadCascade.h
+ * @Description: Streaming multi-channel IIR filter, a cascade of biquads with the channels in the SIMD lanes
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _BIQUADCASCADE_H_
+#define _BIQUADCASCADE_H_
+
+#include "../../general/typedef.h"
+#include "filterDesign.h"
+#include <vector>
+
+/***
+ * @description: IIR filter over all channels of a stream, a cascade of biquads in transposed direct form II. The
+ * state of every section and channel is kept between the calls, so consecutive blocks are filtered as one signal, and
+ * reset() starts a new one.
+ * A biquad is a recursion along the samples and cannot be vectorized along them, but all channels run the same
+ * recursion: the block is interleaved (sample n of channel c at n * stride + c, stride rounded up to 4) and the kernel
+ * (biquadCascade, NEON on aarch64) updates 4 channels per instruction. 5 multiply-adds per sample and section.
+ * The filter runs in the scalar type T (see DSPReal in general/typedef.h), input and output stay in double.
+ */
+template <typename T>
+class BiquadCascadeT {
+public:
+    /***
+     * @description: Create the filter
+     * @param {std::vector<BiquadCoefficient>} &sections    The sections, applied in order (see filterDesign.h)
+     * @param {int} channelNum                              The number of channels of the stream
+     * @return {*}
+     */
+    BiquadCascadeT(const std::vector<BiquadCoefficient> &sections, int channelNum);
+    ~BiquadCascadeT() = default;
+
+    /***
+     * @description: Filter the next block of every channel in place
+     * @param {ChannelSignalVector} &signal     channelNum channels, any length
+     * @return {*}
+     */
+    void process(ChannelSignalVector &signal);
+
+    // zero the state, the next block starts a new stream
+    void reset();
+
+    int sectionNum() const {
+        return static_cast<int>(sections_.size());
+    }
+
+    // the group delay at the given frequency (unit: samples)
+    double groupDelay(double frequency, double sampleRate) const {
+        return biquadGroupDelay(sections_, frequency, sampleRate);
+    }
+
+private:
+    std::vector<BiquadCoefficient> sections_;
+    int                            channelNum_;
+    int                            stride_;     // channels rounded up to 4 lanes
+    std::vector<T>                 coef_;       // b0, b1, b2, a1, a2 of each section
+    std::vector<T>                 state_;      // z1 and z2 of each section, stride lanes each
+    std::vector<T>                 interleave_; // the block, sample major
+};
+
+typedef BiquadCascadeT<DSPReal> BiquadCascade;
+
+#endif // _BIQUADCASCADE_H_
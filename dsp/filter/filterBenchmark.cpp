@@ -0,0 +1,131 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 21:15:40
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 21:15:40
+ * @FilePath: /Raspi2USBL/dsp/filter/filterBenchmark.cpp
+ * @Description: See filterBenchmark.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "filterBenchmark.h"
+#include "../frontEnd.h"
+#include "biquadCascade.h"
+#include "filterKernel.h"
+#include "firFilter.h"
+#include "polyphase.h"
+#include <chrono>
+#include <functional>
+#include <random>
+
+namespace {
+// seconds per call, after one warm-up call
+double timeKernel(const std::function<void()> &kernel) {
+    kernel();
+    int    runs    = 0;
+    double elapsed = 0;
+    auto   start   = std::chrono::steady_clock::now();
+    while (runs < 3 || elapsed < 0.2) {
+        kernel();
+        ++runs;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return elapsed / runs;
+}
+
+void printResult(const std::string &name, double seconds, int channelNum, int blockLength, double sampleRate) {
+    std::cout << termColor("blue") << std::left << std::setw(30) << name << termColor("yellow") << std::right
+              << std::fixed << std::setprecision(3) << std::setw(10) << seconds * 1e3 << " ms" << std::setw(10)
+              << seconds * 1e9 / (static_cast<double>(channelNum) * blockLength) << " ns" << std::setprecision(1)
+              << std::setw(10) << blockLength / sampleRate / seconds << " x" << termColor("nocolor") << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+} // namespace
+
+void benchmarkFilterKernels(SystemInfo &systemInfo) {
+    const PreFilterInfo     &filterInfo  = systemInfo.preFilterInfo;
+    const SignalProcessInfo &processInfo = systemInfo.signalProcessInfo;
+    double                   sampleRate  = systemInfo.signalInfo.sampleRate;
+    int                      channelNum  = systemInfo.arrayInfo.arrayNum;
+    int                      blockLength = static_cast<int>(0.1 * sampleRate);
+
+    ChannelSignalVector              noise(channelNum, blockLength);
+    std::mt19937                     generator(1);
+    std::normal_distribution<double> distribution(0.0, 1.0);
+    for (auto &channel : noise.channels) {
+        for (auto &sample : channel) {
+            sample = distribution(generator);
+        }
+    }
+
+    std::cout << termColor("blue")
+              << "-----------------------------------Filter Kernel Benchmark-----------------------------------"
+              << termColor("nocolor") << std::endl;
+#ifdef _FILTER_NEON_
+    std::string kernelPath = "NEON";
+#else
+    std::string kernelPath = "portable (auto-vectorized)";
+#endif
+    std::cout << termColor("blue") << "Kernels: " << termColor("yellow") << kernelPath << ", "
+              << (sizeof(DSPReal) == sizeof(float) ? "float" : "double") << ", " << channelNum << " channels x "
+              << blockLength << " samples per block" << termColor("nocolor") << std::endl;
+    std::cout << termColor("blue") << std::left << std::setw(30) << "Kernel" << std::right << std::setw(13)
+              << "per block" << std::setw(13) << "per sample" << std::setw(12) << "real time" << termColor("nocolor")
+              << std::endl;
+
+    try {
+        std::vector<double> taps = designBandPassFIR(filterInfo.firTaps, filterInfo.passStartFrequency,
+                                                     filterInfo.passEndFrequency, sampleRate);
+        ChannelSignalVector block = noise;
+
+        FIRFilter direct(taps, channelNum, FIRFilter::FIR_DIRECT);
+        printResult("FIR direct (" + std::to_string(filterInfo.firTaps) + " taps)",
+                    timeKernel([&]() { direct.process(block); }), channelNum, blockLength, sampleRate);
+
+        if (filterInfo.firTaps > 1) {
+            block = noise;
+            FIRFilter fft(taps, channelNum, FIRFilter::FIR_FFT);
+            printResult("FIR FFT (" + std::to_string(filterInfo.firTaps) + " taps)",
+                        timeKernel([&]() { fft.process(block); }), channelNum, blockLength, sampleRate);
+        }
+
+        block = noise;
+        BiquadCascade biquad(designButterworthBandPass(filterInfo.iirOrder, filterInfo.passStartFrequency,
+                                                       filterInfo.passEndFrequency, sampleRate),
+                             channelNum);
+        printResult("Biquad cascade (order " + std::to_string(filterInfo.iirOrder) + ")",
+                    timeKernel([&]() { biquad.process(block); }), channelNum, blockLength, sampleRate);
+
+        int factor = processInfo.decimationFactor;
+        if (factor > 1) {
+            int                 tapNum   = (factor * processInfo.decimationTaps) | 1;
+            std::vector<double> lowPass  = designLowPassFIR(tapNum, 0.5 / factor);
+            ChannelSignalVector decimated;
+            ChannelSignalVector interpolated;
+            PolyphaseDecimator  decimator(lowPass, factor, channelNum);
+            printResult("Polyphase decimator (/" + std::to_string(factor) + ")",
+                        timeKernel([&]() { decimator.process(noise, decimated); }), channelNum, blockLength,
+                        sampleRate);
+
+            ChannelSignalVector   input(channelNum, blockLength / factor);
+            PolyphaseInterpolator interpolator(lowPass, factor, channelNum);
+            printResult("Polyphase interpolator (x" + std::to_string(factor) + ")",
+                        timeKernel([&]() { interpolator.process(input, interpolated); }), channelNum,
+                        input.signalLength * factor, sampleRate);
+
+            BasebandSignal baseband;
+            FrontEnd       frontEnd(systemInfo);
+            printResult("Front-end (/" + std::to_string(factor) + ", complex)",
+                        timeKernel([&]() { frontEnd.decimate(noise, baseband); }), channelNum, blockLength,
+                        sampleRate);
+        }
+    } catch (std::exception &e) {
+        std::cerr << termColor("red") << "Filter kernel benchmark failed: " << e.what() << termColor("nocolor")
+                  << std::endl;
+    }
+    std::cout << termColor("blue")
+              << "---------------------------------------------------------------------------------------------"
+              << termColor("nocolor") << std::endl;
+}
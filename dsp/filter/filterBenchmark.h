@@ -0,0 +1,28 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 21:15:40
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 21:15:40
+ * @FilePath: /Raspi2USBL/dsp/filter/filterBenchmark.h
+ * @Description: Microbenchmark of the filter kernels on the target, run in benchmark mode
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _FILTERBENCHMARK_H_
+#define _FILTERBENCHMARK_H_
+
+#include "../../core/systeminfo.h"
+
+/***
+ * @description: Time every filter kernel (benchmark mode, see runBenchmarks()) on white noise of the configured
+ * channel number, sample rate, pass band and lengths, 0.1 s blocks fed as a stream, and print the time per block, per
+ * sample and channel, and the real-time factor (block duration / processing time): direct FIR, FFT FIR, biquad
+ * cascade, polyphase decimator and interpolator ([SignalProcess] decimationFactor, decimationTaps) and the decimating
+ * front-end. Every kernel runs until 0.2 s have passed (at least 3 blocks) after one warm-up block.
+ * @param {SystemInfo} &systemInfo
+ * @return {*}
+ */
+void benchmarkFilterKernels(SystemInfo &systemInfo);
+
+#endif // _FILTERBENCHMARK_H_
@@ -0,0 +1,149 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:12:48
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:12:48
+ * @FilePath: /Raspi2USBL/dsp/filter/filterDesign.cpp
+ * @Description: See filterDesign.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "filterDesign.h"
+#include <cmath>
+#include <stdexcept>
+
+std::vector<double> designLowPassFIR(int tapNum, double cutoff) {
+    if (tapNum < 1 || cutoff <= 0 || cutoff >= 0.5) {
+        throw std::invalid_argument("designLowPassFIR: invalid tap number or cutoff");
+    }
+    double              center = 0.5 * (tapNum - 1);
+    std::vector<double> taps(tapNum);
+    double              gain = 0;
+    for (int k = 0; k < tapNum; ++k) {
+        double n      = k - center;
+        double sinc   = n == 0 ? 2 * cutoff : std::sin(2 * M_PI * cutoff * n) / (M_PI * n);
+        double window = tapNum == 1 ? 1.0
+                                    : 0.42 - 0.5 * std::cos(2 * M_PI * k / (tapNum - 1)) +
+                                          0.08 * std::cos(4 * M_PI * k / (tapNum - 1));
+        taps[k] = sinc * window;
+        gain += taps[k];
+    }
+    for (double &tap : taps) {
+        tap /= gain;
+    }
+    return taps;
+}
+
+std::vector<double> designBandPassFIR(int tapNum, double startFrequency, double endFrequency, double sampleRate) {
+    if (sampleRate <= 0 || startFrequency <= 0 || endFrequency <= startFrequency || endFrequency >= 0.5 * sampleRate) {
+        throw std::invalid_argument("designBandPassFIR: the band must lie in (0, sampleRate / 2)");
+    }
+    std::vector<double> taps   = designLowPassFIR(tapNum, 0.5 * (endFrequency - startFrequency) / sampleRate);
+    double              w0     = M_PI * (startFrequency + endFrequency) / sampleRate;
+    double              center = 0.5 * (tapNum - 1);
+    for (int k = 0; k < tapNum; ++k) {
+        taps[k] *= 2 * std::cos(w0 * (k - center));
+    }
+    return taps;
+}
+
+std::vector<BiquadCoefficient> designButterworthBandPass(int order, double startFrequency, double endFrequency,
+                                                         double sampleRate) {
+    if (order < 1 || sampleRate <= 0 || startFrequency <= 0 || endFrequency <= startFrequency ||
+        endFrequency >= 0.5 * sampleRate) {
+        throw std::invalid_argument("designButterworthBandPass: invalid order or band");
+    }
+    typedef std::complex<double> Complex;
+
+    // prewarped analog band edges
+    double k      = 2 * sampleRate;
+    double omega1 = k * std::tan(M_PI * startFrequency / sampleRate);
+    double omega2 = k * std::tan(M_PI * endFrequency / sampleRate);
+    double omega0 = std::sqrt(omega1 * omega2);
+    double width  = omega2 - omega1;
+
+    // the low-pass prototype poles in the upper half plane (and the real one of an odd order) are enough, the others
+    // are their conjugates; each one maps to two band-pass poles s = p B / 2 +- sqrt((p B / 2)^2 - w0^2)
+    std::vector<Complex> complexPoles;
+    std::vector<double>  realPoles;
+    for (int i = 0; i < (order + 1) / 2; ++i) {
+        Complex p = std::polar(1.0, M_PI * (2 * i + order + 1) / (2.0 * order));
+        Complex h = 0.5 * width * p;
+        Complex r = std::sqrt(h * h - omega0 * omega0);
+        for (int sign = -1; sign <= 1; sign += 2) {
+            Complex s = h + static_cast<double>(sign) * r;
+            Complex z = (k + s) / (k - s);
+            if (std::abs(z.imag()) > 1e-12 * std::abs(z)) {
+                // the upper pole of each conjugate pair; a real prototype pole gives one conjugate pair only
+                if (z.imag() > 0) {
+                    complexPoles.push_back(z);
+                } else if (2 * i + 1 == order) {
+                    continue;
+                } else {
+                    complexPoles.push_back(std::conj(z));
+                }
+            } else {
+                realPoles.push_back(z.real());
+            }
+        }
+    }
+
+    // zeros: the order zeros at s = 0 map to z = 1, the ones at infinity to z = -1, one of each per section
+    std::vector<BiquadCoefficient> sections;
+    for (const Complex &z : complexPoles) {
+        BiquadCoefficient section;
+        section.b0 = 1;
+        section.b1 = 0;
+        section.b2 = -1;
+        section.a1 = -2 * z.real();
+        section.a2 = std::norm(z);
+        sections.push_back(section);
+    }
+    for (size_t i = 0; i + 1 < realPoles.size(); i += 2) {
+        BiquadCoefficient section;
+        section.b0 = 1;
+        section.b1 = 0;
+        section.b2 = -1;
+        section.a1 = -(realPoles[i] + realPoles[i + 1]);
+        section.a2 = realPoles[i] * realPoles[i + 1];
+        sections.push_back(section);
+    }
+    if (static_cast<int>(sections.size()) != order) {
+        throw std::runtime_error("designButterworthBandPass: unexpected pole layout");
+    }
+
+    // unit gain of every section at the digital image of w0
+    double centerFrequency = sampleRate / M_PI * std::atan(omega0 / k);
+    for (BiquadCoefficient &section : sections) {
+        double gain = std::abs(biquadResponse(std::vector<BiquadCoefficient>(1, section), centerFrequency, sampleRate));
+        section.b0 /= gain;
+        section.b1 /= gain;
+        section.b2 /= gain;
+    }
+    return sections;
+}
+
+std::complex<double> biquadResponse(const std::vector<BiquadCoefficient> &sections, double frequency,
+                                    double sampleRate) {
+    std::complex<double> z1 = std::polar(1.0, -2 * M_PI * frequency / sampleRate);
+    std::complex<double> z2 = z1 * z1;
+    std::complex<double> response(1, 0);
+    for (const BiquadCoefficient &s : sections) {
+        response *= (s.b0 + s.b1 * z1 + s.b2 * z2) / (1.0 + s.a1 * z1 + s.a2 * z2);
+    }
+    return response;
+}
+
+double biquadGroupDelay(const std::vector<BiquadCoefficient> &sections, double frequency, double sampleRate) {
+    // a polynomial c(z^-1) = sum c_k z^-k delays by Re(sum k c_k z^-k / sum c_k z^-k), H = B / A by tau_B - tau_A
+    std::complex<double> z1    = std::polar(1.0, -2 * M_PI * frequency / sampleRate);
+    std::complex<double> z2    = z1 * z1;
+    double               delay = 0;
+    for (const BiquadCoefficient &s : sections) {
+        std::complex<double> b = s.b0 + s.b1 * z1 + s.b2 * z2;
+        std::complex<double> a = 1.0 + s.a1 * z1 + s.a2 * z2;
+        delay += ((s.b1 * z1 + 2.0 * s.b2 * z2) / b).real() - ((s.a1 * z1 + 2.0 * s.a2 * z2) / a).real();
+    }
+    return delay;
+}
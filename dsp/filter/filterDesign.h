@@ -0,0 +1,66 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:12:48
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:12:48
+ * @FilePath: /Raspi2USBL/dsp/filter/filterDesign.h
+ * @Description: Coefficient design of the filter module, windowed sinc FIR and Butterworth biquad cascades
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _FILTERDESIGN_H_
+#define _FILTERDESIGN_H_
+
+#include <complex>
+#include <vector>
+
+// H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+typedef struct BiquadCoefficient {
+    double b0 = 1;
+    double b1 = 0;
+    double b2 = 0;
+    double a1 = 0;
+    double a2 = 0;
+} BiquadCoefficient;
+
+/***
+ * @description: Blackman windowed sinc low-pass, unit gain at DC
+ * @param {int} tapNum          The number of taps (odd for a whole sample group delay)
+ * @param {double} cutoff       The cutoff frequency (unit: cycles per sample, below 0.5)
+ * @return {std::vector<double>} taps, symmetric
+ */
+std::vector<double> designLowPassFIR(int tapNum, double cutoff);
+
+/***
+ * @description: Blackman windowed sinc band-pass, the low-pass of half the band width shifted to the band center,
+ * unit gain at the band center. The group delay is (tapNum - 1) / 2 samples.
+ * @param {int} tapNum
+ * @param {double} startFrequency   The lower band edge (unit: Hz)
+ * @param {double} endFrequency     The upper band edge (unit: Hz)
+ * @param {double} sampleRate       (unit: Hz)
+ * @return {std::vector<double>} taps, symmetric
+ */
+std::vector<double> designBandPassFIR(int tapNum, double startFrequency, double endFrequency, double sampleRate);
+
+/***
+ * @description: Butterworth band-pass of the given order (2 * order poles), bilinear transform with prewarped band
+ * edges, as order biquads. Each section has its zeros at DC and Nyquist and unit gain at the band center, which keeps
+ * the signal level between the sections (and the rounding in float) under control.
+ * @param {int} order               The order of the low-pass prototype, one biquad each
+ * @param {double} startFrequency   The lower -3 dB edge (unit: Hz)
+ * @param {double} endFrequency     The upper -3 dB edge (unit: Hz)
+ * @param {double} sampleRate       (unit: Hz)
+ * @return {std::vector<BiquadCoefficient>} sections
+ */
+std::vector<BiquadCoefficient> designButterworthBandPass(int order, double startFrequency, double endFrequency,
+                                                         double sampleRate);
+
+// frequency response of a biquad cascade at the given frequency
+std::complex<double> biquadResponse(const std::vector<BiquadCoefficient> &sections, double frequency,
+                                    double sampleRate);
+
+// group delay of a biquad cascade at the given frequency (unit: samples)
+double biquadGroupDelay(const std::vector<BiquadCoefficient> &sections, double frequency, double sampleRate);
+
+#endif // _FILTERDESIGN_H_
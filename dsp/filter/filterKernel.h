@@ -0,0 +1,198 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:05:31
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:05:31
+ * @FilePath: /Raspi2USBL/dsp/filter/filterKernel.h
+ * @Description: SIMD kernels shared by the FIR, polyphase and biquad filters (NEON on the Raspberry Pi)
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _FILTERKERNEL_H_
+#define _FILTERKERNEL_H_
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define _FILTER_NEON_
+#endif
+
+/***
+ * @description: acc[m] += sum_k tap[k] * input[k][m] for m < length. Every FIR structure of the filter module is
+ * written in this form: the direct FIR (input[k] = x + k), each branch of the polyphase decimator and interpolator,
+ * and the band-pass taps of the decimating front-end.
+ * The portable version runs four taps per pass over the outputs, so the accumulators are loaded and stored once per
+ * four multiply-adds and the loop over the outputs vectorizes (SSE2 here, NEON with -O3 on aarch64). The NEON
+ * version keeps 16 floats (8 doubles) of accumulators in registers for the whole tap loop and uses fused multiply-adds.
+ * @param {T} *acc              length accumulators
+ * @param {T} **input           tapNum pointers, each to length samples
+ * @param {T} *tap              tapNum taps
+ * @param {int} tapNum
+ * @param {int} length
+ * @return {*}
+ */
+template <typename T>
+inline void multiplyAccumulate(T *acc, const T *const *input, const T *tap, int tapNum, int length) {
+    int k = 0;
+    for (; k + 4 <= tapNum; k += 4) {
+        const T *x0 = input[k];
+        const T *x1 = input[k + 1];
+        const T *x2 = input[k + 2];
+        const T *x3 = input[k + 3];
+        const T  t0 = tap[k], t1 = tap[k + 1], t2 = tap[k + 2], t3 = tap[k + 3];
+        for (int m = 0; m < length; ++m) {
+            acc[m] += t0 * x0[m] + t1 * x1[m] + t2 * x2[m] + t3 * x3[m];
+        }
+    }
+    for (; k < tapNum; ++k) {
+        const T *x0 = input[k];
+        const T  t0 = tap[k];
+        for (int m = 0; m < length; ++m) {
+            acc[m] += t0 * x0[m];
+        }
+    }
+}
+
+#ifdef _FILTER_NEON_
+template <>
+inline void multiplyAccumulate<float>(float *acc, const float *const *input, const float *tap, int tapNum,
+                                      int length) {
+    int m = 0;
+    for (; m + 16 <= length; m += 16) {
+        float32x4_t s0 = vld1q_f32(acc + m);
+        float32x4_t s1 = vld1q_f32(acc + m + 4);
+        float32x4_t s2 = vld1q_f32(acc + m + 8);
+        float32x4_t s3 = vld1q_f32(acc + m + 12);
+        for (int k = 0; k < tapNum; ++k) {
+            const float *x = input[k] + m;
+            float32x4_t  t = vdupq_n_f32(tap[k]);
+            s0             = vfmaq_f32(s0, vld1q_f32(x), t);
+            s1             = vfmaq_f32(s1, vld1q_f32(x + 4), t);
+            s2             = vfmaq_f32(s2, vld1q_f32(x + 8), t);
+            s3             = vfmaq_f32(s3, vld1q_f32(x + 12), t);
+        }
+        vst1q_f32(acc + m, s0);
+        vst1q_f32(acc + m + 4, s1);
+        vst1q_f32(acc + m + 8, s2);
+        vst1q_f32(acc + m + 12, s3);
+    }
+    for (; m < length; ++m) {
+        float sum = acc[m];
+        for (int k = 0; k < tapNum; ++k) {
+            sum += tap[k] * input[k][m];
+        }
+        acc[m] = sum;
+    }
+}
+
+template <>
+inline void multiplyAccumulate<double>(double *acc, const double *const *input, const double *tap, int tapNum,
+                                       int length) {
+    int m = 0;
+    for (; m + 8 <= length; m += 8) {
+        float64x2_t s0 = vld1q_f64(acc + m);
+        float64x2_t s1 = vld1q_f64(acc + m + 2);
+        float64x2_t s2 = vld1q_f64(acc + m + 4);
+        float64x2_t s3 = vld1q_f64(acc + m + 6);
+        for (int k = 0; k < tapNum; ++k) {
+            const double *x = input[k] + m;
+            float64x2_t   t = vdupq_n_f64(tap[k]);
+            s0              = vfmaq_f64(s0, vld1q_f64(x), t);
+            s1              = vfmaq_f64(s1, vld1q_f64(x + 2), t);
+            s2              = vfmaq_f64(s2, vld1q_f64(x + 4), t);
+            s3              = vfmaq_f64(s3, vld1q_f64(x + 6), t);
+        }
+        vst1q_f64(acc + m, s0);
+        vst1q_f64(acc + m + 2, s1);
+        vst1q_f64(acc + m + 4, s2);
+        vst1q_f64(acc + m + 6, s3);
+    }
+    for (; m < length; ++m) {
+        double sum = acc[m];
+        for (int k = 0; k < tapNum; ++k) {
+            sum += tap[k] * input[k][m];
+        }
+        acc[m] = sum;
+    }
+}
+#endif // _FILTER_NEON_
+
+/***
+ * @description: Cascade of biquads (transposed direct form II) over interleaved channels, in place. The recursion
+ * runs along the samples, so the SIMD lanes go across the channels: data[n * stride + c] is sample n of channel c,
+ * stride is a multiple of 4 (the unused lanes carry zeros).
+ *   y = b0 x + z1, z1 = b1 x - a1 y + z2, z2 = b2 x - a2 y
+ * @param {T} *data             length * stride samples
+ * @param {int} length          samples per channel
+ * @param {int} stride          lanes per sample, multiple of 4
+ * @param {T} *coef             b0, b1, b2, a1, a2 of each section
+ * @param {int} sectionNum
+ * @param {T} *state            z1 (stride lanes) then z2 (stride lanes) of each section
+ * @return {*}
+ */
+template <typename T>
+inline void biquadCascade(T *data, int length, int stride, const T *coef, int sectionNum, T *state) {
+    for (int n = 0; n < length; ++n) {
+        T *x = data + static_cast<size_t>(n) * stride;
+        for (int s = 0; s < sectionNum; ++s) {
+            const T *c  = coef + 5 * s;
+            T       *z1 = state + 2 * s * stride;
+            T       *z2 = z1 + stride;
+            for (int lane = 0; lane < stride; ++lane) {
+                T in     = x[lane];
+                T out    = c[0] * in + z1[lane];
+                z1[lane] = c[1] * in - c[3] * out + z2[lane];
+                z2[lane] = c[2] * in - c[4] * out;
+                x[lane]  = out;
+            }
+        }
+    }
+}
+
+#ifdef _FILTER_NEON_
+template <>
+inline void biquadCascade<float>(float *data, int length, int stride, const float *coef, int sectionNum,
+                                 float *state) {
+    for (int n = 0; n < length; ++n) {
+        float *x = data + static_cast<size_t>(n) * stride;
+        for (int s = 0; s < sectionNum; ++s) {
+            const float *c  = coef + 5 * s;
+            float       *z1 = state + 2 * s * stride;
+            float       *z2 = z1 + stride;
+            for (int lane = 0; lane < stride; lane += 4) {
+                float32x4_t in  = vld1q_f32(x + lane);
+                float32x4_t out = vfmaq_n_f32(vld1q_f32(z1 + lane), in, c[0]);
+                float32x4_t w1  = vfmsq_n_f32(vfmaq_n_f32(vld1q_f32(z2 + lane), in, c[1]), out, c[3]);
+                float32x4_t w2  = vfmsq_n_f32(vmulq_n_f32(in, c[2]), out, c[4]);
+                vst1q_f32(z1 + lane, w1);
+                vst1q_f32(z2 + lane, w2);
+                vst1q_f32(x + lane, out);
+            }
+        }
+    }
+}
+
+template <>
+inline void biquadCascade<double>(double *data, int length, int stride, const double *coef, int sectionNum,
+                                  double *state) {
+    for (int n = 0; n < length; ++n) {
+        double *x = data + static_cast<size_t>(n) * stride;
+        for (int s = 0; s < sectionNum; ++s) {
+            const double *c  = coef + 5 * s;
+            double       *z1 = state + 2 * s * stride;
+            double       *z2 = z1 + stride;
+            for (int lane = 0; lane < stride; lane += 2) {
+                float64x2_t in  = vld1q_f64(x + lane);
+                float64x2_t out = vfmaq_n_f64(vld1q_f64(z1 + lane), in, c[0]);
+                float64x2_t w1  = vfmsq_n_f64(vfmaq_n_f64(vld1q_f64(z2 + lane), in, c[1]), out, c[3]);
+                float64x2_t w2  = vfmsq_n_f64(vmulq_n_f64(in, c[2]), out, c[4]);
+                vst1q_f64(z1 + lane, w1);
+                vst1q_f64(z2 + lane, w2);
+                vst1q_f64(x + lane, out);
+            }
+        }
+    }
+}
+#endif // _FILTER_NEON_
+
+#endif // _FILTERKERNEL_H_
@@ -0,0 +1,98 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:21:05
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:21:05
+ * @FilePath: /Raspi2USBL/dsp/filter/firFilter.h
+ * @Description: Streaming multi-channel FIR filter, direct (SIMD) or FFT based (overlap-save)
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _FIRFILTER_H_
+#define _FIRFILTER_H_
+
+#include "../../general/typedef.h"
+#include "../../tool/ThreadPool.h"
+#include "../fftEngine.h"
+#include <memory>
+#include <vector>
+
+/***
+ * @description: FIR filter over all channels of a stream, y[n] = sum_k h[k] x[n - k]. Each call filters the next
+ * block of every channel in place; the last L - 1 input samples of each channel are kept, so consecutive blocks
+ * (stream hops) are filtered as one signal, and reset() starts a new one.
+ * Direct: the output block is a multiply-add of L shifted input rows (multiplyAccumulate, NEON on aarch64), L
+ * multiply-adds per sample. FFT: overlap-save with a fixed FFT length of about 8 L, two channels share one complex FFT
+ * (the taps are real, so the real and imaginary part are filtered independently), about 5 log2(8 L) + 6 flops per
+ * sample. FIR_AUTO takes the cheaper one, the FFT from about 80 taps on in double and 150 in float.
+ * The filter runs in the scalar type T (see DSPReal in general/typedef.h), input and output stay in double.
+ */
+template <typename T>
+class FIRFilterT {
+public:
+    enum FIR_METHOD { FIR_AUTO, FIR_DIRECT, FIR_FFT };
+
+    /***
+     * @description: Create the filter
+     * @param {std::vector<double>} &taps   The taps h[k] (see filterDesign.h)
+     * @param {int} channelNum              The number of channels of the stream
+     * @param {FIR_METHOD} method           Direct, FFT or the cheaper of both
+     * @return {*}
+     */
+    FIRFilterT(const std::vector<double> &taps, int channelNum, FIR_METHOD method = FIR_AUTO);
+    ~FIRFilterT() = default;
+
+    // run the channels on a thread pool (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool) {
+        threadPool_ = threadPool;
+    }
+
+    /***
+     * @description: Filter the next block of every channel in place
+     * @param {ChannelSignalVector} &signal     channelNum channels, any length
+     * @return {*}
+     */
+    void process(ChannelSignalVector &signal);
+
+    // forget the past samples, the next block starts a new stream
+    void reset();
+
+    bool isFFT() const {
+        return isFFT_;
+    }
+
+    int tapNum() const {
+        return tapNum_;
+    }
+
+    // the group delay of a symmetric (linear phase) filter (unit: samples)
+    double groupDelay() const {
+        return 0.5 * (tapNum_ - 1);
+    }
+
+private:
+    void processDirect(int channel, std::vector<T> &buffer, std::vector<double> &output);
+    void processFFT(int pair, std::vector<T> &bufferA, std::vector<T> *bufferB, std::vector<double> &outputA,
+                    std::vector<double> *outputB);
+
+    int                                        tapNum_;
+    int                                        channelNum_;
+    bool                                       isFFT_;
+    std::vector<T>                             tapReversed_; // h[L - 1 - j], meets input row j
+    std::vector<std::vector<T>>                history_;     // last L - 1 input samples of each channel
+    std::vector<std::vector<T>>                buffer_;      // history followed by the block, per channel
+    std::vector<std::vector<T>>                accumulator_; // output rows of the direct form, per channel
+    std::vector<std::vector<const T *>>        rowPointer_;  // input rows of the direct form, per channel
+    std::vector<std::complex<T>>               spectrum_;    // FFT of the zero padded taps
+    std::vector<std::unique_ptr<FFTEngine<T>>> fftEngines_;  // one per channel pair
+    int                                        fftLength_   = 0;
+    int                                        blockLength_ = 0;   // new outputs per FFT
+    static const int                           OUTPUT_BLOCK = 256; // outputs filtered together (direct form)
+
+    ThreadPool *threadPool_ = nullptr;
+};
+
+typedef FIRFilterT<DSPReal> FIRFilter;
+
+#endif // _FIRFILTER_H_
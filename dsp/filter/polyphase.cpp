@@ -0,0 +1,208 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:46:52
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:46:52
+ * @FilePath: /Raspi2USBL/dsp/filter/polyphase.cpp
+ * @Description: See polyphase.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "polyphase.h"
+#include "filterKernel.h"
+#include <algorithm>
+#include <stdexcept>
+
+template <typename T>
+PolyphaseDecimatorT<T>::PolyphaseDecimatorT(const std::vector<double> &taps, int decimation, int channelNum)
+    : tapNum_(static_cast<int>(taps.size()))
+    , decimation_(decimation)
+    , channelNum_(channelNum) {
+    if (tapNum_ < 1 || decimation_ < 1 || channelNum_ < 1) {
+        throw std::invalid_argument("PolyphaseDecimator: empty taps, invalid decimation or no channel");
+    }
+    tapReversed_.resize(tapNum_);
+    for (int j = 0; j < tapNum_; ++j) {
+        tapReversed_[j] = static_cast<T>(taps[tapNum_ - 1 - j]);
+    }
+    history_.resize(channelNum_);
+    phase_.resize(channelNum_);
+    accumulator_.resize(channelNum_);
+    rowPointer_.resize(channelNum_);
+    reset();
+}
+
+template <typename T>
+void PolyphaseDecimatorT<T>::reset() {
+    for (std::vector<T> &history : history_) {
+        history.assign(tapNum_ - 1, T(0));
+    }
+    skip_ = 0;
+}
+
+template <typename T>
+void PolyphaseDecimatorT<T>::process(const ChannelSignalVector &input, ChannelSignalVector &output) {
+    if (!input.isInit || input.channelNum != channelNum_) {
+        throw std::invalid_argument("PolyphaseDecimator::process: input is not initialized or has the wrong channel "
+                                    "number");
+    }
+    int historyLength = tapNum_ - 1;
+    int inputLength   = input.signalLength;
+    int first         = skip_; // first output of this block, counted from its first sample
+    int outputLength  = first < inputLength ? (inputLength - first + decimation_ - 1) / decimation_ : 0;
+    if (output.channelNum != channelNum_ || output.signalLength != outputLength) {
+        output.resize(channelNum_, outputLength);
+    }
+    output.isInit = true;
+    skip_         = first + outputLength * decimation_ - inputLength;
+    if (inputLength == 0) {
+        return;
+    }
+
+    auto decimateChannels = [&](int chBegin, int chEnd) {
+        for (int ch = chBegin; ch < chEnd; ++ch) {
+            // buffer b = history followed by the block; phase p holds b[q D + p]
+            std::vector<T>                &history     = history_[ch];
+            const std::vector<double>     &x           = input.channels[ch];
+            std::vector<std::vector<T>>   &phase       = phase_[ch];
+            int                            totalLength = historyLength + inputLength;
+            phase.resize(decimation_);
+            for (int p = 0; p < decimation_; ++p) {
+                phase[p].resize(p < totalLength ? (totalLength - p + decimation_ - 1) / decimation_ : 0);
+                for (int q = 0, i = p; i < totalLength; ++q, i += decimation_) {
+                    phase[p][q] = i < historyLength ? history[i] : static_cast<T>(x[i - historyLength]);
+                }
+            }
+            // the new history is the tail of b
+            if (inputLength >= historyLength) {
+                for (int i = 0; i < historyLength; ++i) {
+                    history[i] = static_cast<T>(x[inputLength - historyLength + i]);
+                }
+            } else if (historyLength > 0) {
+                std::copy(history.begin() + inputLength, history.end(), history.begin());
+                for (int i = 0; i < inputLength; ++i) {
+                    history[historyLength - inputLength + i] = static_cast<T>(x[i]);
+                }
+            }
+
+            // output m at b[first + m D + j] for row j, that is phase (first + j) mod D at m + (first + j) / D
+            std::vector<T>         &acc  = accumulator_[ch];
+            std::vector<const T *> &rows = rowPointer_[ch];
+            std::vector<double>    &y    = output.channels[ch];
+            acc.resize(std::min(static_cast<int>(OUTPUT_BLOCK), outputLength));
+            rows.resize(tapNum_);
+            for (int block = 0; block < outputLength; block += OUTPUT_BLOCK) {
+                int blockLength = std::min(static_cast<int>(OUTPUT_BLOCK), outputLength - block);
+                for (int j = 0; j < tapNum_; ++j) {
+                    int offset = first + j;
+                    rows[j]    = phase[offset % decimation_].data() + offset / decimation_ + block;
+                }
+                std::fill(acc.begin(), acc.begin() + blockLength, T(0));
+                multiplyAccumulate(acc.data(), rows.data(), tapReversed_.data(), tapNum_, blockLength);
+                for (int m = 0; m < blockLength; ++m) {
+                    y[block + m] = acc[m];
+                }
+            }
+        }
+    };
+
+    if (threadPool_ != nullptr) {
+        threadPool_->parallelFor(0, channelNum_, 1, decimateChannels);
+    } else {
+        decimateChannels(0, channelNum_);
+    }
+}
+
+template <typename T>
+PolyphaseInterpolatorT<T>::PolyphaseInterpolatorT(const std::vector<double> &taps, int interpolation, int channelNum)
+    : interpolation_(interpolation)
+    , channelNum_(channelNum) {
+    int tapNum = static_cast<int>(taps.size());
+    if (tapNum < 1 || interpolation_ < 1 || channelNum_ < 1) {
+        throw std::invalid_argument("PolyphaseInterpolator: empty taps, invalid interpolation or no channel");
+    }
+    branchLength_ = (tapNum + interpolation_ - 1) / interpolation_;
+    branchReversed_.assign(interpolation_, std::vector<T>(branchLength_, T(0)));
+    for (int p = 0; p < interpolation_; ++p) {
+        for (int i = 0; i < branchLength_; ++i) {
+            int k = (branchLength_ - 1 - i) * interpolation_ + p;
+            if (k < tapNum) {
+                branchReversed_[p][i] = static_cast<T>(interpolation_ * taps[k]);
+            }
+        }
+    }
+    history_.resize(channelNum_);
+    buffer_.resize(channelNum_);
+    accumulator_.resize(channelNum_);
+    rowPointer_.resize(channelNum_);
+    reset();
+}
+
+template <typename T>
+void PolyphaseInterpolatorT<T>::reset() {
+    for (std::vector<T> &history : history_) {
+        history.assign(branchLength_ - 1, T(0));
+    }
+}
+
+template <typename T>
+void PolyphaseInterpolatorT<T>::process(const ChannelSignalVector &input, ChannelSignalVector &output) {
+    if (!input.isInit || input.channelNum != channelNum_) {
+        throw std::invalid_argument("PolyphaseInterpolator::process: input is not initialized or has the wrong "
+                                    "channel number");
+    }
+    int historyLength = branchLength_ - 1;
+    int inputLength   = input.signalLength;
+    int outputLength  = inputLength * interpolation_;
+    if (output.channelNum != channelNum_ || output.signalLength != outputLength) {
+        output.resize(channelNum_, outputLength);
+    }
+    output.isInit = true;
+    if (inputLength == 0) {
+        return;
+    }
+
+    auto interpolateChannels = [&](int chBegin, int chEnd) {
+        for (int ch = chBegin; ch < chEnd; ++ch) {
+            std::vector<T>            &buffer = buffer_[ch];
+            const std::vector<double> &x      = input.channels[ch];
+            buffer.resize(historyLength + inputLength);
+            std::copy(history_[ch].begin(), history_[ch].end(), buffer.begin());
+            for (int n = 0; n < inputLength; ++n) {
+                buffer[historyLength + n] = static_cast<T>(x[n]);
+            }
+            std::copy(buffer.end() - historyLength, buffer.end(), history_[ch].begin());
+
+            // branch p of input n is sum_i g_p[i] buffer[n + i], every branch reads the same rows buffer + i
+            std::vector<T>         &acc  = accumulator_[ch];
+            std::vector<const T *> &rows = rowPointer_[ch];
+            std::vector<double>    &y    = output.channels[ch];
+            acc.resize(std::min(static_cast<int>(OUTPUT_BLOCK), inputLength));
+            rows.resize(branchLength_);
+            for (int block = 0; block < inputLength; block += OUTPUT_BLOCK) {
+                int blockLength = std::min(static_cast<int>(OUTPUT_BLOCK), inputLength - block);
+                for (int i = 0; i < branchLength_; ++i) {
+                    rows[i] = buffer.data() + block + i;
+                }
+                for (int p = 0; p < interpolation_; ++p) {
+                    std::fill(acc.begin(), acc.begin() + blockLength, T(0));
+                    multiplyAccumulate(acc.data(), rows.data(), branchReversed_[p].data(), branchLength_, blockLength);
+                    for (int n = 0; n < blockLength; ++n) {
+                        y[static_cast<size_t>(block + n) * interpolation_ + p] = acc[n];
+                    }
+                }
+            }
+        }
+    };
+
+    if (threadPool_ != nullptr) {
+        threadPool_->parallelFor(0, channelNum_, 1, interpolateChannels);
+    } else {
+        interpolateChannels(0, channelNum_);
+    }
+}
+
+// only the configured precision is instantiated
+template class PolyphaseDecimatorT<DSPReal>;
+template class PolyphaseInterpolatorT<DSPReal>;
@@ -0,0 +1,135 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 20:46:52
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 20:46:52
+ * @FilePath: /Raspi2USBL/dsp/filter/polyphase.h
+ * @Description: Streaming multi-channel polyphase decimator and interpolator
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _POLYPHASE_H_
+#define _POLYPHASE_H_
+
+#include "../../general/typedef.h"
+#include "../../tool/ThreadPool.h"
+#include <vector>
+
+/***
+ * @description: Filter by h and keep every D-th sample, y[m] = sum_k h[k] x[m D - k], over all channels of a stream.
+ * Outputs are taken at the input samples whose index from the start of the stream is a multiple of D, so blocks of any
+ * length can be fed in: the last L - 1 input samples and the position in the decimation cycle are kept, and reset()
+ * starts a new stream.
+ * The block is split into its D phases (phase p holds the samples q D + p), tap k only meets phase (o + k) mod D, so
+ * the multiply-adds of the skipped outputs are never done: L / D per input sample, as multiply-adds over whole output
+ * rows (multiplyAccumulate, NEON on aarch64). The anti-aliasing taps come from designLowPassFIR() with a cutoff below
+ * 0.5 / D; the group delay is (L - 1) / 2 input samples.
+ */
+template <typename T>
+class PolyphaseDecimatorT {
+public:
+    /***
+     * @description: Create the decimator
+     * @param {std::vector<double>} &taps   The anti-aliasing taps h[k]
+     * @param {int} decimation              D
+     * @param {int} channelNum              The number of channels of the stream
+     * @return {*}
+     */
+    PolyphaseDecimatorT(const std::vector<double> &taps, int decimation, int channelNum);
+    ~PolyphaseDecimatorT() = default;
+
+    // run the channels on a thread pool (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool) {
+        threadPool_ = threadPool;
+    }
+
+    /***
+     * @description: Decimate the next block of every channel
+     * @param {ChannelSignalVector} &input      channelNum channels, any length
+     * @param {ChannelSignalVector} &output     The outputs that fall into this block, about length / D per channel
+     * @return {*}
+     */
+    void process(const ChannelSignalVector &input, ChannelSignalVector &output);
+
+    // forget the past samples, the next block starts a new stream
+    void reset();
+
+    int decimation() const {
+        return decimation_;
+    }
+
+private:
+    int                                      tapNum_;
+    int                                      decimation_;
+    int                                      channelNum_;
+    int                                      skip_; // input samples of the next block before its first output
+    std::vector<T>                           tapReversed_;
+    std::vector<std::vector<T>>              history_;
+    std::vector<std::vector<std::vector<T>>> phase_;       // D phases of history + block, per channel
+    std::vector<std::vector<T>>              accumulator_; // per channel
+    std::vector<std::vector<const T *>>      rowPointer_;  // per channel
+    static const int                         OUTPUT_BLOCK = 256; // outputs filtered together
+
+    ThreadPool *threadPool_ = nullptr;
+};
+
+/***
+ * @description: Insert U - 1 zeros after every sample and filter by U h, over all channels of a stream. In the
+ * polyphase form output n U + p is branch p, sum_j h[j U + p] x[n - j], so no multiply-add ever meets an inserted
+ * zero: L / U per output sample. All branches read the same input rows (multiplyAccumulate, NEON on aarch64). The last
+ * ceil(L / U) - 1 input samples are kept between the calls, and reset() starts a new stream.
+ * The interpolation taps come from designLowPassFIR() with a cutoff below 0.5 / U; the group delay is (L - 1) / 2
+ * output samples.
+ */
+template <typename T>
+class PolyphaseInterpolatorT {
+public:
+    /***
+     * @description: Create the interpolator
+     * @param {std::vector<double>} &taps   The interpolation taps h[k] (unit DC gain, U is applied here)
+     * @param {int} interpolation           U
+     * @param {int} channelNum              The number of channels of the stream
+     * @return {*}
+     */
+    PolyphaseInterpolatorT(const std::vector<double> &taps, int interpolation, int channelNum);
+    ~PolyphaseInterpolatorT() = default;
+
+    // run the channels on a thread pool (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool) {
+        threadPool_ = threadPool;
+    }
+
+    /***
+     * @description: Interpolate the next block of every channel
+     * @param {ChannelSignalVector} &input      channelNum channels, any length
+     * @param {ChannelSignalVector} &output     length * U samples per channel
+     * @return {*}
+     */
+    void process(const ChannelSignalVector &input, ChannelSignalVector &output);
+
+    // forget the past samples, the next block starts a new stream
+    void reset();
+
+    int interpolation() const {
+        return interpolation_;
+    }
+
+private:
+    int                                 branchLength_; // K = ceil(L / U)
+    int                                 interpolation_;
+    int                                 channelNum_;
+    std::vector<std::vector<T>>         branchReversed_; // branch p: U h[(K - 1 - i) U + p], meets input row i
+    std::vector<std::vector<T>>         history_;
+    std::vector<std::vector<T>>         buffer_;      // history + block, per channel
+    std::vector<std::vector<T>>         accumulator_; // one output row per branch, per channel
+    std::vector<std::vector<const T *>> rowPointer_;  // per channel
+    static const int                    OUTPUT_BLOCK = 256; // input samples filtered together
+
+    ThreadPool *threadPool_ = nullptr;
+};
+
+typedef PolyphaseDecimatorT<DSPReal>    PolyphaseDecimator;
+typedef PolyphaseInterpolatorT<DSPReal> PolyphaseInterpolator;
+
+#endif // _POLYPHASE_H_
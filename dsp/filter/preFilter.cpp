@@ -0,0 +1,101 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 21:02:19
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 21:02:19
+ * @FilePath: /Raspi2USBL/dsp/filter/preFilter.cpp
+ * @Description: See preFilter.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "preFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+PreFilter::PreFilter(SystemInfo &systeminfo)
+    : SignalBase(systeminfo)
+    , filterType_(systeminfo.preFilterInfo.filterType) {
+    const PreFilterInfo &info       = systeminfo.preFilterInfo;
+    double               sampleRate = systeminfo.signalInfo.sampleRate;
+    double               center     = 0.5 * (info.passStartFrequency + info.passEndFrequency);
+    if (filterType_ == FILTER_FIR) {
+        taps_       = designBandPassFIR(info.firTaps, info.passStartFrequency, info.passEndFrequency, sampleRate);
+        groupDelay_ = 0.5 * (info.firTaps - 1);
+        tailLength_ = info.firTaps - 1;
+    } else if (filterType_ == FILTER_IIR) {
+        sections_   = designButterworthBandPass(info.iirOrder, info.passStartFrequency, info.passEndFrequency,
+                                                sampleRate);
+        groupDelay_ = biquadGroupDelay(sections_, center, sampleRate);
+        // the slowest pole sets the decay, |z|^n < 1e-4
+        double radius = 0;
+        for (const BiquadCoefficient &s : sections_) {
+            double discriminant = s.a1 * s.a1 - 4 * s.a2;
+            if (discriminant < 0) {
+                radius = std::max(radius, std::sqrt(s.a2));
+            } else {
+                radius = std::max(radius, 0.5 * (std::abs(s.a1) + std::sqrt(discriminant)));
+            }
+        }
+        if (radius >= 1) {
+            throw std::runtime_error("PreFilter: unstable IIR design");
+        }
+        tailLength_ = static_cast<int>(std::ceil(std::log(1e-4) / std::log(std::max(radius, 1e-3))));
+    } else {
+        throw std::invalid_argument("PreFilter: unknown filter type");
+    }
+}
+
+void PreFilter::setThreadPool(ThreadPool *threadPool) {
+    threadPool_ = threadPool;
+    if (firFilter_ != nullptr) {
+        firFilter_->setThreadPool(threadPool);
+    }
+}
+
+void PreFilter::process(ChannelSignalVector &signal) {
+    if (!signal.isInit) {
+        throw std::runtime_error("PreFilter::process: signal is not initialized");
+    }
+    if (signal.channelNum != channelNum_) {
+        channelNum_ = signal.channelNum;
+        if (filterType_ == FILTER_FIR) {
+            firFilter_.reset(new FIRFilter(taps_, channelNum_));
+            firFilter_->setThreadPool(threadPool_);
+        } else {
+            iirFilter_.reset(new BiquadCascade(sections_, channelNum_));
+        }
+    }
+    if (filterType_ == FILTER_FIR) {
+        firFilter_->process(signal);
+    } else {
+        iirFilter_->process(signal);
+    }
+}
+
+void PreFilter::reset() {
+    if (firFilter_ != nullptr) {
+        firFilter_->reset();
+    }
+    if (iirFilter_ != nullptr) {
+        iirFilter_->reset();
+    }
+}
+
+void PreFilter::filterReference(ChannelSignalVector &reference) const {
+    if (!reference.isInit || reference.signalLength == 0) {
+        throw std::runtime_error("PreFilter::filterReference: reference is not initialized");
+    }
+    for (std::vector<double> &channel : reference.channels) {
+        channel.resize(reference.signalLength + tailLength_, 0.0);
+    }
+    reference.signalLength += tailLength_;
+    if (filterType_ == FILTER_FIR) {
+        FIRFilter filter(taps_, reference.channelNum);
+        filter.process(reference);
+    } else {
+        BiquadCascade filter(sections_, reference.channelNum);
+        filter.process(reference);
+    }
+}
@@ -0,0 +1,81 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 21:02:19
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 21:02:19
+ * @FilePath: /Raspi2USBL/dsp/filter/preFilter.h
+ * @Description: Band-pass pre-filter of the hydrophone channels in front of TOF, designed from the config
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _PREFILTER_H_
+#define _PREFILTER_H_
+
+#include "../../tool/ThreadPool.h"
+#include "../signalBase.h"
+#include "biquadCascade.h"
+#include "firFilter.h"
+#include <memory>
+
+/***
+ * @description: Band-pass pre-filter ([PreFilter] in the config), removes the out-of-band noise (thrusters, flow)
+ * before the matched filter. FILTER_FIR is a linear phase windowed sinc of firTaps taps (direct or FFT, see FIRFilter),
+ * FILTER_IIR a Butterworth band-pass of iirOrder biquads (see BiquadCascade), both over [passStartFrequency,
+ * passEndFrequency].
+ * The reference goes through the same filter (filterReference()), so the correlation of the filtered signal with the
+ * filtered reference peaks at the same lag as without the filter: the TOF needs no correction for the filter delay,
+ * whatever its phase response. The DOA window is moved by groupDelay() instead.
+ */
+class PreFilter : public SignalBase {
+public:
+    PreFilter(SystemInfo &systeminfo);
+    ~PreFilter() = default;
+
+    // run the channels on a thread pool (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool);
+
+    /***
+     * @description: Filter the next block of every channel in place. The filter state is kept between the calls, so
+     * the hops of a stream are filtered as one signal.
+     * @param {ChannelSignalVector} &signal
+     * @return {*}
+     */
+    void process(ChannelSignalVector &signal);
+
+    // forget the past samples, the next block starts a new stream (e.g. one triggered ping)
+    void reset();
+
+    /***
+     * @description: Filter the reference with a fresh state, appended with tailLength() zeros first so the decaying
+     * response of the filter is kept
+     * @param {ChannelSignalVector} &reference
+     * @return {*}
+     */
+    void filterReference(ChannelSignalVector &reference) const;
+
+    // the group delay at the pass band center (unit: samples)
+    double groupDelay() const {
+        return groupDelay_;
+    }
+
+    // samples until the impulse response has decayed (below -80 dB for the IIR)
+    int tailLength() const {
+        return tailLength_;
+    }
+
+private:
+    FILTER_TYPE                    filterType_;
+    std::vector<double>            taps_;
+    std::vector<BiquadCoefficient> sections_;
+    double                         groupDelay_;
+    int                            tailLength_;
+
+    // created for the channel number of the first block
+    int                            channelNum_ = 0;
+    std::unique_ptr<FIRFilter>     firFilter_;
+    std::unique_ptr<BiquadCascade> iirFilter_;
+    ThreadPool                    *threadPool_ = nullptr;
+};
+
+#endif // _PREFILTER_H_
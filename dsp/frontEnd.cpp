@@ -0,0 +1,122 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 18:40:12
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 18:40:12
+ * @FilePath: /Raspi2USBL/dsp/frontEnd.cpp
+ * @Description: See frontEnd.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "frontEnd.h"
+#include "filter/filterDesign.h"
+#include "filter/filterKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+template <typename T>
+FrontEndT<T>::FrontEndT(SystemInfo &systeminfo)
+    : SignalBase(systeminfo)
+    , decimation_(systeminfo.signalProcessInfo.decimationFactor)
+    , inputRate_(systeminfo.signalInfo.sampleRate)
+    , centerFrequency_(0.5 *
+                       (systeminfo.signalProcessInfo.startFrequency + systeminfo.signalProcessInfo.endFrequency)) {
+    if (decimation_ < 1 || systeminfo.signalProcessInfo.decimationTaps < 1 || inputRate_ <= 0) {
+        throw std::invalid_argument("FrontEnd: invalid decimation factor, taps or sample rate");
+    }
+    // odd length, so the group delay is a whole number of samples
+    tapNum_     = (decimation_ * systeminfo.signalProcessInfo.decimationTaps) | 1;
+    halfLength_ = (tapNum_ - 1) / 2;
+    designFilter();
+}
+
+template <typename T>
+void FrontEndT<T>::designFilter() {
+    // cutoff at half the baseband rate, unit gain at DC
+    std::vector<double> lowPass = designLowPassFIR(tapNum_, 0.5 / decimation_);
+
+    // shift to the band center, times 2 for the analytic amplitude; h is symmetric, so the taps in input order are
+    // 2 h[i] exp(-j w0 (i - c))
+    double w0 = 2 * M_PI * centerFrequency_ / inputRate_;
+    tapReal_.resize(tapNum_);
+    tapImag_.resize(tapNum_);
+    for (int i = 0; i < tapNum_; ++i) {
+        double tap  = 2 * lowPass[i];
+        tapReal_[i] = static_cast<T>(tap * std::cos(w0 * (i - halfLength_)));
+        tapImag_[i] = static_cast<T>(-tap * std::sin(w0 * (i - halfLength_)));
+    }
+}
+
+template <typename T>
+const T *FrontEndT<T>::phaseInput(const ChannelWorkspace &workspace, int tap, int output) const {
+    return workspace.phase[tap % decimation_].data() + tap / decimation_ + output;
+}
+
+template <typename T>
+void FrontEndT<T>::decimate(const ChannelSignalVector &signal, BasebandSignal &baseband) {
+    if (!signal.isInit || signal.signalLength == 0) {
+        throw std::runtime_error("FrontEnd::decimate: signal is not initialized");
+    }
+    int outputLength = (signal.signalLength + decimation_ - 1) / decimation_;
+    if (baseband.channelNum != signal.channelNum || baseband.signalLength != outputLength) {
+        baseband.resize(signal.channelNum, outputLength);
+    }
+    baseband.isInit          = true;
+    baseband.decimation      = decimation_;
+    baseband.sampleRate      = basebandRate();
+    baseband.centerFrequency = centerFrequency_;
+    if (static_cast<int>(workspace_.size()) != signal.channelNum) {
+        workspace_.resize(signal.channelNum);
+    }
+
+    double w0          = 2 * M_PI * centerFrequency_ / inputRate_;
+    int    phaseLength = outputLength + (tapNum_ - 1) / decimation_ + 1;
+
+    // channels are independent, each one writes its own baseband row
+    auto decimateChannels = [&](int chBegin, int chEnd) {
+        for (int ch = chBegin; ch < chEnd; ++ch) {
+            ChannelWorkspace          &w = workspace_[ch];
+            const std::vector<double> &x = signal.channels[ch];
+            w.phase.resize(decimation_);
+            for (int p = 0; p < decimation_; ++p) {
+                std::vector<T> &phase = w.phase[p];
+                phase.resize(phaseLength);
+                for (int q = 0; q < phaseLength; ++q) {
+                    int n    = q * decimation_ + p - halfLength_;
+                    phase[q] = n >= 0 && n < signal.signalLength ? static_cast<T>(x[n]) : T(0);
+                }
+            }
+
+            // output m takes tap k from phase k mod D at m + k / D, in blocks of outputs that stay in the L1 cache
+            w.real.assign(outputLength, T(0));
+            w.imag.assign(outputLength, T(0));
+            w.row.resize(tapNum_);
+            for (int block = 0; block < outputLength; block += OUTPUT_BLOCK) {
+                int blockLength = std::min(static_cast<int>(OUTPUT_BLOCK), outputLength - block);
+                T  *re          = w.real.data() + block;
+                T  *im          = w.imag.data() + block;
+                for (int k = 0; k < tapNum_; ++k) {
+                    w.row[k] = phaseInput(w, k, block);
+                }
+                multiplyAccumulate(re, w.row.data(), tapReal_.data(), tapNum_, blockLength);
+                multiplyAccumulate(im, w.row.data(), tapImag_.data(), tapNum_, blockLength);
+            }
+
+            std::vector<std::complex<double>> &y = baseband.channels[ch];
+            for (int m = 0; m < outputLength; ++m) {
+                y[m] = std::complex<double>(w.real[m], w.imag[m]) * std::polar(1.0, -w0 * decimation_ * m);
+            }
+        }
+    };
+
+    if (threadPool_ != nullptr) {
+        threadPool_->parallelFor(0, signal.channelNum, 1, decimateChannels);
+    } else {
+        decimateChannels(0, signal.channelNum);
+    }
+}
+
+// only the configured precision is instantiated
+template class FrontEndT<DSPReal>;
@@ -0,0 +1,93 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 18:40:12
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 18:40:12
+ * @FilePath: /Raspi2USBL/dsp/frontEnd.h
+ * @Description: Decimating front-end, mixes the received signal down to complex baseband at the band center
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _FRONTEND_H_
+#define _FRONTEND_H_
+
+#include "../tool/ThreadPool.h"
+#include "signalBase.h"
+
+/***
+ * @description: Decimating front-end ([SignalProcess] enableDecimation in the config). Each channel is mixed down by
+ * the band center fc = (startFrequency + endFrequency) / 2, low-pass filtered and decimated by D, the matched filter
+ * and the beamformer then run on the complex baseband at sampleRate / D.
+ * The mixer is folded into the filter: y[m] = exp(-j w0 m D) sum_k h[k] exp(j w0 (k - c)) x[m D + c - k], so the
+ * band-pass taps run directly on the real input. In the polyphase form the input is split into its D phases and tap k
+ * only meets phase k mod D, so only every D-th output is computed: 2 L / D multiply-adds per input sample for the
+ * L = D * decimationTaps (+ 1, odd) taps, as multiply-adds over whole output rows (multiplyAccumulate, NEON on
+ * aarch64).
+ * h is a Blackman windowed sinc with its cutoff at half the baseband rate. c = (L - 1) / 2 compensates the group delay,
+ * baseband sample m is input sample m D. The output is scaled by 2, so a tone of amplitude A has |y| = A (the analytic
+ * signal shifted by fc). The band is flat and protected from aliasing while (endFrequency - startFrequency) / 2 stays
+ * below (0.5 - 2.75 / decimationTaps) times the baseband rate.
+ * The filter runs in the scalar type T (see DSPReal in general/typedef.h), input and output stay in double.
+ */
+template <typename T>
+class FrontEndT : public SignalBase {
+public:
+    FrontEndT(SystemInfo &systeminfo);
+    ~FrontEndT() = default;
+
+    // run the channels on a thread pool (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool) {
+        threadPool_ = threadPool;
+    }
+
+    /***
+     * @description: Mix down, filter and decimate every channel
+     * @param {ChannelSignalVector} &signal     The real input at sampleRate
+     * @param {BasebandSignal} &baseband        ceil(signalLength / D) complex samples per channel
+     * @return {*}
+     */
+    void decimate(const ChannelSignalVector &signal, BasebandSignal &baseband);
+
+    int decimation() const {
+        return decimation_;
+    }
+
+    double basebandRate() const {
+        return inputRate_ / decimation_;
+    }
+
+    double centerFrequency() const {
+        return centerFrequency_;
+    }
+
+private:
+    void designFilter();
+
+    int                         decimation_;
+    int                         tapNum_;
+    int                         halfLength_; // c, the group delay of the filter
+    double                      inputRate_;
+    double                      centerFrequency_;
+    std::vector<T>              tapReal_; // band-pass taps in the order they meet the input, real part
+    std::vector<T>              tapImag_; // imaginary part
+
+    // per channel buffers, reused between pings
+    typedef struct ChannelWorkspace {
+        std::vector<std::vector<T>> phase; // phase p holds input samples q D + p - c, zero outside the signal
+        std::vector<T>              real;  // output row before the mixer phase, real part
+        std::vector<T>              imag;  // imaginary part
+        std::vector<const T *>      row;   // input row met by each tap, for the current output block
+    } ChannelWorkspace;
+    std::vector<ChannelWorkspace> workspace_;
+    static const int              OUTPUT_BLOCK = 256; // outputs filtered together
+
+    // input sample met by the given tap at the given output
+    const T *phaseInput(const ChannelWorkspace &workspace, int tap, int output) const;
+
+    ThreadPool *threadPool_ = nullptr;
+};
+
+typedef FrontEndT<DSPReal> FrontEnd;
+
+#endif // _FRONTEND_H_
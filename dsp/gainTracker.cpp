@@ -0,0 +1,75 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 18:02:16
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 18:02:16
+ * @FilePath: /Raspi2USBL/dsp/gainTracker.cpp
+ * @Description: See gainTracker.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "gainTracker.h"
+#include <cmath>
+
+GainTracker::GainTracker(const AgcInfo &agcInfo)
+    : gainSlope_(agcInfo.gainSlope)
+    , gainOffset_(agcInfo.gainOffset) {
+}
+
+void GainTracker::beginCommand(Clock::time_point sendTime) {
+    Change change;
+    change.sendTime = sendTime;
+    change.endTime  = Clock::time_point::max();
+    change.isKnown  = false;
+    change.gain     = 0.0;
+    change.seq      = 0;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (history_.size() >= HISTORY_LENGTH) {
+        history_.pop_front();
+    }
+    history_.push_back(change);
+}
+
+void GainTracker::confirm(double gain, uint64_t seq, Clock::time_point confirmTime) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (history_.empty() || history_.back().endTime != Clock::time_point::max()) {
+        return; // no command on its way
+    }
+    Change &change = history_.back();
+    change.endTime = confirmTime;
+    change.isKnown = true;
+    change.gain    = gain;
+    change.seq     = seq;
+}
+
+void GainTracker::invalidate(Clock::time_point failTime) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (history_.empty() || history_.back().endTime != Clock::time_point::max()) {
+        return;
+    }
+    history_.back().endTime = failTime;
+}
+
+GainTag GainTracker::tagAt(Clock::time_point start, Clock::time_point end) const {
+    GainTag                     tag;
+    bool                        isChanging = false;
+    std::lock_guard<std::mutex> lock(mtx_);
+    // newest first: the commands overlapping the ping, then the last one that ended before it
+    for (auto it = history_.rbegin(); it != history_.rend(); ++it) {
+        if (it->endTime > start) {
+            isChanging = isChanging || it->sendTime <= end;
+            continue;
+        }
+        if (it->isKnown) {
+            tag.state  = isChanging ? GAIN_CHANGING : GAIN_SETTLED;
+            tag.gain   = it->gain;
+            tag.gainDb = gainDb(it->gain);
+            tag.scale  = std::pow(10.0, -tag.gainDb / 20.0);
+            tag.seq    = it->seq;
+        }
+        break;
+    }
+    return tag;
+}
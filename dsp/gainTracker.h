@@ -0,0 +1,76 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-19 18:02:16
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-19 18:02:16
+ * @FilePath: /Raspi2USBL/dsp/gainTracker.h
+ * @Description: History of the receive gains the DAC confirmed, to tag every ping with the gain it was acquired with
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _GAINTRACKER_H_
+#define _GAINTRACKER_H_
+
+#include "../core/systeminfo.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+/***
+ * @description: The AGC thread records every DAC command it sends: the gain becomes known once the DAC echoes it,
+ * and unknown again after a command fails. The DSP pipeline asks for the gain of each ping by its acquisition time:
+ * the gain confirmed before the ping started, GAIN_CHANGING when a command was on its way (from its first write to
+ * the echo) while the ping was acquired. The amplifier gain of a voltage is gainSlope * voltage + gainOffset dB.
+ * The last HISTORY_LENGTH commands are kept, a ping older than all of them gets GAIN_UNKNOWN.
+ */
+class GainTracker {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit GainTracker(const AgcInfo &agcInfo);
+
+    // a command is written to the DAC (first attempt), the gain may change from now on; called by the AGC thread
+    void beginCommand(Clock::time_point sendTime);
+    /***
+     * @description: The command is echoed by the DAC, the gain holds from confirmTime on
+     * @param {double} gain             Gain voltage the DAC is set to
+     * @param {uint64_t} seq            Ping the gain was derived from
+     * @param {time_point} confirmTime
+     * @return {*}
+     */
+    void confirm(double gain, uint64_t seq, Clock::time_point confirmTime);
+    // the command is not confirmed, the DAC may hold any value until the next confirmed command
+    void invalidate(Clock::time_point failTime);
+
+    /***
+     * @description: Gain in effect while a ping was acquired
+     * @param {time_point} start    First sample of the ping
+     * @param {time_point} end      Last sample of the ping
+     * @return {GainTag}
+     */
+    GainTag tagAt(Clock::time_point start, Clock::time_point end) const;
+
+    // amplifier gain (dB) at a gain voltage
+    double gainDb(double gain) const { return gainSlope_ * gain + gainOffset_; }
+
+    static const size_t HISTORY_LENGTH = 64;
+
+private:
+    // one DAC command
+    struct Change {
+        Clock::time_point sendTime;
+        Clock::time_point endTime; // echo or failure, time_point::max() while the command is on its way
+        bool              isKnown; // echoed
+        double            gain;
+        uint64_t          seq;
+    };
+
+    double gainSlope_;
+    double gainOffset_;
+
+    mutable std::mutex mtx_;
+    std::deque<Change> history_; // oldest first
+};
+
+#endif // _GAINTRACKER_H_
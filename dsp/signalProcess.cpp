@@ -9,16 +9,26 @@ SignalProcess::SignalProcess(SystemInfo &systemInfo, ChannelSignalVector &refSig
 }
 
 void SignalProcess::init() {
+    // the reference goes through the same band-pass as the received signal, so the correlation peak does not move
+    if (systemInfo_.preFilterInfo.isEnable) {
+        preFilter_.reset(new PreFilter(systemInfo_));
+        preFilter_->filterReference(refSignal_);
+    }
+
     tofProcess_          = new TOF(systemInfo_, refSignal_);
     doaProcess_          = new DOA(systemInfo_, refSignal_);
 
-    maxPower_            = systemInfo_.agcInfo.maxPower;
-    minPower_            = systemInfo_.agcInfo.minPower;
+    // the reference goes through the same front-end as the received signal
+    if (systemInfo_.signalProcessInfo.isDecimationEnable) {
+        frontEnd_.reset(new FrontEnd(systemInfo_));
+        frontEnd_->decimate(refSignal_, refBaseband_);
+        tofProcess_->setBasebandReference(refBaseband_);
+    }
+
+    agcController_       = createAgcController(systemInfo_);
     receiveGain_         = systemInfo_.agcInfo.initGainValue;
-    agcStep_             = systemInfo_.agcInfo.gainStep;
 
     processSignalLength_ = systemInfo_.signalProcessInfo.processDuration * systemInfo_.aiScanInfo.rate;
-    beamPattern_.resize(systemInfo_.arrayInfo.arrayNum, (int) processSignalLength_);
     tofRes_.resize(systemInfo_.arrayInfo.arrayNum);
 
     tofOutput_ = 0.0;
@@ -37,12 +47,78 @@ void SignalProcess::updateInputSignal(const ChannelSignalVector &inputSignal) {
         std::exit(EXIT_FAILURE);
     }
     signalInput_         = inputSignal;
+    basebandInput_.isInit = false;
+    isUpdateInputSignal_ = true;
+    // reset process status
+    isTOFCalculated_ = false;
+    isDOACalculated_ = false;
+}
+
+void SignalProcess::updateInputSignal(ChannelSignalVector &&inputSignal) {
+    if (isUpdateInputSignal_) {
+        std::cerr << termColor("red") << "SignalProcess::updateInputSignal: updated signal is not processed"
+                  << termColor("nocolor") << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    signalInput_         = std::move(inputSignal);
+    basebandInput_.isInit = false;
     isUpdateInputSignal_ = true;
     // reset process status
     isTOFCalculated_ = false;
     isDOACalculated_ = false;
 }
 
+void SignalProcess::releaseInputSignal(ChannelSignalVector &signal) {
+    signal               = std::move(signalInput_);
+    signalInput_         = ChannelSignalVector();
+    isUpdateInputSignal_ = false;
+}
+
+void SignalProcess::releaseBasebandSignal(BasebandSignal &baseband) {
+    baseband       = std::move(basebandInput_);
+    basebandInput_ = BasebandSignal();
+}
+
+void SignalProcess::loadBasebandSignal(BasebandSignal &&baseband) {
+    if (!isUpdateInputSignal_) {
+        std::cerr << termColor("red") << "SignalProcess::loadBasebandSignal: input signal is not updated"
+                  << termColor("nocolor") << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    basebandInput_ = std::move(baseband);
+}
+
+void SignalProcess::loadTOFResult(const std::vector<double> &tofRes) {
+    if (!isUpdateInputSignal_) {
+        std::cerr << termColor("red") << "SignalProcess::loadTOFResult: input signal is not updated"
+                  << termColor("nocolor") << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    tofRes_          = tofRes;
+    tofOutput_       = calOptimalTOF(tofRes_);
+    isTOFCalculated_ = true;
+}
+
+void SignalProcess::loadTOFResult(const std::vector<double> &tofRes, ChannelSignalVector &&correlationResult) {
+    loadTOFResult(tofRes);
+    correlationResult_ = std::move(correlationResult);
+}
+
+void SignalProcess::setThreadPool(ThreadPool *threadPool) {
+    tofProcess_->setThreadPool(threadPool);
+    doaProcess_->setThreadPool(threadPool);
+    if (frontEnd_ != nullptr) {
+        frontEnd_->setThreadPool(threadPool);
+    }
+    if (preFilter_ != nullptr) {
+        preFilter_->setThreadPool(threadPool);
+    }
+}
+
+void SignalProcess::setSideAmpSpecEnable(bool isEnable) {
+    doaProcess_->setSideAmpSpecEnable(isEnable);
+}
+
 double SignalProcess::calculateTOF() {
     if (!isLoadRefSignal_) {
         std::cerr << termColor("red") << "SignalProcess::calculateTOF: reference signal is not loaded"
@@ -55,10 +131,20 @@ double SignalProcess::calculateTOF() {
         std::exit(EXIT_FAILURE);
     }
 
-    // process
-    tofProcess_->calculateTOF(signalInput_, tofRes_);
+    // band-pass first, each triggered ping is a new block of samples, it does not continue the previous one
+    if (preFilter_ != nullptr) {
+        preFilter_->reset();
+        preFilter_->process(signalInput_);
+    }
+    // process, on the baseband when the front-end is enabled
+    if (frontEnd_ != nullptr) {
+        frontEnd_->decimate(signalInput_, basebandInput_);
+        tofProcess_->calculateTOF(basebandInput_, tofRes_);
+    } else {
+        tofProcess_->calculateTOF(signalInput_, tofRes_);
+    }
     // save the correlation result
-    correlationResult_ = tofProcess_->getCorrelationResult();
+    tofProcess_->releaseCorrelationResult(correlationResult_);
     // set the process status
     isTOFCalculated_ = true;
 
@@ -72,17 +158,44 @@ double SignalProcess::calculateDOA() {
                   << std::endl;
         std::exit(EXIT_FAILURE);
     }
+    // the baseband is only missing when TOF ran elsewhere (streaming mode)
+    if (frontEnd_ != nullptr && !basebandInput_.isInit) {
+        frontEnd_->decimate(signalInput_, basebandInput_);
+    }
     // find the minimum TOF
     double minTOF     = *std::min_element(tofRes_.begin(), tofRes_.end());
-    int    startIndex = (int) (minTOF * systemInfo_.signalInfo.sampleRate);
+    double sampleRate = frontEnd_ != nullptr ? basebandInput_.sampleRate : systemInfo_.signalInfo.sampleRate;
+    int    startIndex = (int) (minTOF * sampleRate);
+    // the band-passed signal lags the TOF by the group delay of the pre-filter, the window follows it while it fits
+    if (preFilter_ != nullptr) {
+        int delay        = (int) std::lround(preFilter_->groupDelay() * sampleRate / systemInfo_.signalInfo.sampleRate);
+        int windowLength = (int) (systemInfo_.signalProcessInfo.processDuration * sampleRate);
+        int signalLength = frontEnd_ != nullptr ? basebandInput_.signalLength : signalInput_.signalLength;
+        if (startIndex + delay + windowLength <= signalLength) {
+            startIndex += delay;
+        }
+    }
     // set doa parameters
     doaProcess_->setParam(startIndex, systemInfo_.signalProcessInfo.processDuration,
                           systemInfo_.signalProcessInfo.startFrequency, systemInfo_.signalProcessInfo.endFrequency,
                           systemInfo_.signalProcessInfo.doaStep);
-    // process
-    doaProcess_->calculateDOA_CBF(signalInput_, doaOutput_);
-    // save the beam pattern
-    doaProcess_->getBeamPattern(beamPattern_);
+    // process with the configured method
+    if (frontEnd_ != nullptr) {
+        doaProcess_->calculateDOA(basebandInput_, systemInfo_.signalProcessInfo.doaMethod, doaOutput_);
+        isDOACalculated_ = true;
+        return doaOutput_;
+    }
+    switch (systemInfo_.signalProcessInfo.doaMethod) {
+        case DOA_MVDR:
+            doaProcess_->calculateDOA_MVDR(signalInput_, doaOutput_);
+            break;
+        case DOA_MUSIC:
+            doaProcess_->calculateDOA_MUSIC(signalInput_, doaOutput_);
+            break;
+        default:
+            doaProcess_->calculateDOA_CBF(signalInput_, doaOutput_);
+            break;
+    }
     // set the process status
     isDOACalculated_ = true;
 
@@ -94,7 +207,7 @@ double SignalProcess::calOptimalTOF(const std::vector<double> &tofres) {
     return *std::min_element(tofres.begin(), tofres.end());
 }
 
-double SignalProcess::updateACG() {
+double SignalProcess::updateACG(AgcMeasurement &measurement) {
     if (!isTOFCalculated_) {
         std::cerr << termColor("red") << "SignalProcess::updateACG: TOF is not calculated" << termColor("nocolor")
                   << std::endl;
@@ -113,26 +226,9 @@ double SignalProcess::updateACG() {
         }
     }
 
-    // update the receive gain
-    // 0->0v, 254->3.3v
-    if (agcPower_ > maxPower_) {
-        receiveGain_ -= agcStep_;
-        // if (receiveGain_ < 11) {
-        //     receiveGain_ = 10;
-        // }
-    } else if (agcPower_ < minPower_) {
-        receiveGain_ += agcStep_;
-        // if (receiveGain_ > 249) {
-        //     receiveGain_ = 250;
-        // }
-    }
-
-    // define the range of the receive gain
-    if (receiveGain_ <= 0) {
-        receiveGain_ = 0;
-    } else if (receiveGain_ >= systemInfo_.agcInfo.maxGainValue) {
-        receiveGain_ = systemInfo_.agcInfo.maxGainValue;
-    }
+    // update the receive gain, within [minGain, maxGain]
+    measurement.peakPower = agcPower_;
+    receiveGain_          = agcController_->update(measurement);
     // update the ACG status
     isACGUpdated_ = true;
 
@@ -152,7 +248,8 @@ void SignalProcess::getBeamPattern(Eigen::MatrixXd &beamPattern) {
                   << std::endl;
         std::exit(EXIT_FAILURE);
     }
-    beamPattern = beamPattern_;
+    // fetched on demand, most pings do not save it
+    doaProcess_->getBeamPattern(beamPattern);
 }
 
 void SignalProcess::getTOFResult(std::vector<double> &tofRes) {
@@ -173,6 +270,16 @@ void SignalProcess::getCorrelationResult(ChannelSignalVector &correlationResult)
     correlationResult = correlationResult_;
 }
 
+void SignalProcess::releaseCorrelationResult(ChannelSignalVector &correlationResult) {
+    if (!isTOFCalculated_) {
+        std::cerr << termColor("red") << "SignalProcess::releaseCorrelationResult: TOF is not calculated"
+                  << termColor("nocolor") << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+    correlationResult  = std::move(correlationResult_);
+    correlationResult_ = ChannelSignalVector();
+}
+
 void SignalProcess::getSignalSideAmpSpec(ChannelSignalVector &signalSideAmpSpec) {
     if (!isDOACalculated_) {
         std::cerr << termColor("red") << "SignalProcess::getSignalSideAmpSpec: DOA is not calculated"
@@ -182,9 +289,8 @@ void SignalProcess::getSignalSideAmpSpec(ChannelSignalVector &signalSideAmpSpec)
     Eigen::MatrixXd tempMatrix;
     doaProcess_->getSignalSideAmpSpec(tempMatrix);
     signalSideAmpSpec.resize(tempMatrix.rows(), tempMatrix.cols());
+    // one row at a time (the matrix is column major)
     for (int i = 0; i < tempMatrix.rows(); ++i) {
-        for (int j = 0; j < tempMatrix.cols(); ++j) {
-            signalSideAmpSpec.channels[i][j] = tempMatrix(i, j);
-        }
+        Eigen::Map<Eigen::RowVectorXd>(signalSideAmpSpec.channels[i].data(), tempMatrix.cols()) = tempMatrix.row(i);
     }
 }
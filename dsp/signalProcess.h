@@ -16,8 +16,12 @@
 #include "../general/typedef.h"
 #include "../tool/ColorParse.h"
 #include "../tool/SafeQueue.hpp"
+#include "agcController.h"
 #include "doa.h"
+#include "filter/preFilter.h"
+#include "frontEnd.h"
 #include "tof.h"
+#include <memory>
 
 class SignalProcess : public SignalBase {
 public:
@@ -28,6 +32,26 @@ public:
     void loadRefSignal(const ChannelSignalVector &refSignal);
 
     void updateInputSignal(const ChannelSignalVector &inputSignal);
+    void updateInputSignal(ChannelSignalVector &&inputSignal);
+
+    // hand the input signal over to the next pipeline stage (moved out, no copy)
+    void releaseInputSignal(ChannelSignalVector &signal);
+
+    // same for its baseband, empty unless the decimating front-end is enabled and calculateTOF() has run
+    void releaseBasebandSignal(BasebandSignal &baseband);
+    // load the baseband of the current input signal, so calculateDOA() does not decimate it again
+    void loadBasebandSignal(BasebandSignal &&baseband);
+
+    // load the TOF result of another stage, so this object can run calculateDOA() only
+    void loadTOFResult(const std::vector<double> &tofRes);
+    // same, with the correlation result computed elsewhere (used by updateACG())
+    void loadTOFResult(const std::vector<double> &tofRes, ChannelSignalVector &&correlationResult);
+
+    // share a thread pool with the TOF and DOA kernels (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool);
+
+    // whether the next calculateDOA() also builds the side amplitude spectrum (only for the pings that save it)
+    void setSideAmpSpecEnable(bool isEnable);
 
     double calculateTOF();
 
@@ -35,7 +59,16 @@ public:
 
     double calOptimalTOF(const std::vector<double> &tofres);
 
-    double updateACG(); // using the TOF result to update the ACG
+    /***
+     * @description: Using the TOF result to update the ACG: the correlation peak goes into the measurement, the AGC
+     * controller ([AGC] controller) derives the gain of the next ping from it
+     * @param {AgcMeasurement} &measurement     time, TOF, saturation and gain tag of the ping, filled by the caller
+     * @return {double} the gain voltage of the next ping
+     */
+    double updateACG(AgcMeasurement &measurement);
+
+    // largest correlation value of the ping, the power updateACG() decided on
+    double getAGCPower() const { return agcPower_; }
 
     void resetFlag();
 
@@ -45,13 +78,18 @@ public:
 
     void getCorrelationResult(ChannelSignalVector &correlationResult);
 
+    // move the correlation result out (no copy), call it after updateACG()
+    void releaseCorrelationResult(ChannelSignalVector &correlationResult);
+
     void getSignalSideAmpSpec(ChannelSignalVector &signalSideAmpSpec);
 
 
 private:
     // process object
-    TOF *tofProcess_;
-    DOA *doaProcess_;
+    TOF                       *tofProcess_;
+    DOA                       *doaProcess_;
+    std::unique_ptr<FrontEnd>  frontEnd_;  // decimating front-end, only created when it is enabled
+    std::unique_ptr<PreFilter> preFilter_; // band-pass pre-filter, only created when it is enabled
 
     // status flag
     bool isUpdateInputSignal_ = false;
@@ -65,18 +103,17 @@ private:
     PositionResult      positionResult_;
     ChannelSignalVector refSignal_;
     ChannelSignalVector signalInput_;
+    BasebandSignal      basebandInput_;
+    BasebandSignal      refBaseband_;
     ChannelSignalVector correlationResult_;
-    Eigen::MatrixXd     beamPattern_;
     std::vector<double> tofRes_;
     double              tofOutput_;
     double              doaOutput_;
 
     // adaptive gain control
-    double maxPower_;
-    double receiveGain_;
-    double agcPower_;
-    double minPower_;
-    double agcStep_;
+    std::unique_ptr<AgcController> agcController_;
+    double                         receiveGain_;
+    double                         agcPower_;
 
     // temp parameter
     int processSignalLength_;
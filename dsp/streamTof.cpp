@@ -0,0 +1,266 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 15:02:40
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 15:02:40
+ * @FilePath: /Raspi2USBL/dsp/streamTof.cpp
+ * @Description: See streamTof.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "streamTof.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+template <typename T>
+StreamTOFT<T>::StreamTOFT(SystemInfo &systeminfo, const ChannelSignalVector &refSignal, int channelNum)
+    : SignalBase(systeminfo)
+    , channelNum_(channelNum)
+    , hopLength_(systeminfo.streamInfo.hopSamples)
+    , refSignalLength_(refSignal.signalLength)
+    , detectThreshold_(systeminfo.streamInfo.detectThreshold)
+    , pingPeriod_(systeminfo.streamInfo.pingPeriod)
+    , sampleRate_(systeminfo.signalProcessInfo.referenceSignalFrequency)
+    , sampleCount_(0)
+    , historyIndex_(0)
+    , corrHistoryIndex_(0)
+    , noiseFloor_(0)
+    , isWindowOpen_(false)
+    , windowEnd_(0) {
+    if (!refSignal.isInit || refSignal.channelNum != 1 || refSignalLength_ == 0 ||
+        static_cast<int>(refSignal.channels[0].size()) != refSignalLength_) {
+        throw std::runtime_error("StreamTOF: reference signal must be 1 channel of signalLength samples");
+    }
+    if (channelNum_ < 1 || hopLength_ < 1) {
+        throw std::invalid_argument("StreamTOF: invalid channel number or hop length");
+    }
+    refSignal_ = refSignal;
+    corrIndex_ = -static_cast<int64_t>(refSignalLength_ - 1);
+
+    // DOA reads processDuration from the earliest peak, the extra reference length covers the channel spread
+    int doaLength = static_cast<int>(systemInfo_.signalProcessInfo.processDuration * systemInfo_.signalInfo.sampleRate);
+    windowLength_ = std::max(doaLength, refSignalLength_) + refSignalLength_;
+
+    // overlap-save block: refLength - 1 old samples followed by one hop
+    fftLength_ = fftGoodSize(hopLength_ + refSignalLength_ - 1);
+    for (int ch = 0; ch < channelNum_; ++ch) {
+        fftEngines_.emplace_back(new FFTEngine<T>(fftLength_));
+    }
+    FFTEngine<T>    &engine = *fftEngines_[0];
+    std::complex<T> *buffer = engine.data();
+    std::fill(buffer, buffer + fftLength_, std::complex<T>(0, 0));
+    for (int i = 0; i < refSignalLength_; ++i) {
+        buffer[i] = std::complex<T>(static_cast<T>(refSignal_.channels[0][refSignalLength_ - 1 - i]), 0);
+    }
+    engine.forward();
+    refSpectrum_.assign(buffer, buffer + fftLength_);
+
+    corrHop_.resize(channelNum_, hopLength_);
+    sampleHistory_.resize(channelNum_, 0);
+    corrHistory_.resize(channelNum_, 0);
+    windowPeakIndex_.resize(channelNum_);
+    windowPeak_.resize(channelNum_);
+}
+
+template <typename T>
+void StreamTOFT<T>::process(const ChannelSignalVector &hop, std::vector<StreamDetection> &detections) {
+    if (!hop.isInit || hop.channelNum != channelNum_ || hop.signalLength != hopLength_) {
+        throw std::invalid_argument("StreamTOF::process: the hop must have channelNum x hopSamples samples");
+    }
+    detections.clear();
+
+    filterHop(hop);
+    updateHistory(hop);
+    sampleCount_ += hopLength_;
+    detect();
+    corrIndex_ += hopLength_;
+
+    // closed windows leave in order, as soon as their samples and correlation are in the history
+    while (!pendingPeakIndex_.empty()) {
+        StreamDetection detection;
+        if (!extractDetection(detection)) {
+            break;
+        }
+        detections.push_back(std::move(detection));
+        pendingPeakIndex_.erase(pendingPeakIndex_.begin());
+    }
+
+    // drop the history nobody can ask for any more, always keep refLength - 1 samples for the next block
+    uint64_t keepFrom = static_cast<uint64_t>(std::max<int64_t>(corrIndex_, 0));
+    if (isWindowOpen_) {
+        keepFrom = std::min(keepFrom, windowEnd_ - refSignalLength_);
+    }
+    for (const auto &peakIndex : pendingPeakIndex_) {
+        keepFrom = std::min(keepFrom, *std::min_element(peakIndex.begin(), peakIndex.end()));
+    }
+    uint64_t tailStart  = sampleCount_ - std::min<uint64_t>(sampleCount_, refSignalLength_);
+    uint64_t keepSample = std::min(keepFrom, tailStart);
+    if (keepSample > historyIndex_) {
+        int drop = static_cast<int>(keepSample - historyIndex_);
+        for (auto &channel : sampleHistory_.channels) {
+            channel.erase(channel.begin(), channel.begin() + drop);
+        }
+        sampleHistory_.signalLength -= drop;
+        historyIndex_ = keepSample;
+    }
+    if (keepFrom > corrHistoryIndex_) {
+        int drop = static_cast<int>(std::min<uint64_t>(keepFrom - corrHistoryIndex_, corrHistory_.signalLength));
+        for (auto &channel : corrHistory_.channels) {
+            channel.erase(channel.begin(), channel.begin() + drop);
+        }
+        corrHistory_.signalLength -= drop;
+        corrHistoryIndex_ += drop;
+    }
+}
+
+template <typename T>
+void StreamTOFT<T>::filterHop(const ChannelSignalVector &hop) {
+    int overlap = refSignalLength_ - 1;
+
+    // channels are independent, each one writes its own correlation row
+    auto filterChannels = [&](int chBegin, int chEnd) {
+        for (int ch = chBegin; ch < chEnd; ++ch) {
+            FFTEngine<T>              &engine  = *fftEngines_[ch];
+            std::complex<T>           *buffer  = engine.data();
+            const std::vector<double> &history = sampleHistory_.channels[ch];
+            const std::vector<double> &x       = hop.channels[ch];
+
+            // the last refLength - 1 samples (zeros before the stream start), the hop, zero padding
+            int historyLength = std::min<int>(overlap, static_cast<int>(history.size()));
+            int zeroLength    = overlap - historyLength;
+            std::fill(buffer, buffer + zeroLength, std::complex<T>(0, 0));
+            const double *tail = history.data() + history.size() - historyLength;
+            for (int i = 0; i < historyLength; ++i) {
+                buffer[zeroLength + i] = std::complex<T>(static_cast<T>(tail[i]), 0);
+            }
+            for (int i = 0; i < hopLength_; ++i) {
+                buffer[overlap + i] = std::complex<T>(static_cast<T>(x[i]), 0);
+            }
+            std::fill(buffer + overlap + hopLength_, buffer + fftLength_, std::complex<T>(0, 0));
+
+            engine.forward();
+            for (int i = 0; i < fftLength_; ++i) {
+                buffer[i] *= refSpectrum_[i];
+            }
+            engine.inverse();
+
+            // the circular part is the first refLength - 1 outputs, the rest equals the linear correlation
+            std::vector<double> &y = corrHop_.channels[ch];
+            for (int i = 0; i < hopLength_; ++i) {
+                y[i] = static_cast<double>(buffer[overlap + i].real());
+            }
+        }
+    };
+
+    if (threadPool_ != nullptr) {
+        threadPool_->parallelFor(0, channelNum_, 1, filterChannels);
+    } else {
+        filterChannels(0, channelNum_);
+    }
+}
+
+template <typename T>
+void StreamTOFT<T>::updateHistory(const ChannelSignalVector &hop) {
+    // correlation before the stream start (negative index) is not kept
+    int corrSkip = static_cast<int>(std::min<int64_t>(std::max<int64_t>(-corrIndex_, 0), hopLength_));
+    if (corrHistory_.signalLength == 0) {
+        corrHistoryIndex_ = static_cast<uint64_t>(std::max<int64_t>(corrIndex_, 0));
+    }
+    for (int ch = 0; ch < channelNum_; ++ch) {
+        sampleHistory_.channels[ch].insert(sampleHistory_.channels[ch].end(), hop.channels[ch].begin(),
+                                           hop.channels[ch].end());
+        corrHistory_.channels[ch].insert(corrHistory_.channels[ch].end(), corrHop_.channels[ch].begin() + corrSkip,
+                                         corrHop_.channels[ch].end());
+    }
+    sampleHistory_.signalLength += hopLength_;
+    corrHistory_.signalLength += hopLength_ - corrSkip;
+}
+
+template <typename T>
+void StreamTOFT<T>::detect() {
+    double threshold  = detectThreshold_ * noiseFloor_;
+    bool   isQuietHop = !isWindowOpen_;
+    double hopLevel   = 0;
+    int    levelCount = 0;
+
+    for (int i = 0; i < hopLength_; ++i) {
+        int64_t index = corrIndex_ + i;
+        if (index < 0) {
+            continue;
+        }
+        double level = 0;
+        for (int ch = 0; ch < channelNum_; ++ch) {
+            level = std::max(level, corrHop_.channels[ch][i]);
+        }
+        hopLevel += std::abs(level);
+        ++levelCount;
+
+        // no detection before the noise floor is known
+        if (!isWindowOpen_ && noiseFloor_ > 0 && level > threshold) {
+            isWindowOpen_ = true;
+            isQuietHop    = false;
+            windowEnd_    = static_cast<uint64_t>(index) + refSignalLength_;
+            for (int ch = 0; ch < channelNum_; ++ch) {
+                windowPeakIndex_[ch] = static_cast<uint64_t>(index);
+                windowPeak_[ch]      = corrHop_.channels[ch][i];
+            }
+        }
+        if (isWindowOpen_) {
+            for (int ch = 0; ch < channelNum_; ++ch) {
+                if (corrHop_.channels[ch][i] > windowPeak_[ch]) {
+                    windowPeak_[ch]      = corrHop_.channels[ch][i];
+                    windowPeakIndex_[ch] = static_cast<uint64_t>(index);
+                }
+            }
+            if (static_cast<uint64_t>(index) + 1 >= windowEnd_) {
+                pendingPeakIndex_.push_back(windowPeakIndex_);
+                isWindowOpen_ = false;
+            }
+        }
+    }
+
+    // the noise floor only follows hops without a ping
+    if (levelCount > 0 && isQuietHop && !isWindowOpen_) {
+        hopLevel /= levelCount;
+        noiseFloor_ = noiseFloor_ > 0 ? 0.9 * noiseFloor_ + 0.1 * hopLevel : hopLevel;
+    }
+}
+
+template <typename T>
+bool StreamTOFT<T>::extractDetection(StreamDetection &detection) {
+    const std::vector<uint64_t> &peakIndex = pendingPeakIndex_.front();
+    uint64_t                     start     = *std::min_element(peakIndex.begin(), peakIndex.end());
+    uint64_t                     corrEnd   = static_cast<uint64_t>(std::max<int64_t>(corrIndex_, 0));
+    if (start + windowLength_ > corrEnd || start < corrHistoryIndex_ || start < historyIndex_) {
+        return false;
+    }
+
+    detection.startIndex = start;
+    detection.peakIndex  = peakIndex;
+    detection.tof.resize(channelNum_);
+    detection.windowTOF.resize(channelNum_);
+    for (int ch = 0; ch < channelNum_; ++ch) {
+        double time = static_cast<double>(peakIndex[ch]) / sampleRate_;
+        detection.tof[ch]       = pingPeriod_ > 0 ? std::fmod(time, pingPeriod_) : time;
+        detection.windowTOF[ch] = static_cast<double>(peakIndex[ch] - start) / sampleRate_;
+    }
+
+    detection.signal.resize(channelNum_, windowLength_);
+    detection.correlation.resize(channelNum_, windowLength_);
+    size_t sampleOffset = static_cast<size_t>(start - historyIndex_);
+    size_t corrOffset   = static_cast<size_t>(start - corrHistoryIndex_);
+    for (int ch = 0; ch < channelNum_; ++ch) {
+        std::copy(sampleHistory_.channels[ch].begin() + sampleOffset,
+                  sampleHistory_.channels[ch].begin() + sampleOffset + windowLength_,
+                  detection.signal.channels[ch].begin());
+        std::copy(corrHistory_.channels[ch].begin() + corrOffset,
+                  corrHistory_.channels[ch].begin() + corrOffset + windowLength_,
+                  detection.correlation.channels[ch].begin());
+    }
+    return true;
+}
+
+// only the configured precision is instantiated (fftw3 for double, fftw3f for float)
+template class StreamTOFT<DSPReal>;
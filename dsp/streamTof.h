@@ -0,0 +1,123 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 15:02:40
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 15:02:40
+ * @FilePath: /Raspi2USBL/dsp/streamTof.h
+ * @Description: Streaming (overlap-save) matched filter and ping detector for continuous acquisition
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _STREAMTOF_H_
+#define _STREAMTOF_H_
+
+#include "../tool/ThreadPool.h"
+#include "fftEngine.h"
+#include "signalBase.h"
+#include <cstdint>
+
+// one ping found in the sample stream
+typedef struct StreamDetection {
+    uint64_t              startIndex;  // absolute sample index of signal[0], the earliest channel peak
+    std::vector<uint64_t> peakIndex;   // absolute sample index of the correlation peak of each channel
+    std::vector<double>   tof;         // TOF of each channel, peak time modulo the ping period
+    std::vector<double>   windowTOF;   // TOF of each channel relative to signal[0]
+    ChannelSignalVector   signal;      // raw samples from startIndex, long enough for DOA
+    ChannelSignalVector   correlation; // correlation from startIndex, same length as signal
+} StreamDetection;
+
+/***
+ * @description: Overlap-save matched filter over a continuous sample stream. Every call of process() takes one
+ * hop of new samples, keeps the last refLength - 1 samples of the previous hops and correlates them with the
+ * cached reference spectrum, so the cost and the latency scale with the hop, not with the listening window.
+ * A chirp straddling two hops is found like any other.
+ * A detection window opens when the correlation exceeds detectThreshold times the running noise floor and closes
+ * refLength samples later, each channel reports its peak inside the window with its absolute sample index.
+ */
+template <typename T>
+class StreamTOFT : public SignalBase {
+public:
+    /***
+     * @description: Create the streaming matched filter
+     * @param {SystemInfo} &systeminfo          The system info ([Receive] stream keys and the DOA duration)
+     * @param {ChannelSignalVector} &refSignal  The reference signal (1 channel)
+     * @param {int} channelNum                  The number of channels of the stream
+     * @return {*}
+     */
+    StreamTOFT(SystemInfo &systeminfo, const ChannelSignalVector &refSignal, int channelNum);
+    ~StreamTOFT() = default;
+
+    // run the channels on a thread pool (nullptr: serial)
+    void setThreadPool(ThreadPool *threadPool) {
+        threadPool_ = threadPool;
+    }
+
+    /***
+     * @description: Filter one hop and collect the pings completed by it
+     * @param {ChannelSignalVector} &hop                The new samples, hopSamples per channel
+     * @param {vector<StreamDetection>} &detections     The completed pings (cleared first)
+     * @return {*}
+     */
+    void process(const ChannelSignalVector &hop, std::vector<StreamDetection> &detections);
+
+    // number of samples per channel consumed so far (absolute index of the next sample)
+    uint64_t sampleCount() const {
+        return sampleCount_;
+    }
+
+    // absolute index of the oldest sample still held, no detection starts before it
+    uint64_t historyIndex() const {
+        return historyIndex_;
+    }
+
+    int fftLength() const {
+        return fftLength_;
+    }
+
+private:
+    // correlate the current hop, corrHop_ then holds the correlation from absolute index corrIndex_
+    void filterHop(const ChannelSignalVector &hop);
+    // update the noise floor and the open detection window with the new correlation
+    void detect();
+    // append the hop to the sample and correlation history and drop what can no longer be needed
+    void updateHistory(const ChannelSignalVector &hop);
+    // cut the window of a finished detection out of the history
+    bool extractDetection(StreamDetection &detection);
+
+    int      channelNum_;
+    int      hopLength_;
+    int      refSignalLength_;
+    int      fftLength_;
+    int      windowLength_;    // samples handed over to DOA per ping
+    double   detectThreshold_; // times the noise floor
+    double   pingPeriod_;      // s, 0: TOF is the time since the stream start
+    double   sampleRate_;
+    uint64_t sampleCount_;
+    int64_t  corrIndex_; // absolute index of corrHop_[0], negative while the first refLength - 1 samples arrive
+
+    ChannelSignalVector                        refSignal_;
+    std::vector<std::unique_ptr<FFTEngine<T>>> fftEngines_;
+    std::vector<std::complex<T>>               refSpectrum_;
+    ChannelSignalVector                        corrHop_;
+
+    // history, sampleHistory_ starts at absolute index historyIndex_, corrHistory_ at corrHistoryIndex_
+    ChannelSignalVector sampleHistory_;
+    uint64_t            historyIndex_;
+    ChannelSignalVector corrHistory_;
+    uint64_t            corrHistoryIndex_;
+
+    // detector state
+    double                             noiseFloor_;
+    bool                               isWindowOpen_;
+    uint64_t                           windowEnd_; // correlation index that closes the open window
+    std::vector<uint64_t>              windowPeakIndex_;
+    std::vector<double>                windowPeak_;
+    std::vector<std::vector<uint64_t>> pendingPeakIndex_; // closed windows waiting for their samples
+
+    ThreadPool *threadPool_ = nullptr;
+};
+
+typedef StreamTOFT<DSPReal> StreamTOF;
+
+#endif // _STREAMTOF_H_
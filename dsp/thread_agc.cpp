@@ -11,7 +11,7 @@
 #include "thread_agc.h"
 // #include <cctype>
 
-ThreadAGC::ThreadAGC(SystemInfo &systeminfo, sfq::Safe_Queue<double> *agcDataque)
+ThreadAGC::ThreadAGC(SystemInfo &systeminfo, sfq::Safe_Queue<AgcRequest> *agcDataque)
     : systemInfo_(systeminfo)
     , agcDataque_(agcDataque) {
 
@@ -34,6 +34,8 @@ void ThreadAGC::init() {
         gainMin_       = systemInfo_.agcInfo.minGainValue;
         gainMax_       = systemInfo_.agcInfo.maxGainValue;
         gainStep_      = systemInfo_.agcInfo.gainStep;
+        echoTimeout_   = systemInfo_.agcInfo.echoTimeout;
+        maxRetries_    = systemInfo_.agcInfo.maxRetries;
 
         // open serial port
         serial_ = new SerialDriver();
@@ -47,23 +49,32 @@ bool ThreadAGC::setSerialPort(SerialDriver *serialPort) {
     return true;
 }
 
-bool ThreadAGC::setAGCQueue(sfq::Safe_Queue<double> *agcDataque) {
+bool ThreadAGC::setAGCQueue(sfq::Safe_Queue<AgcRequest> *agcDataque) {
     agcDataque_    = agcDataque;
     isAGCQueueSet_ = true;
     return true;
 }
 
+void ThreadAGC::setGainTracker(GainTracker *gainTracker) {
+    gainTracker_ = gainTracker;
+}
+
+int ThreadAGC::quantizeGain(double voltageValue) {
+    int voltageInt = static_cast<int>(voltageValue);
+    int voltageDec = std::round((voltageValue - voltageInt) * 100);
+    if (voltageDec >= 100) { // avoid the decimal part is 100
+        voltageDec = 99;
+    }
+    return voltageInt * 100 + voltageDec;
+}
+
 std::string ThreadAGC::creatDACCommand(double voltageValue) {
     std::string command;
     if (checkVoltageValue(voltageValue)) {
-        int voltageInt = static_cast<int>(voltageValue);
-        int voltageDec = std::round((voltageValue - voltageInt) * 100);
-        if (voltageDec >= 100) { // avoid the decimal part is 100
-            voltageDec = 99;
-        }
+        int                value = quantizeGain(voltageValue);
         std::ostringstream ss;
-        ss << std::setw(2) << std::setfill('0') << voltageInt;
-        ss << std::setw(2) << std::setfill('0') << voltageDec;
+        ss << std::setw(2) << std::setfill('0') << value / 100;
+        ss << std::setw(2) << std::setfill('0') << value % 100;
         command = "5A01" + ss.str() + "A5";
     } else {
         command = "5A010000A5";
@@ -73,30 +84,61 @@ std::string ThreadAGC::creatDACCommand(double voltageValue) {
     return command;
 }
 
+bool ThreadAGC::readEcho(std::string &response, size_t length) {
+    auto    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(echoTimeout_);
+    uint8_t buffer[16];
+    size_t  received = 0;
+    response.clear();
+    while (received < length) {
+        auto remaining   = deadline - std::chrono::steady_clock::now();
+        int  remainingMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count());
+        if (remainingMs <= 0 || !serial_->waitForInput(remainingMs)) {
+            return false;
+        }
+        int bytes_read = serial_->readBytes(buffer, std::min(sizeof(buffer), length - received));
+        for (int i = 0; i < bytes_read; i++) {
+            char hex[3];
+            std::snprintf(hex, sizeof(hex), "%02X", buffer[i]);
+            response += hex;
+        }
+        received += bytes_read;
+    }
+    return true;
+}
+
 bool ThreadAGC::sendDACCommand(double voltageValue) {
-    if (isSerialPortSet_ && serial_->isOpen()) {
-        // clear the serial buffer
+    if (!isSerialPortSet_ || !serial_->isOpen()) {
+        return false;
+    }
+    std::string command = creatDACCommand(voltageValue);
+    std::string response;
+    for (int attempt = 0; attempt <= maxRetries_; attempt++) {
+        // drop a late echo of an earlier attempt
         serial_->flush();
-        // send the command to DAC
-        std::string command = creatDACCommand(voltageValue);
+        // send the command to DAC, one write
         serial_->writeHexString(command);
-        // check the command is sent successfully
-        std::this_thread::sleep_for(std::chrono::milliseconds(10)); // wait for 10 ms to receive the response
-        std::string response;
-        serial_->readHexBytes(response, command.length());          // read response
-        transform(response.begin(), response.end(), response.begin(), ::toupper);
-        if (response == command) {
+        {
+            std::lock_guard<std::mutex> lock(statsMtx_);
+            stats_.commandNum++;
+            stats_.retryNum += attempt > 0 ? 1 : 0;
+        }
+        // the DAC echoes the command, or answers FF FF FF FF FF to a voltage out of its range
+        bool isEchoed = readEcho(response, command.length() / 2);
+        if (isEchoed && response == command) {
 #ifdef _THREAD_AGC_DEBUG_
             std::cout << termColor("green") << "The command is sent successfully: " << command << termColor("nocolor")
                       << "\n";
 #endif
             return true;
-        } else {
-            std::cerr << termColor("red") << "The command is not sent successfully: Response Error."
-                      << termColor("nocolor") << "\n";
+        }
+        if (isEchoed && response == "FFFFFFFFFF") {
+            std::cerr << termColor("red") << "The command is rejected by the DAC: " << command << termColor("nocolor")
+                      << "\n";
             return false;
         }
     }
+    std::cerr << termColor("red") << "The command is not sent successfully: "
+              << (response.empty() ? "No Response." : "Response Error.") << termColor("nocolor") << "\n";
     return false;
 }
 
@@ -109,32 +151,90 @@ bool ThreadAGC::checkVoltageValue(double voltageValue) {
     return true;
 }
 
+void ThreadAGC::actuate(const AgcRequest &request) {
+    int value = checkVoltageValue(request.gain) ? quantizeGain(request.gain) : 0;
+    if (isDACSet_ && value == dacValue_) {
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.unchangedNum++;
+        return;
+    }
+
+    if (gainTracker_ != nullptr) {
+        gainTracker_->beginCommand(std::chrono::steady_clock::now());
+    }
+    isDACSet_ = sendDACCommand(request.gain);
+    dacValue_ = value;
+    if (gainTracker_ != nullptr) {
+        if (isDACSet_) {
+            gainTracker_->confirm(value / 100.0, request.seq, std::chrono::steady_clock::now());
+        } else {
+            gainTracker_->invalidate(std::chrono::steady_clock::now());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    if (!isDACSet_) {
+        // the DAC state is unknown, the next gain is sent whatever its value
+        stats_.failureNum++;
+        return;
+    }
+    double latencyUs =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - request.time).count();
+    latencySumUs_ += latencyUs;
+    stats_.confirmedNum++;
+    stats_.maxLatencyUs  = std::max(stats_.maxLatencyUs, latencyUs);
+    stats_.confirmedGain = value / 100.0;
+    stats_.confirmedSeq  = request.seq;
+#ifdef _THREAD_AGC_DEBUG_
+    std::cout << termColor("blue") << "Gain Voltage " << stats_.confirmedGain << " V of ping " << request.seq
+              << " is set after " << latencyUs << " us" << termColor("nocolor") << std::endl;
+#endif // _THREAD_AGC_DEBUG_
+}
+
 void ThreadAGC::processAGC() {
+    applyThreadPolicy("AGC", systemInfo_.threadPolicyInfo.agc, systemInfo_.threadPolicyInfo.prefaultStackSize);
     if (enableThread_agcProcess_ && isSerialPortSet_ && isAGCQueueSet_) {
+        // the echo is awaited with poll(), a read never blocks
+        serial_->setNonBlocking(true);
+
         // send the init gain value to DAC
-        sendDACCommand(initGainValue_);
+        AgcRequest request;
+        request.gain = initGainValue_;
+        request.time = std::chrono::steady_clock::now();
+        actuate(request);
 
-        while (enableThread_agcProcess_) {
-            // get the agc value from the queue
-            gainValue_ = agcDataque_->wait_and_pop();
+        // get the agc value from the queue, until the queue is closed
+        while (agcDataque_->wait_and_pop(request)) {
+            // only the newest gain is set, the ones queued while the last command was echoed are superseded
+            uint64_t   coalescedNum = 0;
+            AgcRequest newer;
+            while (agcDataque_->try_pop(newer)) {
+                request = newer;
+                coalescedNum++;
+            }
+            {
+                std::lock_guard<std::mutex> lock(statsMtx_);
+                stats_.requestNum += coalescedNum + 1;
+                stats_.coalescedNum += coalescedNum;
+            }
+            gainValue_ = request.gain;
 #ifdef _THREAD_AGC_DEBUG_
             std::cout << termColor("blue") << "Received Gain Voltage: " << gainValue_ << termColor("nocolor")
                       << std::endl;
 #endif // _THREAD_AGC_DEBUG_
        // check the gain value
-            if (checkVoltageValue(gainValue_)) {
-                // send the command to DAC
-                sendDACCommand(gainValue_);
-            } else {
+            if (!checkVoltageValue(gainValue_)) {
                 // reset the gain value
-                gainValue_ = initGainValue_;
-                sendDACCommand(gainValue_);
+                gainValue_   = initGainValue_;
+                request.gain = gainValue_;
 #ifdef _THREAD_AGC_DEBUG_
                 std::cerr << termColor("red")
                           << "The voltage value is out of range, reset voltage to init voltage:" << initGainValue_
                           << " V." << termColor("nocolor") << "\n";
 #endif
             }
+            // send the command to DAC
+            actuate(request);
         }
     }
 }
@@ -162,10 +262,28 @@ void ThreadAGC::joinThread_agcProcess() {
 
 void ThreadAGC::closeThread_agcProcess() {
     enableThread_agcProcess_ = false;
+    if (agcDataque_ != nullptr) {
+        agcDataque_->close();
+    }
     joinThread_agcProcess();
+
+    AgcActuatorStats stats = getStats();
+    std::cout << termColor("blue") << "AGC: " << termColor("yellow") << stats.requestNum << " gains, "
+              << stats.confirmedNum << " set, " << stats.unchangedNum << " unchanged, " << stats.coalescedNum
+              << " superseded, " << stats.retryNum << " retries, " << stats.failureNum << " failed, latency "
+              << stats.meanLatencyUs << " us (max " << stats.maxLatencyUs << " us)" << termColor("nocolor")
+              << std::endl;
+
     if (serial_ != nullptr) {
         serial_->close();
         delete serial_;
         serial_ = nullptr;
     }
 }
+
+AgcActuatorStats ThreadAGC::getStats() const {
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    AgcActuatorStats            stats = stats_;
+    stats.meanLatencyUs               = stats_.confirmedNum > 0 ? latencySumUs_ / stats_.confirmedNum : 0;
+    return stats;
+}
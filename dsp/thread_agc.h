@@ -15,24 +15,52 @@
 #include "../dataio/serialDriver.h"
 #include "../tool/ColorParse.h"
 #include "../tool/SafeQueue.hpp"
+#include "gainTracker.h"
 #include "signalProcess.h"
 
 #include <chrono>
+#include <mutex>
 #include <thread>
 
+// counters of the AGC actuator, see ThreadAGC::getStats()
+typedef struct AgcActuatorStats {
+    uint64_t requestNum    = 0; // gains received from the DSP pipeline
+    uint64_t coalescedNum  = 0; // superseded by a newer gain before they were sent
+    uint64_t unchangedNum  = 0; // the DAC already holds the quantized value, nothing sent
+    uint64_t commandNum    = 0; // commands written, retries included
+    uint64_t confirmedNum  = 0; // echoed by the DAC
+    uint64_t retryNum      = 0; // no or a wrong echo within the echo timeout
+    uint64_t failureNum    = 0; // given up after the retries, or rejected by the DAC
+    double   meanLatencyUs = 0; // from the DSP pipeline deriving the gain to its echo, over the confirmed commands
+    double   maxLatencyUs  = 0;
+    double   confirmedGain = 0; // gain voltage the DAC is set to
+    uint64_t confirmedSeq  = 0; // ping the confirmed gain was derived from
+} AgcActuatorStats;
+
+/***
+ * @description: AGC actuator. The DSP pipeline pushes the gain of every ping and never waits; this thread takes the
+ * newest gain (the ones queued behind it are superseded), quantizes it to the 0.01 V steps of the DAC command and only
+ * writes a command when the value differs from the one the DAC holds. The echo is awaited with poll() for at most
+ * [AGC][echoTimeout] ms, a missing or wrong echo is resent up to [AGC][maxRetries] times, so a gain is set a few ms
+ * after the ping it was derived from (the actuation latency in getStats()). Every command is recorded in the gain
+ * tracker, if one is set, so the DSP pipeline knows the gain each ping was acquired with.
+ */
 class ThreadAGC {
 public:
-    explicit ThreadAGC(SystemInfo &systeminfo, sfq::Safe_Queue<double> *agcDataque);
+    explicit ThreadAGC(SystemInfo &systeminfo, sfq::Safe_Queue<AgcRequest> *agcDataque);
     ThreadAGC()  = default;
     ~ThreadAGC() = default;
 
     void init();
 
     bool setSerialPort(SerialDriver *serialPort);
-    bool setAGCQueue(sfq::Safe_Queue<double> *agcDataque);
+    bool setAGCQueue(sfq::Safe_Queue<AgcRequest> *agcDataque);
+    // set the gain history shared with the DSP pipeline, called before the thread is created
+    void setGainTracker(GainTracker *gainTracker);
 
     std::string creatDACCommand(double voltageValue);
 
+    // write the command and wait for its echo, resent up to maxRetries times; false when it is not confirmed
     bool sendDACCommand(double voltageValue);
 
     bool checkVoltageValue(double voltageValue);
@@ -43,16 +71,27 @@ public:
 
     void joinThread_agcProcess();
 
+    // closes the gain queue, the thread sets the newest gain still queued and exits
     void closeThread_agcProcess();
 
+    AgcActuatorStats getStats() const;
+
 private:
+    // DAC command value of a voltage: volts * 100, the decimal part below 1.00
+    static int quantizeGain(double voltageValue);
+    // set the DAC to the gain of the request unless it already holds it
+    void       actuate(const AgcRequest &request);
+    // read the echo of a command of length bytes, at most until the echo timeout
+    bool       readEcho(std::string &response, size_t length);
+
     bool enableThread_agcProcess_ = false;
     bool isSerialPortSet_         = false;
     bool isAGCQueueSet_           = false;
 
-    SystemInfo               systemInfo_;
-    SerialDriver            *serial_     = nullptr;
-    sfq::Safe_Queue<double> *agcDataque_ = nullptr;
+    SystemInfo                   systemInfo_;
+    SerialDriver                *serial_      = nullptr;
+    sfq::Safe_Queue<AgcRequest> *agcDataque_  = nullptr;
+    GainTracker                 *gainTracker_ = nullptr;
 
     // thread
     std::thread thread_agcProcess_;
@@ -63,6 +102,15 @@ private:
     double gainMin_       = 0.0;
     double gainMax_       = 0.0;
     double gainStep_      = 0.0;
+
+    // actuator state
+    int                echoTimeout_  = 20;
+    int                maxRetries_   = 2;
+    bool               isDACSet_     = false; // dacValue_ is known, false after a failed command
+    int                dacValue_     = 0;     // quantized value the DAC holds
+    double             latencySumUs_ = 0.0;
+    AgcActuatorStats   stats_;
+    mutable std::mutex statsMtx_;
 };
 
-#endif // _THREAD_AGC_H_
\ No newline at end of file
+#endif // _THREAD_AGC_H_
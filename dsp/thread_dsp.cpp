@@ -10,6 +10,51 @@
  */
 #include "thread_dsp.h"
 #include "../tool/ColorParse.h"
+#include "../tool/ThreadPolicy.h"
+#include <algorithm>
+
+namespace {
+// a result that also goes to a file queue is copied, otherwise the job gives it away
+template <typename T>
+void shareResult(T &product, T &result, bool isKept) {
+    if (isKept) {
+        product = result;
+    } else {
+        product = std::move(result);
+    }
+}
+
+// the gain of the job for the AGC thread, stamped now
+AgcRequest makeAgcRequest(const DSPPingJob &job) {
+    AgcRequest request;
+    request.seq  = job.seq;
+    request.gain = job.agcGain;
+    request.time = std::chrono::steady_clock::now();
+    return request;
+}
+
+// refer the amplitudes to the amplifier input
+void normalizeSignal(ChannelSignalVector &signal, double scale) {
+    if (scale == 1.0) {
+        return;
+    }
+    for (auto &channel : signal.channels) {
+        for (double &value : channel) {
+            value *= scale;
+        }
+    }
+}
+
+// a time in seconds on the steady clock
+std::chrono::steady_clock::duration toDuration(double time) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time));
+}
+
+// samples without an acquisition time are taken as acquired now
+std::chrono::steady_clock::time_point acquisitionTime(std::chrono::steady_clock::time_point time) {
+    return time == std::chrono::steady_clock::time_point() ? std::chrono::steady_clock::now() : time;
+}
+} // namespace
 
 ThreadDSP::ThreadDSP(SystemInfo &systeminfo, ChannelSignalVector &refSignal,
                      sfq::Safe_Queue<ChannelSignalVector> &dataque)
@@ -22,17 +67,55 @@ ThreadDSP::ThreadDSP(SystemInfo &systeminfo, ChannelSignalVector &refSignal,
 void ThreadDSP::init() {
     enableThread_dspProcess_ = true;
     signalProcess_           = new SignalProcess(systemInfo_, refSignal_);
+    doaProcess_              = new SignalProcess(systemInfo_, refSignal_);
+
+    // intra-ping parallelism, results are identical for any worker number
+    ThreadPolicyInfo &policy = systemInfo_.threadPolicyInfo;
+    threadPool_.reset(new ThreadPool(systemInfo_.dspPipelineInfo.workerNum, [&policy](int index) {
+        applyThreadPolicy("DSP Worker " + std::to_string(index), policy.dspWorker, policy.prefaultStackSize);
+    }));
+    signalProcess_->setThreadPool(threadPool_.get());
+    doaProcess_->setThreadPool(threadPool_.get());
+
+    // streaming mode: stage 1 takes fixed-size hops and detects the pings itself
+    if (systemInfo_.streamInfo.isEnable) {
+        int channelNum = systemInfo_.aiScanInfo.highChan - systemInfo_.aiScanInfo.lowChan + 1;
+        // the hops are band-passed as one continuous signal, the matched filter gets the band-passed reference
+        ChannelSignalVector streamRef = refSignal_;
+        if (systemInfo_.preFilterInfo.isEnable) {
+            streamPreFilter_.reset(new PreFilter(systemInfo_));
+            streamPreFilter_->setThreadPool(threadPool_.get());
+            streamPreFilter_->filterReference(streamRef);
+        }
+        streamTOF_.reset(new StreamTOF(systemInfo_, streamRef, channelNum));
+        streamTOF_->setThreadPool(threadPool_.get());
+    }
 
-    // init temp data
-    tofOutput_ = 0.0;
-    doaOutput_ = 0.0;
-    agcPower_  = 0.0;
+    // init pipeline
+    stageNum_             = systemInfo_.dspPipelineInfo.stageNum;
+    diagnosticDecimation_ = systemInfo_.savedFileInfo.diagnosticDecimation;
+    inputSeq_             = 0;
+    outputSeq_            = 0;
+    if (stageNum_ >= 2) {
+        tofToDOAQueue_.reset(new sfq::Bounded_Queue<DSPPingJob>(systemInfo_.dspPipelineInfo.queueDepth));
+    }
+    if (stageNum_ >= 3) {
+        doaToOutputQueue_.reset(new sfq::Bounded_Queue<DSPPingJob>(systemInfo_.dspPipelineInfo.queueDepth));
+    }
 }
 
 void ThreadDSP::creatThread_dspProcess() {
     if (enableThread_dspProcess_) {
+        // start the downstream stages first so the handoff queues always have a consumer
+        if (stageNum_ >= 3) {
+            thread_dspOutputProcess_ = std::thread(&ThreadDSP::dspOutputProcess, this);
+        }
+        if (stageNum_ >= 2) {
+            thread_dspDOAProcess_ = std::thread(&ThreadDSP::dspDOAProcess, this);
+        }
         thread_dspProcess_ = std::thread(&ThreadDSP::dspProcess, this);
-        std::cout << termColor("green") << "Thread DSP Process is created" << termColor("nocolor") << "\n";
+        std::cout << termColor("green") << "Thread DSP Process is created (" << stageNum_ << " stages)"
+                  << termColor("nocolor") << "\n";
     } else {
         std::cerr << termColor("red") << "Thread DSP Process is not created" << termColor("nocolor") << "\n";
         std::exit(EXIT_FAILURE);
@@ -44,77 +127,361 @@ void ThreadDSP::joinThread_dspProcess() {
         thread_dspProcess_.join();
         std::cout << termColor("green") << "Thread DSP Process is joined" << termColor("nocolor") << "\n";
     }
+    if (thread_dspDOAProcess_.joinable()) {
+        thread_dspDOAProcess_.join();
+    }
+    if (thread_dspOutputProcess_.joinable()) {
+        thread_dspOutputProcess_.join();
+    }
 }
 
 void ThreadDSP::closeThread_dspProcess() {
     enableThread_dspProcess_ = false;
+    // wake up the downstream stages, they drain the queued pings and exit
+    if (tofToDOAQueue_) {
+        tofToDOAQueue_->close();
+    }
+    if (doaToOutputQueue_) {
+        doaToOutputQueue_->close();
+    }
     joinThread_dspProcess();
     if (signalProcess_ != nullptr) {
         delete signalProcess_;
         signalProcess_ = nullptr;
     }
+    if (doaProcess_ != nullptr) {
+        delete doaProcess_;
+        doaProcess_ = nullptr;
+    }
 }
 
 void ThreadDSP::dspProcess() {
+    applyThreadPolicy("DSP TOF", systemInfo_.threadPolicyInfo.dspTOF, systemInfo_.threadPolicyInfo.prefaultStackSize);
     signalProcess_->loadRefSignal(refSignal_);
+    doaProcess_->loadRefSignal(refSignal_);
 
     while (enableThread_dspProcess_) {
+        if (streamTOF_) {
+            // one hop may complete zero, one or several pings
+            ChannelSignalVector hop = signalQueue_.wait_and_pop();
+            AgcMeasurement hopMeasurement;
+            detectSaturation(hop, systemInfo_.agcInfo.saturationLevel, hopMeasurement);
+            streamSaturation_.push_back({streamSampleNum_, streamSampleNum_ + hop.signalLength,
+                                         hopMeasurement.clippedNum, hopMeasurement.rawPeak});
+            if (streamSaturation_.size() > SATURATION_HOPS) {
+                streamSaturation_.pop_front();
+            }
+            if (streamPreFilter_ && productQueue_ != nullptr) {
+                streamRawHops_.emplace_back(streamSampleNum_, hop);
+            }
+            streamSampleNum_ += hop.signalLength;
+            streamTime_      = acquisitionTime(hop.time);
+            if (streamPreFilter_) {
+                streamPreFilter_->process(hop);
+            }
+            streamTOF_->process(hop, streamDetections_);
+            for (auto &detection : streamDetections_) {
+                DSPPingJob job;
+                job.seq          = inputSeq_++;
+                job.isDiagnostic = isDiagnosticPing(job.seq);
+                job.products     = productDemand_ ? productDemand_(job.seq) : 0;
+                processStreamTOF(job, detection);
+                if (!dispatchJob(job)) {
+                    return;
+                }
+            }
+            while (!streamRawHops_.empty() &&
+                   streamRawHops_.front().first + streamRawHops_.front().second.signalLength <=
+                       streamTOF_->historyIndex()) {
+                streamRawHops_.pop_front();
+            }
+            continue;
+        }
+
+        DSPPingJob job;
         // get the signal from the queue
-        signalInput_ = signalQueue_.wait_and_pop();
-        // update the signal
-        signalProcess_->updateInputSignal(signalInput_);
-        // process the signal: TOF
-        tofOutput_ = signalProcess_->calculateTOF();
-        // process the signal: DOA
-        doaOutput_ = signalProcess_->calculateDOA();
-        // update the ACG
-        agcPower_ = signalProcess_->updateACG();
-
-        std::cout << "\n TOF: " << tofOutput_ << "\n DOA: " << doaOutput_ << "\n AGC: " << agcPower_ << std::endl;
-
-        // save the result
-        positionResult_.tof = tofOutput_;
-        positionResult_.doa = doaOutput_;
-        signalProcess_->getTOFResult(tofResult_);
-        signalProcess_->getBeamPattern(beamPattern_);
-        signalProcess_->getCorrelationResult(correlationResult_);
-        signalProcess_->getSignalSideAmpSpec(signalSideAmpSpec_);
-
-        // reset the process flag
-        signalProcess_->resetFlag();
-
-        // save the result to the output queue
-        if (posResQueue_ != nullptr) {
-            posResQueue_->push(positionResult_);
+        job.signal       = signalQueue_.wait_and_pop();
+        job.seq          = inputSeq_++;
+        job.isDiagnostic = isDiagnosticPing(job.seq);
+        job.products     = productDemand_ ? productDemand_(job.seq) : 0;
+
+        processTOF(job);
+        if (!dispatchJob(job)) {
+            break;
         }
-        if (acgQueue_ != nullptr) {
-            acgQueue_->push(agcPower_);
+    }
+}
+
+bool ThreadDSP::dispatchJob(DSPPingJob &job) {
+    if (stageNum_ >= 2) {
+        // hand over to the DOA stage, blocks if the DOA stage falls behind
+        return tofToDOAQueue_->push(std::move(job));
+    }
+    processDOA(job);
+    processOutput(job);
+    return true;
+}
+
+bool ThreadDSP::isDiagnosticPing(uint64_t seq) const {
+    bool isSubscribed = signalTOFQueue_ != nullptr || signalCorrelationQueue_ != nullptr ||
+                        signalSideAmpSpecQueue_ != nullptr || beamPatternQueue_ != nullptr;
+    return isSubscribed && seq % static_cast<uint64_t>(diagnosticDecimation_) == 0;
+}
+
+void ThreadDSP::dspDOAProcess() {
+    applyThreadPolicy("DSP DOA", systemInfo_.threadPolicyInfo.dspDOA, systemInfo_.threadPolicyInfo.prefaultStackSize);
+    DSPPingJob job;
+    while (tofToDOAQueue_->wait_and_pop(job)) {
+        processDOA(job);
+        if (stageNum_ >= 3) {
+            if (!doaToOutputQueue_->push(std::move(job))) {
+                break;
+            }
+            continue;
         }
-        if (signalTOFQueue_ != nullptr) {
-            signalTOFQueue_->push(tofResult_);
+        processOutput(job);
+    }
+}
+
+void ThreadDSP::dspOutputProcess() {
+    applyThreadPolicy("DSP Output", systemInfo_.threadPolicyInfo.dspOutput,
+                      systemInfo_.threadPolicyInfo.prefaultStackSize);
+    DSPPingJob job;
+    while (doaToOutputQueue_->wait_and_pop(job)) {
+        processOutput(job);
+    }
+}
+
+void ThreadDSP::processTOF(DSPPingJob &job) {
+    std::chrono::steady_clock::time_point end    = acquisitionTime(job.signal.time);
+    int                                   length = job.signal.signalLength;
+    // the raw samples clip at the ADC, before the band-pass of calculateTOF()
+    AgcMeasurement measurement;
+    detectSaturation(job.signal, systemInfo_.agcInfo.saturationLevel, measurement);
+    // the pre-filter band-passes the signal in place, the raw product keeps the samples before it
+    if ((job.products & PRODUCT_RAW) && systemInfo_.preFilterInfo.isEnable) {
+        job.rawSignal = job.signal;
+    }
+    // update the signal
+    signalProcess_->updateInputSignal(std::move(job.signal));
+    // process the signal: TOF
+    job.tof = signalProcess_->calculateTOF();
+    // update the ACG
+    processAGC(job, measurement, end, length);
+    signalProcess_->getTOFResult(job.tofResult);
+    if ((job.isDiagnostic && signalCorrelationQueue_ != nullptr) || (job.products & PRODUCT_CORRELATION)) {
+        signalProcess_->releaseCorrelationResult(job.correlationResult);
+        normalizeSignal(job.correlationResult, job.gainTag.scale);
+    }
+    // the signal and its baseband go on to the DOA stage
+    signalProcess_->releaseBasebandSignal(job.baseband);
+    signalProcess_->releaseInputSignal(job.signal);
+    // reset the process flag
+    signalProcess_->resetFlag();
+
+    // the gain is sent as soon as it is known, not delayed by the DOA stage
+    if (acgQueue_ != nullptr) {
+        acgQueue_->push(makeAgcRequest(job));
+    }
+}
+
+void ThreadDSP::processStreamTOF(DSPPingJob &job, StreamDetection &detection) {
+    job.sampleIndex = detection.startIndex;
+    job.tof         = *std::min_element(detection.tof.begin(), detection.tof.end());
+    // the DOA stage and the AGC work on the detection window, so they get the TOF relative to it
+    job.tofResult = detection.windowTOF;
+    // the window ends this many samples before the last sample of the hops
+    int      length    = detection.signal.signalLength;
+    uint64_t windowEnd = detection.startIndex + length;
+    double   age = (streamSampleNum_ - std::min(windowEnd, streamSampleNum_)) / systemInfo_.signalInfo.sampleRate;
+    std::chrono::steady_clock::time_point end = streamTime_ - toDuration(age);
+    // the hops are band-passed before the detection, the saturation is that of the raw hops the window overlaps
+    AgcMeasurement measurement;
+    for (const HopSaturation &hop : streamSaturation_) {
+        if (hop.endIndex > detection.startIndex && hop.startIndex < windowEnd) {
+            measurement.clippedNum += hop.clippedNum;
+            measurement.rawPeak = std::max(measurement.rawPeak, hop.rawPeak);
+        }
+    }
+    if ((job.products & PRODUCT_RAW) && !streamRawHops_.empty()) {
+        extractRawWindow(detection.startIndex, length, job.rawSignal);
+    }
+    signalProcess_->updateInputSignal(std::move(detection.signal));
+    signalProcess_->loadTOFResult(job.tofResult, std::move(detection.correlation));
+    processAGC(job, measurement, end, length);
+    if ((job.isDiagnostic && signalCorrelationQueue_ != nullptr) || (job.products & PRODUCT_CORRELATION)) {
+        signalProcess_->releaseCorrelationResult(job.correlationResult);
+        normalizeSignal(job.correlationResult, job.gainTag.scale);
+    }
+    signalProcess_->releaseInputSignal(job.signal);
+    signalProcess_->resetFlag();
+
+    if (acgQueue_ != nullptr) {
+        acgQueue_->push(makeAgcRequest(job));
+    }
+}
+
+void ThreadDSP::processAGC(DSPPingJob &job, AgcMeasurement &measurement, std::chrono::steady_clock::time_point end,
+                           int length) {
+    measurement.time = std::chrono::duration<double>(end.time_since_epoch()).count();
+    measurement.tof  = job.tof;
+    if (gainTracker_ != nullptr) {
+        measurement.gainTag = gainTracker_->tagAt(end - toDuration(length / systemInfo_.signalInfo.sampleRate), end);
+    }
+    job.agcGain       = signalProcess_->updateACG(measurement);
+    job.gainTag       = measurement.gainTag;
+    job.peakAmplitude = measurement.peakPower;
+}
+
+bool ThreadDSP::extractRawWindow(uint64_t start, int length, ChannelSignalVector &raw) const {
+    uint64_t end = start + length;
+    if (streamRawHops_.empty() || streamRawHops_.front().first > start ||
+        streamRawHops_.back().first + streamRawHops_.back().second.signalLength < end) {
+        return false;
+    }
+    raw.resize(streamRawHops_.front().second.channelNum, length);
+    for (const auto &entry : streamRawHops_) {
+        const ChannelSignalVector &hop      = entry.second;
+        uint64_t                   hopStart = entry.first;
+        uint64_t                   hopEnd   = hopStart + hop.signalLength;
+        if (hopEnd <= start || hopStart >= end) {
+            continue;
         }
-        if (signalCorrelationQueue_ != nullptr) {
-            signalCorrelationQueue_->push(correlationResult_);
+        uint64_t from = std::max(start, hopStart);
+        uint64_t to   = std::min(end, hopEnd);
+        for (int ch = 0; ch < raw.channelNum; ++ch) {
+            std::copy(hop.channels[ch].begin() + (from - hopStart), hop.channels[ch].begin() + (to - hopStart),
+                      raw.channels[ch].begin() + (from - start));
         }
-        if (signalSideAmpSpecQueue_ != nullptr) {
-            signalSideAmpSpecQueue_->push(signalSideAmpSpec_);
+    }
+    return true;
+}
+
+void ThreadDSP::processDOA(DSPPingJob &job) {
+    doaProcess_->updateInputSignal(std::move(job.signal));
+    if (job.baseband.isInit) {
+        doaProcess_->loadBasebandSignal(std::move(job.baseband));
+    }
+    doaProcess_->loadTOFResult(job.tofResult);
+    // the full spectrum is only computed for the pings that save or publish it
+    bool isSideAmpSpec =
+        (job.isDiagnostic && signalSideAmpSpecQueue_ != nullptr) || (job.products & PRODUCT_SIDE_AMP_SPEC);
+    doaProcess_->setSideAmpSpecEnable(isSideAmpSpec);
+    // process the signal: DOA
+    job.doa = doaProcess_->calculateDOA();
+    if ((job.isDiagnostic && beamPatternQueue_ != nullptr) || (job.products & PRODUCT_BEAM_PATTERN)) {
+        doaProcess_->getBeamPattern(job.beamPattern);
+    }
+    if (isSideAmpSpec) {
+        doaProcess_->getSignalSideAmpSpec(job.signalSideAmpSpec);
+    }
+    // the signal is only needed by the output stage when it is published as it is
+    doaProcess_->releaseInputSignal(job.signal);
+    if (!(job.products & PRODUCT_RAW) || job.rawSignal.isInit) {
+        job.signal = ChannelSignalVector();
+    }
+    // reset the process flag
+    doaProcess_->resetFlag();
+}
+
+void ThreadDSP::processOutput(DSPPingJob &job) {
+    if (job.seq != outputSeq_) {
+        std::cerr << termColor("red") << "ThreadDSP: ping " << job.seq << " is out of order, expected " << outputSeq_
+                  << termColor("nocolor") << std::endl;
+        outOfOrderNum_++;
+    }
+    outputSeq_ = job.seq + 1;
+    outputNum_++;
+
+    if (streamTOF_) {
+        std::cout << "\n Sample: " << job.sampleIndex;
+    }
+    std::cout << "\n TOF: " << job.tof << "\n DOA: " << job.doa << "\n AGC: " << job.agcGain << std::endl;
+
+    // save the result to the output queue, publish it on the network
+    if (posResQueue_ != nullptr || publishPosResQueue_ != nullptr) {
+        PositionResult positionResult = PositionResult(); // time and position are not known here, zero
+        positionResult.seq            = job.seq;
+        positionResult.sampleIndex    = job.sampleIndex;
+        positionResult.tof            = job.tof;
+        positionResult.doa            = job.doa;
+        positionResult.agcGain        = job.agcGain;
+        positionResult.gainTag        = job.gainTag;
+        positionResult.peakAmplitude  = job.peakAmplitude;
+        positionResult.normalizedPeak = job.peakAmplitude * job.gainTag.scale;
+        if (publishPosResQueue_ != nullptr) {
+            publishPosResQueue_->push(positionResult);
         }
-        if (beamPatternQueue_ != nullptr) {
-            // test for relative beam pattern
-            // beamPattern_.array() /= beamPattern_.maxCoeff();
-            beamPatternQueue_->push(beamPattern_);
+        if (posResQueue_ != nullptr) {
+            posResQueue_->push(positionResult);
         }
     }
+    if (productQueue_ != nullptr && job.products != 0) {
+        publishProducts(job);
+    }
+    // the diagnostics are moved, the job is not used afterwards
+    if (!job.isDiagnostic) {
+        return;
+    }
+    if (signalTOFQueue_ != nullptr) {
+        signalTOFQueue_->push(std::move(job.tofResult));
+    }
+    if (signalCorrelationQueue_ != nullptr) {
+        signalCorrelationQueue_->push(std::move(job.correlationResult));
+    }
+    if (signalSideAmpSpecQueue_ != nullptr) {
+        signalSideAmpSpecQueue_->push(std::move(job.signalSideAmpSpec));
+    }
+    if (beamPatternQueue_ != nullptr) {
+        // test for relative beam pattern
+        // beamPattern_.array() /= beamPattern_.maxCoeff();
+        beamPatternQueue_->push(std::move(job.beamPattern));
+    }
+}
+
+void ThreadDSP::publishProducts(DSPPingJob &job) {
+    std::shared_ptr<PingProducts> products = std::make_shared<PingProducts>();
+    products->products                     = job.products;
+    products->seq                          = job.seq;
+    products->sampleIndex                  = job.sampleIndex;
+    products->sampleRate                   = systemInfo_.signalInfo.sampleRate;
+    products->tof                          = job.tof;
+    products->doa                          = job.doa;
+    products->gainTag                      = job.gainTag;
+    products->tofResult                    = job.tofResult;
+
+    bool isSaved = job.isDiagnostic;
+    if (job.products & PRODUCT_RAW) {
+        products->signal = job.rawSignal.isInit ? std::move(job.rawSignal) : std::move(job.signal);
+    }
+    if (job.products & PRODUCT_CORRELATION) {
+        shareResult(products->correlation, job.correlationResult, isSaved && signalCorrelationQueue_ != nullptr);
+    }
+    if (job.products & PRODUCT_SIDE_AMP_SPEC) {
+        shareResult(products->sideAmpSpec, job.signalSideAmpSpec, isSaved && signalSideAmpSpecQueue_ != nullptr);
+    }
+    if (job.products & PRODUCT_BEAM_PATTERN) {
+        shareResult(products->beamPattern, job.beamPattern, isSaved && beamPatternQueue_ != nullptr);
+    }
+    productQueue_->push(std::move(products));
 }
 
 void ThreadDSP::setPosResQueue(sfq::Safe_Queue<PositionResult> *posResQueue) {
     posResQueue_ = posResQueue;
 }
 
-void ThreadDSP::setAGCQueue(sfq::Safe_Queue<double> *acgQueue) {
+void ThreadDSP::setPublishPosResQueue(sfq::Safe_Queue<PositionResult> *publishPosResQueue) {
+    publishPosResQueue_ = publishPosResQueue;
+}
+
+void ThreadDSP::setAGCQueue(sfq::Safe_Queue<AgcRequest> *acgQueue) {
     acgQueue_ = acgQueue;
 }
 
+void ThreadDSP::setGainTracker(const GainTracker *gainTracker) {
+    gainTracker_ = gainTracker;
+}
+
 void ThreadDSP::setSignalTOFQueue(sfq::Safe_Queue<std::vector<double>> *signalTOFQueue) {
     signalTOFQueue_ = signalTOFQueue;
 }
@@ -130,3 +497,9 @@ void ThreadDSP::setSignalSideAmpSpecQueue(sfq::Safe_Queue<ChannelSignalVector> *
 void ThreadDSP::setBeamPatternQueue(sfq::Safe_Queue<Eigen::MatrixXd> *beamPatternQueue) {
     beamPatternQueue_ = beamPatternQueue;
 }
+
+void ThreadDSP::setProductQueue(sfq::Safe_Queue<std::shared_ptr<const PingProducts>> *productQueue,
+                                ProductDemand                                         demand) {
+    productQueue_  = productQueue;
+    productDemand_ = std::move(demand);
+}
@@ -11,11 +11,59 @@
 #ifndef _THREAD_DSP_H_
 #define _THREAD_DSP_H_
 
+#include "../tool/BoundedQueue.hpp"
 #include "../tool/SafeQueue.hpp"
+#include "../tool/ThreadPool.h"
+#include "gainTracker.h"
 #include "signalProcess.h"
+#include "streamTof.h"
+#include <atomic>
 #include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <thread>
+#include <utility>
 
+// one ping travelling through the DSP pipeline stages
+typedef struct DSPPingJob {
+    uint64_t            seq           = 0;
+    uint64_t            sampleIndex   = 0;     // absolute sample index of signal[0] in streaming mode
+    bool                isDiagnostic  = false; // whether the diagnostics of this ping are produced
+    uint32_t            products      = 0;     // PING_PRODUCT bits published for this ping (product queue)
+    double              tof           = 0.0;
+    double              doa           = 0.0;
+    double              agcGain       = 0.0;
+    double              peakAmplitude = 0.0;   // correlation peak, as received
+    GainTag             gainTag;               // gain in effect while the ping was acquired
+    ChannelSignalVector signal;
+    ChannelSignalVector rawSignal; // PRODUCT_RAW with the pre-filter on: the samples before the band-pass
+    BasebandSignal      baseband;  // signal after the decimating front-end, empty when it is disabled
+    std::vector<double> tofResult;
+    ChannelSignalVector correlationResult;
+    ChannelSignalVector signalSideAmpSpec;
+    Eigen::MatrixXd     beamPattern;
+} DSPPingJob;
+
+/***
+ * @description: DSP pipeline, split into three stages which run on 1~3 threads ([DSPPipeline] in the config)
+ * stage 1: matched filter (TOF) and AGC update
+ * stage 2: beamforming (DOA)
+ * stage 3: result fan-out to the output queues
+ * Stages are connected by bounded queues, so TOF of ping N+1 overlaps with DOA of ping N.
+ * Every stage is a single thread and the queues are FIFO, so pings leave in sequence number order.
+ * In streaming mode ([Stream] in the config) stage 1 takes hops instead of pings, band-passes them when the
+ * pre-filter is enabled ([PreFilter]), runs the overlap-save matched filter and starts one job per detected ping.
+ * The diagnostics (TOF of each channel, correlation, beam pattern, side amplitude spectrum) are only produced for
+ * output queues that are set, and only every [File][diagnosticDecimation] pings, they are moved into the queues.
+ * The product queue (TCP subscriptions) gets the products its demand function asks for, ping by ping, as one shared
+ * PingProducts; a product that is saved to a file as well is copied, otherwise it is moved. PRODUCT_RAW is the input
+ * before the pre-filter: a copy is kept for the pings that publish it (cut from the raw hops in streaming mode).
+ * With a gain tracker set, stage 1 tags every ping with the receive gain in effect while it was acquired (by the
+ * acquisition time of its samples) and the correlation it publishes and saves is normalized to the amplifier input,
+ * so its amplitudes are comparable across pings whatever the AGC did in between; the AGC still decides on the
+ * correlation as received.
+ */
 class ThreadDSP {
 public:
     explicit ThreadDSP(SystemInfo &systeminfo, ChannelSignalVector &refSignal,
@@ -31,14 +79,22 @@ public:
     // close thread for dsp process
     void closeThread_dspProcess();
 
-    // dsp process function
+    // dsp process function (stage 1, runs the following stages too if they have no thread of their own)
     void dspProcess();
+    // dsp stage 2 thread function
+    void dspDOAProcess();
+    // dsp stage 3 thread function
+    void dspOutputProcess();
 
     // set output queue
     // set position result queue
     void setPosResQueue(sfq::Safe_Queue<PositionResult> *posResQueue);
+    // set position result queue of the network publisher (UDP multicast), fed before the position result queue
+    void setPublishPosResQueue(sfq::Safe_Queue<PositionResult> *publishPosResQueue);
     // set AGC power queue
-    void setAGCQueue(sfq::Safe_Queue<double> *acgQueue);
+    void setAGCQueue(sfq::Safe_Queue<AgcRequest> *acgQueue);
+    // set the gain history of the AGC thread, called before the thread is created
+    void setGainTracker(const GainTracker *gainTracker);
     // set signal TOF result output queue
     void setSignalTOFQueue(sfq::Safe_Queue<std::vector<double>> *signalTOFQueue);
     // set signal correlation result output queue
@@ -48,36 +104,99 @@ public:
     // set beam pattern output queue
     void setBeamPatternQueue(sfq::Safe_Queue<Eigen::MatrixXd> *beamPatternQueue);
 
+    // PING_PRODUCT bits wanted for the ping with this sequence number, 0 skips the ping
+    typedef std::function<uint32_t(uint64_t seq)> ProductDemand;
+    /***
+     * @description: Set the product output queue, called before the thread is created
+     * @param {Safe_Queue<std::shared_ptr<const PingProducts>>} *productQueue
+     * @param {ProductDemand} demand    Asked once per ping in stage 1, the products are only computed when asked
+     * @return {*}
+     */
+    void setProductQueue(sfq::Safe_Queue<std::shared_ptr<const PingProducts>> *productQueue, ProductDemand demand);
+
+    // pings that left the pipeline, and those of them that left out of order (telemetry, any thread)
+    uint64_t getOutputNum() const { return outputNum_.load(std::memory_order_relaxed); }
+    uint64_t getOutOfOrderNum() const { return outOfOrderNum_.load(std::memory_order_relaxed); }
+
 private:
+    // stage bodies
+    void processTOF(DSPPingJob &job);
+    void processStreamTOF(DSPPingJob &job, StreamDetection &detection);
+    void processDOA(DSPPingJob &job);
+    void processOutput(DSPPingJob &job);
+    // tag the job with the gain in effect while its samples (length, the last one at end) were acquired, then let the
+    // AGC controller derive the gain of the next ping (measurement holds the saturation of the raw samples)
+    void processAGC(DSPPingJob &job, AgcMeasurement &measurement, std::chrono::steady_clock::time_point end,
+                    int length);
+    // samples [start, start + length) of the raw hops, false when they are no longer held
+    bool extractRawWindow(uint64_t start, int length, ChannelSignalVector &raw) const;
+    // share the products of the job with the product queue
+    void publishProducts(DSPPingJob &job);
+    // hand a job from stage 1 to the next stage (or run the rest inline), false once the pipeline is closed
+    bool dispatchJob(DSPPingJob &job);
+    // whether the diagnostics of the ping with this sequence number are produced
+    bool isDiagnosticPing(uint64_t seq) const;
+
     SystemInfo                           &systemInfo_;
     ChannelSignalVector                  &refSignal_;
     sfq::Safe_Queue<ChannelSignalVector> &signalQueue_;
 
-    // process object
+    // process object (one per stage, the FFT engines are not shared between threads)
     SignalProcess *signalProcess_;
+    SignalProcess *doaProcess_;
+
+    // workers shared by the TOF and DOA kernels of all stages
+    std::unique_ptr<ThreadPool> threadPool_;
+
+    // streaming matched filter, only created in streaming mode
+    std::unique_ptr<StreamTOF>   streamTOF_;
+    std::unique_ptr<PreFilter>   streamPreFilter_; // band-pass of the hops, keeps its state from one hop to the next
+    std::vector<StreamDetection> streamDetections_;
+    // samples of the hops so far and the acquisition time of the last of them, dates the detections
+    uint64_t                              streamSampleNum_ = 0;
+    std::chrono::steady_clock::time_point streamTime_;
+    // clipped samples of the last raw hops (before the band-pass), for the saturation of the detections
+    struct HopSaturation {
+        uint64_t startIndex;
+        uint64_t endIndex;
+        int      clippedNum;
+        double   rawPeak;
+    };
+    std::deque<HopSaturation> streamSaturation_;
+    static const size_t       SATURATION_HOPS = 64;
+    // raw hops (absolute index of their first sample) while the pre-filter is on and products are published, they
+    // span the sample history of the stream matched filter
+    std::deque<std::pair<uint64_t, ChannelSignalVector>> streamRawHops_;
 
-    // process temp data
-    ChannelSignalVector signalInput_;
-    double              tofOutput_;
-    double              doaOutput_;
-    PositionResult      positionResult_;
-    double              agcPower_;
-    std::vector<double> tofResult_;
-    ChannelSignalVector correlationResult_;
-    ChannelSignalVector signalSideAmpSpec_;
-    Eigen::MatrixXd     beamPattern_;
+    // pipeline
+    int                                             stageNum_;
+    int                                             diagnosticDecimation_;
+    uint64_t                                        inputSeq_;
+    uint64_t                                        outputSeq_;
+    std::atomic<uint64_t>                           outputNum_{0};
+    std::atomic<uint64_t>                           outOfOrderNum_{0};
+    std::unique_ptr<sfq::Bounded_Queue<DSPPingJob>> tofToDOAQueue_;
+    std::unique_ptr<sfq::Bounded_Queue<DSPPingJob>> doaToOutputQueue_;
 
     // thread
     std::thread thread_dspProcess_;
+    std::thread thread_dspDOAProcess_;
+    std::thread thread_dspOutputProcess_;
 
     // output queue
     sfq::Safe_Queue<PositionResult>      *posResQueue_            = nullptr;
-    sfq::Safe_Queue<double>              *acgQueue_               = nullptr;
+    sfq::Safe_Queue<PositionResult>      *publishPosResQueue_     = nullptr;
+    sfq::Safe_Queue<AgcRequest>          *acgQueue_               = nullptr;
     sfq::Safe_Queue<std::vector<double>> *signalTOFQueue_         = nullptr;
     sfq::Safe_Queue<ChannelSignalVector> *signalCorrelationQueue_ = nullptr;
     sfq::Safe_Queue<ChannelSignalVector> *signalSideAmpSpecQueue_ = nullptr;
     sfq::Safe_Queue<Eigen::MatrixXd>     *beamPatternQueue_       = nullptr;
 
+    sfq::Safe_Queue<std::shared_ptr<const PingProducts>> *productQueue_ = nullptr;
+    ProductDemand                                         productDemand_;
+
+    const GainTracker *gainTracker_ = nullptr;
+
     // status flag
     bool enableThread_dspProcess_ = false;
 };
@@ -11,55 +11,72 @@
 
 #include "tof.h"
 #include <algorithm>
+#include <cmath>
 
-TOF::TOF(SystemInfo &systeminfo, ChannelSignalVector &refSignal)
+namespace {
+// sub-sample offset of a smooth peak, from a parabola through its neighbours
+double peakOffset(const std::vector<double> &y, int index) {
+    if (index <= 0 || index + 1 >= static_cast<int>(y.size())) {
+        return 0.0;
+    }
+    double left  = y[index - 1];
+    double right = y[index + 1];
+    double curve = left - 2 * y[index] + right;
+    return curve < 0 ? 0.5 * (left - right) / curve : 0.0;
+}
+} // namespace
+
+template <typename T>
+TOFT<T>::TOFT(SystemInfo &systeminfo, ChannelSignalVector &refSignal)
     : SignalBase(systeminfo) {
     refSignal_       = refSignal;
     refSignalLength_ = refSignal_.signalLength;
     init();
 }
 
-TOF::TOF(SystemInfo &systeminfo, ChannelSignalEigenD &refSignal)
+template <typename T>
+TOFT<T>::TOFT(SystemInfo &systeminfo, ChannelSignalEigenD &refSignal)
     : SignalBase(systeminfo)
     , refSignalLength_(refSignal.signalLength)
     , refSignalEigenD_(refSignal) {
     init();
 }
 
-void TOF::init() {
+template <typename T>
+void TOFT<T>::init() {
     maxIndex_.clear();
     maxIndex_.resize(systemInfo_.arrayInfo.arrayNum);
 }
 
-void TOF::calculateTOF(ChannelSignalVector &signal, std::vector<double> &tof) {
+template <typename T>
+void TOFT<T>::calculateTOF(ChannelSignalVector &signal, std::vector<double> &tof) {
     if (!signal.isInit) {
         throw std::runtime_error("TOF::calculateTOF: signal is not initialized");
     }
 
     // resize the tof vector
     tof.resize(signal.channelNum);
-
-    // flip the reference signal
-    ChannelSignalVector refSiganl_fliplr = refSignal_;
-    std::reverse(refSiganl_fliplr.channels[0].begin(), refSiganl_fliplr.channels[0].end());
+    maxIndex_.resize(signal.channelNum);
 
     // matching filter
     ChannelSignalVector signal_conv;
-    csvconv_valid(signal, refSiganl_fliplr, signal_conv);
+    matchedFilter(signal, signal_conv);
 
-    // find the max value
+    // find the max value, refined between the samples on the envelope (the real correlation oscillates at the carrier)
+    bool isEnvelope = systemInfo_.signalProcessInfo.isEnvelopeEnable;
+    findPeaks(signal_conv, systemInfo_.signalInfo.sampleRate, isEnvelope);
     for (int i = 0; i < signal.channelNum; ++i) {
-        maxIndex_[i] = std::max_element(signal_conv.channels[i].begin(), signal_conv.channels[i].end()) -
-                       signal_conv.channels[i].begin();
+        double offset = isEnvelope ? peakOffset(signal_conv.channels[i], maxIndex_[i]) : 0.0;
         // tof[i] = (double) maxIndex_[i] / systemInfo_.signalInfo.sampleRate;
-        tof[i] = (double) maxIndex_[i] / systemInfo_.signalProcessInfo.referenceSignalFrequency;
+        tof[i] = (maxIndex_[i] + offset) / systemInfo_.signalProcessInfo.referenceSignalFrequency;
     }
 
     // save the correlation result
-    correlationResult_ = signal_conv;
+    correlationResult_ = std::move(signal_conv);
 }
 
-void TOF::calculateTOF(ChannelSignalEigenD &signal, std::vector<double> &tof) {
+template <typename T>
+void TOFT<T>::calculateTOF(ChannelSignalEigenD &signal, std::vector<double> &tof) {
     if (!signal.isInit) {
         throw std::runtime_error("TOF::calculateTOF: signal is not initialized");
     }
@@ -90,4 +107,243 @@ void TOF::calculateTOF(ChannelSignalEigenD &signal, std::vector<double> &tof) {
 
     // save the correlation result
     csed2csv(signal_conv, correlationResult_);
-}
\ No newline at end of file
+}
+
+template <typename T>
+void TOFT<T>::setBasebandReference(const BasebandSignal &refSignal) {
+    if (!refSignal.isInit || refSignal.channelNum != 1 || refSignal.signalLength == 0) {
+        throw std::runtime_error("TOF::setBasebandReference: reference signal must be initialized with 1 channel");
+    }
+    refBaseband_ = refSignal;
+    fftEngines_.clear();
+}
+
+template <typename T>
+void TOFT<T>::calculateTOF(const BasebandSignal &signal, std::vector<double> &tof) {
+    if (!signal.isInit) {
+        throw std::runtime_error("TOF::calculateTOF: signal is not initialized");
+    }
+
+    tof.resize(signal.channelNum);
+    maxIndex_.resize(signal.channelNum);
+
+    ChannelSignalVector signal_conv;
+    matchedFilter(signal, signal_conv);
+
+    findPeaks(signal_conv, signal.sampleRate, true);
+    for (int i = 0; i < signal.channelNum; ++i) {
+        // the envelope is smooth at the baseband rate, a parabola through the neighbours recovers the sub-sample peak
+        tof[i] = (maxIndex_[i] + peakOffset(signal_conv.channels[i], maxIndex_[i])) / signal.sampleRate;
+    }
+
+    correlationResult_ = std::move(signal_conv);
+}
+
+template <typename T>
+void TOFT<T>::findPeaks(const ChannelSignalVector &correlation, double sampleRate, bool isEnvelope) {
+    int channelNum = correlation.channelNum;
+    int length     = correlation.signalLength;
+    maxIndex_.resize(channelNum);
+    if (systemInfo_.signalProcessInfo.tofMethod != TOF_COMBINED || channelNum < 2) {
+        for (int ch = 0; ch < channelNum; ++ch) {
+            const std::vector<double> &y = correlation.channels[ch];
+            maxIndex_[ch]                = std::max_element(y.begin(), y.end()) - y.begin();
+        }
+        return;
+    }
+
+    // energy summed over the channels, the carrier phase differs between the elements so the real correlation is not
+    // summed coherently. Each channel is scaled to a unit mean energy first, a noisy channel does not outweigh the rest
+    combined_.assign(length, 0.0);
+    for (int ch = 0; ch < channelNum; ++ch) {
+        const double *y      = correlation.channels[ch].data();
+        double        energy = 0;
+        for (int i = 0; i < length; ++i) {
+            energy += y[i] * y[i];
+        }
+        if (energy <= 0) {
+            continue;
+        }
+        double weight = length / energy;
+        for (int i = 0; i < length; ++i) {
+            combined_[i] += weight * y[i] * y[i];
+        }
+    }
+    int peak = std::max_element(combined_.begin(), combined_.end()) - combined_.begin();
+
+    // the envelope is much wider than the array, the combined peak is the arrival at the array center and every
+    // channel peak is within half the aperture delay of it; the real correlation may also peak half a carrier cycle off
+    const SignalProcessInfo &info      = systemInfo_.signalProcessInfo;
+    double                   aperture  = systemInfo_.arrayInfo.arrayDiameter / info.soundSpeed * sampleRate;
+    double                   margin    = isEnvelope ? 2.0 : 0.5 * sampleRate / info.startFrequency + 1.0;
+    int                      halfWidth = static_cast<int>(std::ceil(0.5 * aperture + margin));
+    int                      begin     = std::max(peak - halfWidth, 0);
+    int                      end       = std::min(peak + halfWidth + 1, length);
+    for (int ch = 0; ch < channelNum; ++ch) {
+        const std::vector<double> &y = correlation.channels[ch];
+        maxIndex_[ch]                = std::max_element(y.begin() + begin, y.begin() + end) - y.begin();
+        // a maximum on the window edge is no peak of this channel (buried in noise), it keeps the combined one
+        if ((maxIndex_[ch] == begin && begin > 0) || (maxIndex_[ch] == end - 1 && end < length)) {
+            maxIndex_[ch] = peak;
+        }
+    }
+}
+
+template <typename T>
+void TOFT<T>::updateRefSpectrum(int fftLength, int channelNum, bool isBaseband) {
+    fftEngines_.clear();
+    for (int ch = 0; ch < channelNum; ++ch) {
+        fftEngines_.emplace_back(new FFTEngine<T>(fftLength));
+    }
+
+    // spectrum of the flipped reference signal, zero padded to the FFT length
+    FFTEngine<T>    &engine = *fftEngines_[0];
+    std::complex<T> *buffer = engine.data();
+    std::fill(buffer, buffer + fftLength, std::complex<T>(0, 0));
+    if (isBaseband) {
+        // conjugated as well, the correlation of complex signals
+        const std::vector<std::complex<double>> &ref = refBaseband_.channels[0];
+        for (int i = 0; i < refBaseband_.signalLength; ++i) {
+            buffer[i] = std::conj(std::complex<T>(ref[refBaseband_.signalLength - 1 - i]));
+        }
+    } else {
+        for (int i = 0; i < refSignalLength_; ++i) {
+            buffer[i] = std::complex<T>(static_cast<T>(refSignal_.channels[0][refSignalLength_ - 1 - i]), 0);
+        }
+    }
+    engine.forward();
+    refSpectrum_.assign(buffer, buffer + fftLength);
+    isBasebandSpectrum_ = isBaseband;
+}
+
+template <typename T>
+void TOFT<T>::matchedFilter(const ChannelSignalVector &signal, ChannelSignalVector &output) {
+    if (!refSignal_.isInit || refSignal_.channelNum != 1 ||
+        static_cast<int>(refSignal_.channels[0].size()) != refSignalLength_) {
+        throw std::runtime_error("TOF::matchedFilter: reference signal must be 1 channel of signalLength samples");
+    }
+    if (signal.signalLength < refSignalLength_ || refSignalLength_ == 0) {
+        throw std::invalid_argument("TOF::matchedFilter: invalid signal length");
+    }
+
+    // padded full convolution length, the valid part starts at refSignalLength_ - 1
+    int fftLength    = fftGoodSize(signal.signalLength + refSignalLength_ - 1);
+    int outputLength = signal.signalLength - refSignalLength_ + 1;
+    if (static_cast<int>(fftEngines_.size()) != signal.channelNum || fftEngines_[0]->size() != fftLength ||
+        isBasebandSpectrum_) {
+        updateRefSpectrum(fftLength, signal.channelNum, false);
+    }
+
+    output.resize(signal.channelNum, outputLength);
+
+    // analytic correlation: the positive frequencies doubled, DC and Nyquist kept, the negative ones zeroed
+    bool isEnvelope = systemInfo_.signalProcessInfo.isEnvelopeEnable;
+    int  positive   = (fftLength - 1) / 2;
+
+    // channels are independent, each one writes its own output row
+    auto filterChannels = [&](int chBegin, int chEnd) {
+        for (int ch = chBegin; ch < chEnd; ++ch) {
+            FFTEngine<T>              &engine = *fftEngines_[ch];
+            std::complex<T>           *buffer = engine.data();
+            const std::vector<double> &x      = signal.channels[ch];
+            for (int i = 0; i < signal.signalLength; ++i) {
+                buffer[i] = std::complex<T>(static_cast<T>(x[i]), 0);
+            }
+            std::fill(buffer + signal.signalLength, buffer + fftLength, std::complex<T>(0, 0));
+
+            engine.forward();
+            if (isEnvelope) {
+                buffer[0] *= refSpectrum_[0];
+                for (int i = 1; i <= positive; ++i) {
+                    buffer[i] *= static_cast<T>(2) * refSpectrum_[i];
+                }
+                if (fftLength % 2 == 0) {
+                    buffer[positive + 1] *= refSpectrum_[positive + 1];
+                }
+                std::fill(buffer + fftLength / 2 + 1, buffer + fftLength, std::complex<T>(0, 0));
+            } else {
+                for (int i = 0; i < fftLength; ++i) {
+                    buffer[i] *= refSpectrum_[i];
+                }
+            }
+            engine.inverse();
+
+            // the real part is the correlation, the magnitude its envelope
+            std::vector<double> &y = output.channels[ch];
+            if (isEnvelope) {
+                for (int i = 0; i < outputLength; ++i) {
+                    y[i] = static_cast<double>(std::abs(buffer[i + refSignalLength_ - 1]));
+                }
+            } else {
+                for (int i = 0; i < outputLength; ++i) {
+                    y[i] = static_cast<double>(buffer[i + refSignalLength_ - 1].real());
+                }
+            }
+        }
+    };
+
+    if (threadPool_ != nullptr) {
+        threadPool_->parallelFor(0, signal.channelNum, 1, filterChannels);
+    } else {
+        filterChannels(0, signal.channelNum);
+    }
+}
+
+template <typename T>
+void TOFT<T>::matchedFilter(const BasebandSignal &signal, ChannelSignalVector &output) {
+    int refLength = refBaseband_.signalLength;
+    if (!refBaseband_.isInit) {
+        throw std::runtime_error("TOF::matchedFilter: baseband reference signal is not set");
+    }
+    if (signal.signalLength < refLength) {
+        throw std::invalid_argument("TOF::matchedFilter: invalid signal length");
+    }
+
+    int fftLength    = fftGoodSize(signal.signalLength + refLength - 1);
+    int outputLength = signal.signalLength - refLength + 1;
+    if (static_cast<int>(fftEngines_.size()) != signal.channelNum || fftEngines_[0]->size() != fftLength ||
+        !isBasebandSpectrum_) {
+        updateRefSpectrum(fftLength, signal.channelNum, true);
+    }
+
+    output.resize(signal.channelNum, outputLength);
+
+    // each baseband sample stands for D input samples and carries the analytic amplitude (twice the real one)
+    const double scale = 0.5 * signal.decimation;
+
+    auto filterChannels = [&](int chBegin, int chEnd) {
+        for (int ch = chBegin; ch < chEnd; ++ch) {
+            FFTEngine<T>                            &engine = *fftEngines_[ch];
+            std::complex<T>                         *buffer = engine.data();
+            const std::vector<std::complex<double>> &x      = signal.channels[ch];
+            for (int i = 0; i < signal.signalLength; ++i) {
+                buffer[i] = std::complex<T>(x[i]);
+            }
+            std::fill(buffer + signal.signalLength, buffer + fftLength, std::complex<T>(0, 0));
+
+            engine.forward();
+            for (int i = 0; i < fftLength; ++i) {
+                buffer[i] *= refSpectrum_[i];
+            }
+            engine.inverse();
+
+            std::vector<double> &y = output.channels[ch];
+            for (int i = 0; i < outputLength; ++i) {
+                y[i] = scale * static_cast<double>(std::abs(buffer[i + refLength - 1]));
+            }
+        }
+    };
+
+    if (threadPool_ != nullptr) {
+        threadPool_->parallelFor(0, signal.channelNum, 1, filterChannels);
+    } else {
+        filterChannels(0, signal.channelNum);
+    }
+}
+
+// only the configured precision is instantiated (fftw3 for double, fftw3f for float); the float build links fftw3
+// as well and also instantiates double, the reference of the self-check in benchmark mode (dspCheck.cpp)
+template class TOFT<DSPReal>;
+#ifdef _DSP_SINGLE_PRECISION_
+template class TOFT<double>;
+#endif
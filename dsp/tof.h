@@ -12,32 +12,102 @@
 #ifndef _TOF_H_
 #define _TOF_H_
 
+#include "../tool/ThreadPool.h"
+#include "fftEngine.h"
 #include "signalBase.h"
 
-class TOF : public SignalBase {
+/***
+ * @description: Time of flight calculation, the matched filter runs in the scalar type T
+ * (see DSPReal in general/typedef.h). Input and output stay in double.
+ */
+template <typename T>
+class TOFT : public SignalBase {
 public:
-    TOF(SystemInfo &systeminfo, ChannelSignalVector &refSignal);
-    TOF(SystemInfo &systeminfo, ChannelSignalEigenD &refSignal);
-    ~TOF() = default;
+    TOFT(SystemInfo &systeminfo, ChannelSignalVector &refSignal);
+    TOFT(SystemInfo &systeminfo, ChannelSignalEigenD &refSignal);
+    ~TOFT() = default;
 
     void init();
+
+    // run the channels on a thread pool (nullptr: serial), the result does not depend on the worker number
+    void setThreadPool(ThreadPool *threadPool) {
+        threadPool_ = threadPool;
+    }
+
+    // with [SignalProcess] enableEnvelopeTOF the peak is picked on the correlation envelope and refined by a parabola
     void calculateTOF(ChannelSignalVector &signal, std::vector<double> &tof);
     void calculateTOF(ChannelSignalEigenD &signal, std::vector<double> &tof);
 
+    // reference signal passed through the decimating front-end, needed by the baseband calculateTOF()
+    void setBasebandReference(const BasebandSignal &refSignal);
+
+    /***
+     * @description: TOF on the complex baseband of the decimating front-end. The peak of the correlation magnitude
+     * (the envelope of the full rate correlation) is refined between the baseband samples by a parabola, the
+     * correlation result is that magnitude at the baseband rate, scaled like the full rate correlation peak.
+     * @param {BasebandSignal} &signal      The baseband signal for each channel
+     * @param {vector<double>} &tof         The TOF of each channel (unit: second)
+     * @return {*}
+     */
+    void calculateTOF(const BasebandSignal &signal, std::vector<double> &tof);
+
     ChannelSignalVector getCorrelationResult() {
         return correlationResult_;
     }
 
+    // move the correlation result out instead of copying it, valid until the next calculateTOF()
+    void releaseCorrelationResult(ChannelSignalVector &correlationResult) {
+        correlationResult = std::move(correlationResult_);
+    }
+
     std::vector<int> getMaxIndex() {
         return maxIndex_;
     }
 
 private:
-    int                 refSignalLength_;
-    ChannelSignalVector correlationResult_;
-    std::vector<int>    maxIndex_;
-    ChannelSignalVector refSignal_;
-    ChannelSignalEigenD refSignalEigenD_;
+    /***
+     * @description: Matched filter, same result as csvconv_valid(signal, fliplr(refSignal))
+     * The FFT plans and the reference spectrum are cached and only rebuilt when the signal length changes,
+     * every channel has its own FFT engine so the channels can run in parallel.
+     * Envelope: the negative frequencies of the product spectrum are zeroed (the positive ones doubled) before the
+     * inverse FFT, which then gives the analytic correlation, its magnitude is the envelope at no extra FFT
+     * @param {ChannelSignalVector} &signal     The sampling signal for each channel
+     * @param {ChannelSignalVector} &output     The correlation result (valid part), or its envelope
+     * @return {*}
+     */
+    void matchedFilter(const ChannelSignalVector &signal, ChannelSignalVector &output);
+    // same on the complex baseband, the output is the correlation magnitude times D / 2
+    void matchedFilter(const BasebandSignal &signal, ChannelSignalVector &output);
+
+    // the cached spectrum is the one of the real or of the baseband reference
+    void updateRefSpectrum(int fftLength, int channelNum, bool isBaseband);
+
+    /***
+     * @description: Peak index of every channel of the correlation (maxIndex_). TOF_PER_CHANNEL: the maximum of each
+     * channel over the whole correlation. TOF_COMBINED: the maximum of the correlation energy summed over the channels
+     * (non-coherent, each channel scaled to a unit mean energy), then the maximum of each channel within half the array
+     * aperture delay plus a margin around it, so a noisy channel cannot pick an earlier noise peak; a channel without
+     * a peak inside the window keeps the combined one. One full-length peak scan instead of one per channel.
+     * @param {ChannelSignalVector} &correlation     The correlation result of each channel
+     * @param {double} sampleRate                   The rate of the correlation (unit: Hz)
+     * @param {bool} isEnvelope                     Whether the correlation is already an envelope (baseband)
+     * @return {*}
+     */
+    void findPeaks(const ChannelSignalVector &correlation, double sampleRate, bool isEnvelope);
+
+    int                                        refSignalLength_;
+    ChannelSignalVector                        correlationResult_;
+    std::vector<int>                           maxIndex_;
+    ChannelSignalVector                        refSignal_;
+    ChannelSignalEigenD                        refSignalEigenD_;
+    BasebandSignal                             refBaseband_;
+    std::vector<std::unique_ptr<FFTEngine<T>>> fftEngines_;
+    std::vector<std::complex<T>>               refSpectrum_;
+    bool                                       isBasebandSpectrum_ = false;
+    std::vector<double>                        combined_; // summed correlation energy (TOF_COMBINED)
+    ThreadPool                                *threadPool_ = nullptr;
 };
 
-#endif // _TOF_H_
\ No newline at end of file
+typedef TOFT<DSPReal> TOF;
+
+#endif // _TOF_H_
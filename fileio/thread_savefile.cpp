@@ -11,6 +11,18 @@
 
 #include "thread_savefile.h"
 
+// pop one result, only the first saved queue of a round blocks: the diagnostics come every diagnosticDecimation
+// pings only, waiting for them would hold back the position results
+template <typename T>
+static bool popResult(sfq::Safe_Queue<T> *queue, T &value, bool &isWaited) {
+    if (!isWaited) {
+        value    = queue->wait_and_pop();
+        isWaited = true;
+        return true;
+    }
+    return queue->try_pop(value);
+}
+
 ThreadSaveFile::ThreadSaveFile(SystemInfo *systeminfo) {
     systemInfo_ = systeminfo;
 
@@ -498,6 +510,8 @@ void ThreadSaveFile::closeThread_saveSideAmpSpec() {
 }
 
 void ThreadSaveFile::saveDAQAIData() {
+    applyThreadPolicy("Save DAQ AI Data", systemInfo_->threadPolicyInfo.saveFile,
+                      systemInfo_->threadPolicyInfo.prefaultStackSize);
     // check the queue and file saver
     if (!isLoadDAQAIQueue_ && !daqaiFileSaver_->isOpen()) {
         std::cerr << termColor("red") << "DAQ AI Data Queue is not loaded or DAQ AI Data Saver file is not open"
@@ -519,18 +533,28 @@ void ThreadSaveFile::saveDAQAIData() {
 }
 
 void ThreadSaveFile::saveProcessResult() {
+    applyThreadPolicy("Save Process Result", systemInfo_->threadPolicyInfo.saveFile,
+                      systemInfo_->threadPolicyInfo.prefaultStackSize);
     while (enableThread_saveProcessResult_) {
+        bool isWaited = false;
         if (isLoadPosResQueue_) {
             if (posResFileSaver_->isOpen()) {
-                posRes_ = posResQue_->wait_and_pop();
-                std::vector<double> posResData;
-                posResData.push_back(posRes_.time);
-                posResData.push_back(posRes_.position.x());
-                posResData.push_back(posRes_.position.y());
-                posResData.push_back(posRes_.position.z());
-                posResData.push_back(posRes_.tof);
-                posResData.push_back(posRes_.doa);
-                posResFileSaver_->dump(posResData);
+                while (popResult(posResQue_, posRes_, isWaited)) {
+                    std::vector<double> posResData;
+                    posResData.push_back(posRes_.time);
+                    posResData.push_back(posRes_.position.x());
+                    posResData.push_back(posRes_.position.y());
+                    posResData.push_back(posRes_.position.z());
+                    posResData.push_back(posRes_.tof);
+                    posResData.push_back(posRes_.doa);
+                    // gain the ping was acquired with and its peak, as received and at the amplifier input
+                    posResData.push_back(posRes_.gainTag.state);
+                    posResData.push_back(posRes_.gainTag.gain);
+                    posResData.push_back(posRes_.gainTag.gainDb);
+                    posResData.push_back(posRes_.peakAmplitude);
+                    posResData.push_back(posRes_.normalizedPeak);
+                    posResFileSaver_->dump(posResData);
+                }
             } else {
                 if (!systemInfo_->savedFileInfo.isSavePosRes) {
                     posResQue_->try_pop(posRes_);
@@ -542,9 +566,10 @@ void ThreadSaveFile::saveProcessResult() {
         }
         if (isLoadCorrelationQueue_) {
             if (correlationFileSaver_->isOpen()) {
-                correlationRes_ = correlationQue_->wait_and_pop();
-                for (int i = 0; i < correlationRes_.channelNum; ++i) {
-                    correlationFileSaver_->dump(correlationRes_.channels[i]);
+                while (popResult(correlationQue_, correlationRes_, isWaited)) {
+                    for (int i = 0; i < correlationRes_.channelNum; ++i) {
+                        correlationFileSaver_->dump(correlationRes_.channels[i]);
+                    }
                 }
             } else {
                 if (!systemInfo_->savedFileInfo.isSaveCorrelation) {
@@ -557,8 +582,9 @@ void ThreadSaveFile::saveProcessResult() {
         }
         if (isLoadTOFResQueue_) {
             if (tofResFileSaver_->isOpen()) {
-                tofRes_ = tofResQue_->wait_and_pop();
-                tofResFileSaver_->dump(tofRes_);
+                while (popResult(tofResQue_, tofRes_, isWaited)) {
+                    tofResFileSaver_->dump(tofRes_);
+                }
             } else {
                 if (!systemInfo_->savedFileInfo.isSaveTOFRes) {
                     tofResQue_->try_pop(tofRes_);
@@ -570,13 +596,14 @@ void ThreadSaveFile::saveProcessResult() {
         }
         if (isLoadBeamPatternQueue_) {
             if (beamPatternFileSaver_->isOpen()) {
-                beamPattern_ = beamPatternQue_->wait_and_pop();
-                for (int i = 0; i < beamPattern_.rows(); ++i) {
-                    std::vector<double> row(beamPattern_.cols());
-                    for (int j = 0; j < beamPattern_.cols(); ++j) {
-                        row[j] = beamPattern_(i, j);
+                while (popResult(beamPatternQue_, beamPattern_, isWaited)) {
+                    for (int i = 0; i < beamPattern_.rows(); ++i) {
+                        std::vector<double> row(beamPattern_.cols());
+                        for (int j = 0; j < beamPattern_.cols(); ++j) {
+                            row[j] = beamPattern_(i, j);
+                        }
+                        beamPatternFileSaver_->dump(row);
                     }
-                    beamPatternFileSaver_->dump(row);
                 }
             } else {
                 if (!systemInfo_->savedFileInfo.isSaveBeamPattern) {
@@ -589,9 +616,10 @@ void ThreadSaveFile::saveProcessResult() {
         }
         if (isLoadSideAmpSpecQueue_) {
             if (sideAmpSpecFileSaver_->isOpen()) {
-                sideAmpSpec_ = sideAmpSpecQue_->wait_and_pop();
-                for (int i = 0; i < sideAmpSpec_.channelNum; ++i) {
-                    sideAmpSpecFileSaver_->dump(sideAmpSpec_.channels[i]);
+                while (popResult(sideAmpSpecQue_, sideAmpSpec_, isWaited)) {
+                    for (int i = 0; i < sideAmpSpec_.channelNum; ++i) {
+                        sideAmpSpecFileSaver_->dump(sideAmpSpec_.channels[i]);
+                    }
                 }
             } else {
                 if (!systemInfo_->savedFileInfo.isSaveSideAmpSpec) {
@@ -606,6 +634,8 @@ void ThreadSaveFile::saveProcessResult() {
 }
 
 void ThreadSaveFile::savePosRes() {
+    applyThreadPolicy("Save Position Result", systemInfo_->threadPolicyInfo.saveFile,
+                      systemInfo_->threadPolicyInfo.prefaultStackSize);
     // check the queue and file saver
     if (!isLoadPosResQueue_ && !posResFileSaver_->isOpen()) {
         std::cerr << termColor("red") << "Position Result Queue is not loaded or Position Result Saver file is not open"
@@ -622,11 +652,18 @@ void ThreadSaveFile::savePosRes() {
         posResData.push_back(posRes_.position.z());
         posResData.push_back(posRes_.tof);
         posResData.push_back(posRes_.doa);
+        posResData.push_back(posRes_.gainTag.state);
+        posResData.push_back(posRes_.gainTag.gain);
+        posResData.push_back(posRes_.gainTag.gainDb);
+        posResData.push_back(posRes_.peakAmplitude);
+        posResData.push_back(posRes_.normalizedPeak);
         posResFileSaver_->dump(posResData);
     }
 }
 
 void ThreadSaveFile::saveCorrelation() {
+    applyThreadPolicy("Save Correlation", systemInfo_->threadPolicyInfo.saveFile,
+                      systemInfo_->threadPolicyInfo.prefaultStackSize);
     // check the queue and file saver
     if (!isLoadCorrelationQueue_ && !correlationFileSaver_->isOpen()) {
         std::cerr << termColor("red") << "Correlation Queue is not loaded or Correlation Saver file is not open"
@@ -643,6 +680,8 @@ void ThreadSaveFile::saveCorrelation() {
 }
 
 void ThreadSaveFile::saveTOFRes() {
+    applyThreadPolicy("Save TOF Result", systemInfo_->threadPolicyInfo.saveFile,
+                      systemInfo_->threadPolicyInfo.prefaultStackSize);
     while (enableThread_saveTOFRes_) {
         tofRes_ = tofResQue_->wait_and_pop();
         tofResFileSaver_->dump(tofRes_);
@@ -650,6 +689,8 @@ void ThreadSaveFile::saveTOFRes() {
 }
 
 void ThreadSaveFile::saveBeamPattern() {
+    applyThreadPolicy("Save Beam Pattern", systemInfo_->threadPolicyInfo.saveFile,
+                      systemInfo_->threadPolicyInfo.prefaultStackSize);
     // check the queue and file saver
     if (!isLoadBeamPatternQueue_ && !beamPatternFileSaver_->isOpen()) {
         std::cerr << termColor("red") << "Beam Pattern Queue is not loaded or Beam Pattern Saver file is not open"
@@ -679,6 +720,8 @@ void ThreadSaveFile::saveBeamPattern() {
 }
 
 void ThreadSaveFile::saveSideAmpSpec() {
+    applyThreadPolicy("Save Side Amp Spec", systemInfo_->threadPolicyInfo.saveFile,
+                      systemInfo_->threadPolicyInfo.prefaultStackSize);
     // check the queue and file saver
     if (!isLoadSideAmpSpecQueue_ && !sideAmpSpecFileSaver_->isOpen()) {
         std::cerr << termColor("red") << "Side Amp Spec Queue is not loaded or Side Amp Spec Saver file is not open"
@@ -13,17 +13,29 @@
 #define _TYPEDEF_H_
 
 #include <Eigen/Dense>
+#include <chrono>
 #include <complex>
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 
+// scalar type of the DSP kernels (TOF, DOA, FFT engine), selected at compile time
+// _DSP_SINGLE_PRECISION_ is defined by the DSP_SINGLE_PRECISION cmake option
+#ifdef _DSP_SINGLE_PRECISION_
+typedef float DSPReal;
+#else
+typedef double DSPReal;
+#endif
+
 typedef struct ChannelSignalVector {
     bool                             isInit       = false;
     int                              channelNum   = 0;
     int                              signalLength = 0;
     std::vector<std::vector<double>> channels;
+    // when the last sample was acquired, set by the DAQ (the epoch when unknown)
+    std::chrono::steady_clock::time_point time;
 
     // default constructor
     ChannelSignalVector() = default;
@@ -66,7 +78,8 @@ typedef struct ChannelSignalVector {
         : isInit(other.isInit)
         , channelNum(other.channelNum)
         , signalLength(other.signalLength)
-        , channels(other.channels) {
+        , channels(other.channels)
+        , time(other.time) {
     }
 
     // move constructor
@@ -74,7 +87,8 @@ typedef struct ChannelSignalVector {
         : isInit(std::move(other.isInit))
         , channelNum(std::move(other.channelNum))
         , signalLength(std::move(other.signalLength))
-        , channels(std::move(other.channels)) {
+        , channels(std::move(other.channels))
+        , time(other.time) {
     }
 
     // copy assignment operator
@@ -86,6 +100,7 @@ typedef struct ChannelSignalVector {
         channelNum   = other.channelNum;
         signalLength = other.signalLength;
         channels     = other.channels;
+        time         = other.time;
         return *this;
     }
 
@@ -98,6 +113,7 @@ typedef struct ChannelSignalVector {
         channelNum   = std::move(other.channelNum);
         signalLength = std::move(other.signalLength);
         channels     = std::move(other.channels);
+        time         = other.time;
         return *this;
     }
 
@@ -479,13 +495,89 @@ struct ChannelSignalEigenC {
     }
 };
 
+// complex baseband of a multi-channel signal, output of the decimating front-end (see dsp/frontEnd.h)
+typedef struct BasebandSignal {
+    bool                                           isInit          = false;
+    int                                            channelNum      = 0;
+    int                                            signalLength    = 0;
+    int                                            decimation      = 1;   // input samples per baseband sample
+    double                                         sampleRate      = 0.0; // baseband sample rate (Hz)
+    double                                         centerFrequency = 0.0; // mixed down to 0 Hz (Hz)
+    std::vector<std::vector<std::complex<double>>> channels;
+
+    void resize(int cn, int sl) {
+        channelNum   = cn;
+        signalLength = sl;
+        channels.resize(channelNum);
+        for (int i = 0; i < channelNum; ++i) {
+            channels[i].assign(signalLength, std::complex<double>(0.0, 0.0));
+        }
+        isInit = true;
+    }
+} BasebandSignal;
+
+// whether the gain of a ping is known, see GainTag
+enum GAIN_STATE {
+    GAIN_UNKNOWN  = 0, // no DAC command confirmed before the ping (AGC disabled, starting, or the last command failed)
+    GAIN_SETTLED  = 1, // the gain did not change while the ping was acquired
+    GAIN_CHANGING = 2  // a DAC command overlapped the ping, the gain is the one at its start
+};
+
+// receive gain in effect while a ping was acquired, from the DAC commands the AGC thread confirmed (GainTracker)
+typedef struct GainTag {
+    uint8_t  state  = GAIN_UNKNOWN; // GAIN_STATE
+    double   gain   = 0.0;          // gain voltage
+    double   gainDb = 0.0;          // amplifier gain at that voltage ([AGC] gainSlope, gainOffset)
+    double   scale  = 1.0;          // amplitude factor to the amplifier input, 10^(-gainDb / 20), 1 when unknown
+    uint64_t seq    = 0;            // ping the gain was derived from
+} GainTag;
+
 typedef struct PositionResult {
+    uint64_t        seq;            // ping sequence number assigned by the DSP pipeline
+    uint64_t        sampleIndex;    // absolute sample index of the ping in streaming mode, 0 otherwise
     double          time;
     Eigen::Vector3d position;
     double          doa;
     double          tof;
+    double          agcGain;        // gain voltage the AGC derived from the ping
+    GainTag         gainTag;        // gain in effect while the ping was acquired
+    double          peakAmplitude;  // correlation peak of the ping, as received (the AGC input)
+    double          normalizedPeak; // the same at the amplifier input, comparable across pings (gainTag.scale)
 } positionResult;
 
+// gain the DSP pipeline derived from a ping, handed to the AGC thread
+typedef struct AgcRequest {
+    uint64_t                              seq  = 0;   // ping sequence number
+    double                                gain = 0.0; // gain voltage
+    std::chrono::steady_clock::time_point time;       // when it was derived, start of the actuation latency
+} AgcRequest;
+
+// products of a ping the DSP pipeline can publish (bit mask), see PingProducts
+enum PING_PRODUCT {
+    PRODUCT_RAW           = 1 << 0, // input samples of the ping
+    PRODUCT_CORRELATION   = 1 << 1, // matched filter output
+    PRODUCT_BEAM_PATTERN  = 1 << 2, // beamforming power over the scanned angles
+    PRODUCT_SIDE_AMP_SPEC = 1 << 3, // side amplitude spectrum
+    PRODUCT_POSITION      = 1 << 4, // TOF and DOA
+    PRODUCT_ALL           = (1 << 5) - 1
+};
+
+// results of one ping published by the DSP pipeline, shared read-only by every consumer
+typedef struct PingProducts {
+    uint32_t            products    = 0; // PING_PRODUCT bits filled in
+    uint64_t            seq         = 0; // ping sequence number assigned by the DSP pipeline
+    uint64_t            sampleIndex = 0; // absolute sample index of the ping in streaming mode, 0 otherwise
+    double              sampleRate  = 0; // of signal (Hz)
+    double              tof         = 0;
+    double              doa         = 0;
+    GainTag             gainTag;         // gain in effect while the ping was acquired, correlation is normalized by it
+    std::vector<double> tofResult;       // TOF of each channel, relative to signal (s)
+    ChannelSignalVector signal;          // PRODUCT_RAW
+    ChannelSignalVector correlation;     // PRODUCT_CORRELATION
+    ChannelSignalVector sideAmpSpec;     // PRODUCT_SIDE_AMP_SPEC
+    Eigen::MatrixXd     beamPattern;     // PRODUCT_BEAM_PATTERN
+} PingProducts;
+
 // function to free double** array
 inline void freeDoubleArray(double **array, int rows) {
     if (!array)
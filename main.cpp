@@ -10,6 +10,7 @@
  */
 
 #include "config/yamlconfig.h"
+#include "core/benchmark.h"
 #include "core/systeminfo.h"
 #include "daq/ai/aiScanWithTrigger.h"
 #include "daq/ao/aoScanWithTrigger.h"
@@ -18,6 +19,7 @@
 #include "dataio/tcpServer.h"
 #include "dataio/thread_dataio.h"
 #include "dataio/thread_tcpComm.h"
+#include "dataio/thread_udpPublish.h"
 #include "dsp/doa.h"
 #include "dsp/signalBase.h"
 #include "dsp/thread_agc.h"
@@ -48,8 +50,7 @@ int main(int argc, char *argv[]) {
     ChannelSignalVector                  refSignal;
     sfq::Safe_Queue<ChannelSignalVector> dataQueue;
     sfq::Safe_Queue<ChannelSignalVector> dataSaveQueue;
-    sfq::Safe_Queue<ChannelSignalVector> dataSendQueue;
-    sfq::Safe_Queue<double>              agcQueue;
+    sfq::Safe_Queue<AgcRequest>          agcQueue;
 
     // Set output queue
     sfq::Safe_Queue<PositionResult>      posResQueue;
@@ -58,15 +59,17 @@ int main(int argc, char *argv[]) {
     sfq::Safe_Queue<ChannelSignalVector> signalSideAmpSpecQueue;
     sfq::Safe_Queue<Eigen::MatrixXd>     beamPatternQueue;
 
+    // products of the pings sent to the TCP subscribers
+    sfq::Safe_Queue<std::shared_ptr<const PingProducts>> productQueue;
+    // position results published on the UDP multicast group
+    sfq::Safe_Queue<PositionResult> posResPublishQueue;
+
     // Load Config from YAML
     YamlConfig.open(yamlConfigPath);
     YamlConfig.loadConfig(systemInfo);
     setDefualtDAQConfig(systemInfo);
     pinrtSystemConfig(systemInfo);
 
-    // creat save file thread
-    ThreadSaveFile threadSaveFile(&systemInfo);
-
     // Generate Signal
     double         *signal;
     SignalGenerator signalgernerator(systemInfo.signalInfo.sampleRate);
@@ -85,11 +88,23 @@ int main(int argc, char *argv[]) {
     systemInfo.aoScanInfo.samplesPerChannel = signalgernerator.getSignalLength();
 
     // save generated signal to refSignal
+    // resize() zero-fills signalLength samples, the TOF, stream TOF, pre-filter and front-end read exactly those
     refSignal.resize(1, systemInfo.aoScanInfo.samplesPerChannel);
     for (int i = 0; i < systemInfo.aoScanInfo.samplesPerChannel; ++i) {
-        refSignal.channels[0].push_back(signal[i]);
+        refSignal.channels[0][i] = signal[i];
+    }
+
+    // benchmark mode: the self-checks and benchmarks run on the config, no DAQ device is opened
+    if (systemInfo.isBenchmark) {
+        return runBenchmarks(systemInfo, refSignal) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
+    // lock and pre-fault memory before any worker thread is created
+    applyMemoryPolicy(systemInfo.threadPolicyInfo.isLockMemory, systemInfo.threadPolicyInfo.prefaultHeapSize);
+
+    // creat save file thread
+    ThreadSaveFile threadSaveFile(&systemInfo);
+
     // Config DAQ Device
     switch (systemInfo.workMode) {
         case WorkMode::MODE_RECEIVE: { // Analog Input
@@ -100,13 +115,26 @@ int main(int argc, char *argv[]) {
             // Start process thread
             // initialize dsp process thread
             ThreadDSP threadDSP(systemInfo, refSignal, dataQueue);
-            // set output queue (process result)
-            threadDSP.setPosResQueue(&posResQueue);
-            threadDSP.setSignalTOFQueue(&signalTOFQueue);
+            // the gains the AGC thread set, every ping is tagged with the one it was acquired with
+            GainTracker gainTracker(systemInfo.agcInfo);
+            threadDSP.setGainTracker(&gainTracker);
+            // set output queue (process result), a result without a consumer is not computed
             threadDSP.setAGCQueue(&agcQueue);
-            threadDSP.setSignalCorrelationQueue(&signalCorrelationQueue);
-            threadDSP.setSignalSideAmpSpecQueue(&signalSideAmpSpecQueue);
-            threadDSP.setBeamPatternQueue(&beamPatternQueue);
+            if (systemInfo.savedFileInfo.isSavePosRes) {
+                threadDSP.setPosResQueue(&posResQueue);
+            }
+            if (systemInfo.savedFileInfo.isSaveTOFRes) {
+                threadDSP.setSignalTOFQueue(&signalTOFQueue);
+            }
+            if (systemInfo.savedFileInfo.isSaveCorrelation) {
+                threadDSP.setSignalCorrelationQueue(&signalCorrelationQueue);
+            }
+            if (systemInfo.savedFileInfo.isSaveSideAmpSpec) {
+                threadDSP.setSignalSideAmpSpecQueue(&signalSideAmpSpecQueue);
+            }
+            if (systemInfo.savedFileInfo.isSaveBeamPattern) {
+                threadDSP.setBeamPatternQueue(&beamPatternQueue);
+            }
 
             // Thread Save Process Result
             threadSaveFile.setBeamPatternQueue(&beamPatternQueue);
@@ -120,21 +148,46 @@ int main(int argc, char *argv[]) {
 
             // Thread AGC
             ThreadAGC threadAGC(systemInfo, &agcQueue);
+            threadAGC.setGainTracker(&gainTracker);
             threadAGC.creatThread_agcProcess();
 
-            // start dsp process thread
-            threadDSP.creatThread_dspProcess();
-
             // TCP communication
             // int       port = 8080;
-            tcpServer server(systemInfo.tcpInfo.serverPort);
+            tcpServer server(systemInfo.tcpInfo, systemInfo.threadPolicyInfo.tcp,
+                             systemInfo.threadPolicyInfo.prefaultStackSize);
             server.start();
 
-            // create and start data sending thread
+            // create and start data sending thread, the DSP pipeline computes what its clients subscribed to
             ThreadTcpCommunication dataSender(systemInfo, server);
-            dataSender.setDataQueue(&dataSendQueue);
+            dataSender.setProductQueue(&productQueue);
+            threadDSP.setProductQueue(&productQueue,
+                                      [&dataSender](uint64_t seq) { return dataSender.productDemand(seq); });
             dataSender.startSending();
 
+            // UDP multicast of the position fixes and the telemetry
+            std::unique_ptr<ThreadUdpPublish> udpPublisher;
+            if (systemInfo.udpInfo.isEnable) {
+                udpPublisher.reset(new ThreadUdpPublish(systemInfo));
+                udpPublisher->setPosResQueue(&posResPublishQueue);
+                udpPublisher->setTelemetrySource([&threadDSP, &dataQueue, &server](UdpTelemetry &telemetry) {
+                    std::vector<TcpClientStats> stats;
+                    server.getClientStats(stats);
+                    telemetry.pingNum       = threadDSP.getOutputNum();
+                    telemetry.outOfOrderNum = threadDSP.getOutOfOrderNum();
+                    telemetry.inputBacklog  = dataQueue.size();
+                    telemetry.tcpClientNum  = stats.size();
+                    for (const TcpClientStats &client : stats) {
+                        telemetry.tcpFramesDropped += client.framesDropped;
+                    }
+                });
+                if (udpPublisher->startPublishing()) {
+                    threadDSP.setPublishPosResQueue(&posResPublishQueue);
+                }
+            }
+
+            // start dsp process thread
+            threadDSP.creatThread_dspProcess();
+
             AIScanInfo scanInfo;
 
             // config AI Scan Info
@@ -147,6 +200,10 @@ int main(int argc, char *argv[]) {
             scanInfo.rate              = systemInfo.aiScanInfo.rate;
             scanInfo.duration          = systemInfo.aiScanInfo.duration;
             scanInfo.interval          = systemInfo.aiScanInfo.interval;
+            scanInfo.isStream          = systemInfo.streamInfo.isEnable;
+            scanInfo.hopSamples        = systemInfo.streamInfo.hopSamples;
+            scanInfo.threadSched       = systemInfo.threadPolicyInfo.acquisition;
+            scanInfo.prefaultStackSize = systemInfo.threadPolicyInfo.prefaultStackSize;
 
             // config file save thread
             ThreadSaveFile threadSaveFile(&systemInfo);
@@ -155,9 +212,8 @@ int main(int argc, char *argv[]) {
                 threadSaveFile.creatThread_saveDAQAIData(&dataSaveQueue);
             }
 
-            // start scan
-            // AIScanWithTrigger aiScanWithTrigger(&scanInfo, &dataQueue, &dataSaveQueue);
-            AIScanWithTrigger aiScanWithTrigger(&scanInfo, &dataQueue, &dataSaveQueue, &dataSendQueue);
+            // start scan, the TCP clients get the pings from the DSP pipeline
+            AIScanWithTrigger aiScanWithTrigger(&scanInfo, &dataQueue, &dataSaveQueue);
             aiScanWithTrigger.dataAcquisition();
 
             break;
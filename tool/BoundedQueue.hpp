@@ -0,0 +1,110 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 11:02:31
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 11:02:31
+ * @FilePath: /Raspi2USBL/tool/BoundedQueue.hpp
+ * @Description: Thread safe queue with a fixed capacity, used for the handoff between pipeline stages
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _BOUNDED_QUEUE_H
+#define _BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace sfq {
+
+/***
+ * @description: Same interface style as Safe_Queue, but push() blocks while the queue is full (back pressure)
+ * and close() wakes up every waiting producer and consumer so the owning threads can exit.
+ */
+template <typename T>
+class Bounded_Queue {
+public:
+    explicit Bounded_Queue(size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1) {
+    }
+    Bounded_Queue(const Bounded_Queue &)            = delete;
+    Bounded_Queue &operator=(const Bounded_Queue &) = delete;
+
+    // push an element, block while the queue is full, return false if the queue is closed
+    bool push(T &&new_val) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        condNotFull_.wait(lk, [this] { return closed_ || queue_data_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        queue_data_.push_back(std::move(new_val));
+        condNotEmpty_.notify_one();
+        return true;
+    }
+
+    bool push(const T &new_val) {
+        T copy(new_val);
+        return push(std::move(copy));
+    }
+
+    // pop an element, block while the queue is empty, return false once the queue is closed and drained
+    bool wait_and_pop(T &value) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        condNotEmpty_.wait(lk, [this] { return closed_ || !queue_data_.empty(); });
+        if (queue_data_.empty()) {
+            return false;
+        }
+        value = std::move(queue_data_.front());
+        queue_data_.pop_front();
+        condNotFull_.notify_one();
+        return true;
+    }
+
+    // try to pop an element, return false if the queue is empty
+    bool try_pop(T &value) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (queue_data_.empty()) {
+            return false;
+        }
+        value = std::move(queue_data_.front());
+        queue_data_.pop_front();
+        condNotFull_.notify_one();
+        return true;
+    }
+
+    // reject further pushes and wake up all waiting threads
+    void close() {
+        std::lock_guard<std::mutex> lk(mutex_);
+        closed_ = true;
+        condNotEmpty_.notify_all();
+        condNotFull_.notify_all();
+    }
+
+    bool Is_empty() const {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return queue_data_.empty();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return queue_data_.size();
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    mutable std::mutex      mutex_;
+    std::condition_variable condNotEmpty_;
+    std::condition_variable condNotFull_;
+    std::deque<T>           queue_data_;
+    size_t                  capacity_;
+    bool                    closed_ = false;
+};
+
+} // namespace sfq
+
+#endif // _BOUNDED_QUEUE_H
@@ -0,0 +1,173 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 14:05:12
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 14:05:12
+ * @FilePath: /Raspi2USBL/tool/ThreadPolicy.cpp
+ * @Description: See ThreadPolicy.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "ThreadPolicy.h"
+#include "ColorParse.h"
+#include <alloca.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <malloc.h>
+#include <mutex>
+#include <sched.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// the report lines come from several threads starting at the same time
+std::mutex &reportMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+void printReport(const std::string &line, bool isApplied) {
+    std::lock_guard<std::mutex> lock(reportMutex());
+    std::cout << termColor(isApplied ? "green" : "yellow") << line << termColor("nocolor") << std::endl;
+}
+
+size_t pageSize() {
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<size_t>(size) : 4096;
+}
+
+} // namespace
+
+bool setThreadAffinity(pthread_t thread, int core, std::string &error) {
+    if (core < 0) {
+        return true;
+    }
+    if (core >= CPU_SETSIZE) {
+        error = "core index out of range";
+        return false;
+    }
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core, &cpuset);
+    int ret = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+    if (ret != 0) {
+        error = std::string("pthread_setaffinity_np: ") + std::strerror(ret);
+        return false;
+    }
+    return true;
+}
+
+bool setThreadPriority(pthread_t thread, int priority, std::string &error) {
+    if (priority <= 0) {
+        return true;
+    }
+    int minPriority = sched_get_priority_min(SCHED_FIFO);
+    int maxPriority = sched_get_priority_max(SCHED_FIFO);
+    if (priority < minPriority || priority > maxPriority) {
+        error = "priority out of range";
+        return false;
+    }
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int ret              = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if (ret != 0) {
+        error = std::string("pthread_setschedparam: ") + std::strerror(ret);
+        if (ret == EPERM) {
+            error += " (needs root or CAP_SYS_NICE)";
+        }
+        return false;
+    }
+    return true;
+}
+
+void prefaultStack(size_t size) {
+    if (size == 0) {
+        return;
+    }
+    // write one byte per page, volatile so the stores are not optimized away
+    volatile unsigned char *stack = static_cast<unsigned char *>(alloca(size));
+    size_t                  step  = pageSize();
+    for (size_t i = 0; i < size; i += step) {
+        stack[i] = 0;
+    }
+}
+
+bool applyThreadPolicy(const std::string &name, const ThreadSchedInfo &sched, size_t prefaultStackSize) {
+    std::ostringstream report;
+    std::string        error;
+    bool               isApplied = true;
+    pthread_t          self      = pthread_self();
+
+    report << "Thread Policy [" << name << "]:";
+    if (sched.core < 0) {
+        report << " core not pinned;";
+    } else if (setThreadAffinity(self, sched.core, error)) {
+        report << " core " << sched.core << ";";
+    } else {
+        report << " core " << sched.core << " failed (" << error << ");";
+        isApplied = false;
+    }
+    if (sched.priority <= 0) {
+        report << " SCHED_OTHER;";
+    } else if (setThreadPriority(self, sched.priority, error)) {
+        report << " SCHED_FIFO " << sched.priority << ";";
+    } else {
+        report << " SCHED_FIFO " << sched.priority << " failed (" << error << ");";
+        isApplied = false;
+    }
+    if (prefaultStackSize > 0) {
+        prefaultStack(prefaultStackSize);
+        report << " stack " << prefaultStackSize / 1024 << " KiB pre-faulted";
+    }
+    printReport(report.str(), isApplied);
+    return isApplied;
+}
+
+bool applyMemoryPolicy(bool lockMemory, size_t prefaultHeapSize) {
+    std::ostringstream report;
+    bool               isApplied = true;
+
+    report << "Memory Policy:";
+    if (lockMemory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            report << " mlockall;";
+        } else {
+            int err = errno;
+            report << " mlockall failed (" << std::strerror(err);
+            if (err == EPERM || err == ENOMEM) {
+                report << ", needs root, CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK";
+            }
+            report << ");";
+            isApplied = false;
+        }
+    } else {
+        report << " memory not locked;";
+    }
+    if (prefaultHeapSize > 0) {
+        // keep freed blocks in the heap, so the pre-faulted pages are reused instead of returned to the kernel
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+        unsigned char *heap = static_cast<unsigned char *>(std::malloc(prefaultHeapSize));
+        if (heap != nullptr) {
+            // volatile, otherwise the malloc / free pair may be optimized away
+            volatile unsigned char *page = heap;
+            size_t                  step = pageSize();
+            for (size_t i = 0; i < prefaultHeapSize; i += step) {
+                page[i] = 0;
+            }
+            std::free(heap);
+            report << " heap " << prefaultHeapSize / 1024 << " KiB pre-faulted";
+        } else {
+            report << " heap pre-fault failed (out of memory)";
+            isApplied = false;
+        }
+    }
+    printReport(report.str(), isApplied);
+    return isApplied;
+}
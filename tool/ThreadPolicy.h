@@ -0,0 +1,69 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 11:10:47
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 14:05:12
+ * @FilePath: /Raspi2USBL/tool/ThreadPolicy.h
+ * @Description: Helpers to apply scheduling policy (core pinning, SCHED_FIFO) and memory locking to the
+ * @             acquisition and processing threads, each applied step is reported at startup
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _THREADPOLICY_H_
+#define _THREADPOLICY_H_
+
+#include <cstddef>
+#include <pthread.h>
+#include <string>
+
+typedef struct ThreadSchedInfo {
+    int core     = -1; // CPU core, -1 means not pinned
+    int priority = 0;  // SCHED_FIFO priority 1~99, 0 means the default scheduler (SCHED_OTHER)
+} ThreadSchedInfo;
+
+/***
+ * @description: Pin a thread to one CPU core
+ * @param {pthread_t} thread    The thread to pin
+ * @param {int} core            The CPU core index, a negative value leaves the thread unpinned
+ * @param {string} &error       The reason when pinning failed
+ * @return {bool}               true if the thread is pinned or no pinning is requested
+ */
+bool setThreadAffinity(pthread_t thread, int core, std::string &error);
+
+/***
+ * @description: Switch a thread to SCHED_FIFO
+ * @param {pthread_t} thread    The thread
+ * @param {int} priority        SCHED_FIFO priority, 0 leaves the thread on the default scheduler
+ * @param {string} &error       The reason when it failed (usually missing root or CAP_SYS_NICE)
+ * @return {bool}               true if applied or nothing is requested
+ */
+bool setThreadPriority(pthread_t thread, int priority, std::string &error);
+
+/***
+ * @description: Touch the given number of stack bytes of the calling thread, so later deep calls do not page fault
+ * @param {size_t} size     Stack bytes to pre-fault
+ * @return {*}
+ */
+void prefaultStack(size_t size);
+
+/***
+ * @description: Apply the policy to the calling thread (pin, SCHED_FIFO, stack pre-fault) and print one report line
+ * @param {string} &name                The thread name shown in the report
+ * @param {ThreadSchedInfo} &sched      Core and priority
+ * @param {size_t} prefaultStackSize    Stack bytes to pre-fault, 0 to skip
+ * @return {bool}                       true if every requested step was applied
+ */
+bool applyThreadPolicy(const std::string &name, const ThreadSchedInfo &sched, size_t prefaultStackSize);
+
+/***
+ * @description: Process wide memory policy: mlockall(MCL_CURRENT | MCL_FUTURE), keep freed heap in the process
+ * (no trim, no mmap for large blocks) and pre-fault the heap, then print one report line.
+ * Call it once from main before the worker threads are created.
+ * @param {bool} lockMemory         Whether to lock the memory
+ * @param {size_t} prefaultHeapSize Heap bytes to pre-fault, 0 to skip
+ * @return {bool}                   true if every requested step was applied
+ */
+bool applyMemoryPolicy(bool lockMemory, size_t prefaultHeapSize);
+
+#endif // _THREADPOLICY_H_
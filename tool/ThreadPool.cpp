@@ -0,0 +1,160 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 13:20:16
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 13:20:16
+ * @FilePath: /Raspi2USBL/tool/ThreadPool.cpp
+ * @Description: See ThreadPool.h
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int workerNum, const std::function<void(int)> &onWorkerStart)
+    : onWorkerStart_(onWorkerStart)
+    , pending_(0)
+    , nextQueue_(0)
+    , stop_(false) {
+    int num = workerNum > 0 ? workerNum : 0;
+    for (int i = 0; i < num; ++i) {
+        queues_.emplace_back(new WorkerQueue);
+    }
+    for (int i = 0; i < num; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stop_ = true;
+    }
+    wakeCond_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int first, int last, int grain, const std::function<void(int, int)> &func) {
+    if (last <= first) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    int chunkNum = (last - first + grain - 1) / grain;
+
+    // no worker or nothing to split: run on the caller
+    if (workers_.empty() || chunkNum == 1) {
+        func(first, last);
+        return;
+    }
+
+    TaskGroup group;
+    group.remaining = chunkNum;
+
+    // spread the chunks over the worker deques, starting at a rotating queue
+    pending_ += chunkNum;
+    unsigned start = nextQueue_.fetch_add(1);
+    for (int c = 0; c < chunkNum; ++c) {
+        Task task;
+        task.group = &group;
+        task.begin = first + c * grain;
+        task.end   = std::min(last, task.begin + grain);
+        task.func  = &func;
+
+        WorkerQueue                &queue = *queues_[(start + c) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+    }
+    wakeCond_.notify_all();
+
+    // help until there is nothing left to steal, then wait for the chunks still running on workers
+    Task task;
+    while (group.remaining.load() > 0) {
+        if (stealTask(-1, task)) {
+            runTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        doneCond_.wait(lock, [&group] { return group.remaining.load() == 0; });
+    }
+
+    if (group.error) {
+        std::rethrow_exception(group.error);
+    }
+}
+
+void ThreadPool::workerLoop(int index) {
+    if (onWorkerStart_) {
+        onWorkerStart_(index);
+    }
+    Task task;
+    while (true) {
+        if (popTask(index, task) || stealTask(index, task)) {
+            runTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCond_.wait(lock, [this] { return stop_ || pending_.load() > 0; });
+        if (stop_ && pending_.load() <= 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::popTask(int index, Task &task) {
+    WorkerQueue                &queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    --pending_;
+    return true;
+}
+
+bool ThreadPool::stealTask(int thief, Task &task) {
+    int num = static_cast<int>(queues_.size());
+    for (int i = 1; i <= num; ++i) {
+        int victim = (thief + i + num) % num;
+        if (victim == thief) {
+            continue;
+        }
+        WorkerQueue                &queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        --pending_;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::runTask(Task &task) {
+    TaskGroup *group = task.group;
+    try {
+        (*task.func)(task.begin, task.end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        if (!group->error) {
+            group->error = std::current_exception();
+        }
+    }
+    // the group lives on the caller's stack, do not touch it after the last decrement
+    if (group->remaining.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        doneCond_.notify_all();
+    }
+}
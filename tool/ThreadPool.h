@@ -0,0 +1,100 @@
+/***
+ * @Author: Jin Huang @ jin.huang@zju.edu.cn
+ * @Date: 2026-10-18 13:20:16
+ * @LastEditors: Jin Huang @ jin.huang@zju.edu.cn
+ * @LastEditTime: 2026-10-18 13:20:16
+ * @FilePath: /Raspi2USBL/tool/ThreadPool.h
+ * @Description: Small persistent work-stealing thread pool for intra-ping data parallelism
+ * @
+ * @Copyright (c) 2026 by Jin Huang @ jin.huang@zju.edu.cn, All Rights Reserved.
+ */
+
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***
+ * @description: Persistent worker threads, each with its own task deque. A worker pops from the front of its
+ * own deque and steals from the back of the others when it runs dry. parallelFor() blocks the caller, which
+ * also executes tasks while it waits, so nested or concurrent calls (e.g. two pipeline stages) cannot deadlock.
+ * Tasks never reduce into shared state: every index writes its own slot and the caller reduces in a fixed
+ * order afterwards, so results do not depend on the number of workers.
+ */
+class ThreadPool {
+public:
+    /***
+     * @description: Create the pool
+     * @param {int} workerNum   Number of worker threads, 0 runs every parallelFor() serially on the caller
+     * @param {function} onWorkerStart  Called once on each worker thread before it takes tasks (e.g. thread policy)
+     */
+    explicit ThreadPool(int workerNum, const std::function<void(int)> &onWorkerStart = nullptr);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int workerNum() const {
+        return static_cast<int>(workers_.size());
+    }
+
+    std::thread &worker(int index) {
+        return workers_[index];
+    }
+
+    /***
+     * @description: Run func(begin, end) over [first, last) split into chunks of at most grain indices
+     * and wait for all of them. The first exception thrown by a chunk is rethrown here.
+     * @param {int} first   The first index
+     * @param {int} last    One past the last index
+     * @param {int} grain   Max number of indices per chunk
+     * @param {function} func   The chunk body
+     * @return {*}
+     */
+    void parallelFor(int first, int last, int grain, const std::function<void(int, int)> &func);
+
+private:
+    // one parallelFor() call
+    struct TaskGroup {
+        std::atomic<int>   remaining;
+        std::mutex         mutex;
+        std::exception_ptr error;
+    };
+
+    struct Task {
+        TaskGroup                           *group;
+        int                                  begin;
+        int                                  end;
+        const std::function<void(int, int)> *func;
+    };
+
+    struct WorkerQueue {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool popTask(int index, Task &task);
+    bool stealTask(int thief, Task &task);
+    void runTask(Task &task);
+
+    std::function<void(int)>                  onWorkerStart_;
+    std::vector<std::thread>                  workers_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::mutex                                wakeMutex_;
+    std::condition_variable                   wakeCond_;
+    std::condition_variable                   doneCond_;
+    std::atomic<int>                          pending_;
+    std::atomic<unsigned>                     nextQueue_;
+    bool                                      stop_;
+};
+
+#endif // _THREADPOOL_H_